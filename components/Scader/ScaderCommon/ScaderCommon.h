@@ -116,6 +116,12 @@ public:
         return _scaderHostname;
     }
 
+    // System config (e.g. to check another module's settings)
+    const RaftJsonIF& getSysConfig() const
+    {
+        return _sysConfig;
+    }
+
 private:
     // Name
     String _scaderUIName;
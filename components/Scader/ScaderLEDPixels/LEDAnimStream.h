@@ -0,0 +1,279 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// LED Animation Stream
+// Streams pre-rendered LED animation frames from a file using a small read-ahead buffer
+//
+// File format (little-endian) - see scripts/led_anim_pack.py for the encoder
+//   Header (16 bytes): "LEDA", version (u8), flags (u8), fps (u16), numLEDs (u16), reserved (u16), numFrames (u32)
+//   Each frame: type (u8), payloadLen (u16), payload
+//     FRAME_RAW   - numLEDs x RGB
+//     FRAME_RLE   - runs of: count (u8, 1..255), R, G, B
+//     FRAME_DELTA - changes from the previous frame as pairs of: skip (u8), literal count (u8), literal count x RGB
+//   RAW and RLE frames are keyframes (decodable without the previous frame) and are used for seeking
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "RaftCore.h"
+#include "FileSystem.h"
+
+class LEDAnimStream
+{
+public:
+    static constexpr uint32_t HEADER_LEN = 16;
+    static constexpr uint32_t FRAME_HEADER_LEN = 3;
+    static constexpr uint32_t READ_AHEAD_LEN = 1024;
+    enum FrameType : uint8_t
+    {
+        FRAME_RAW = 0,
+        FRAME_RLE = 1,
+        FRAME_DELTA = 2
+    };
+
+    virtual ~LEDAnimStream()
+    {
+        close();
+    }
+
+    // Open file, read header and index the keyframes
+    bool open(const String& fileName)
+    {
+        close();
+        _fileName = fileName;
+        _pFile = fileSystem.fileOpen("", fileName, false, 0);
+        if (!_pFile)
+            return false;
+
+        // Header
+        uint8_t header[HEADER_LEN];
+        if ((readBytes(header, HEADER_LEN) != HEADER_LEN) || (memcmp(header, "LEDA", 4) != 0) || (header[4] != 1))
+        {
+            LOG_W(MODULE_PREFIX, "open %s invalid header", fileName.c_str());
+            close();
+            return false;
+        }
+        _fps = header[6] | (header[7] << 8);
+        _numLEDs = header[8] | (header[9] << 8);
+        _numFrames = header[12] | (header[13] << 8) | (header[14] << 16) | (header[15] << 24);
+        if ((_fps == 0) || (_numLEDs == 0))
+        {
+            close();
+            return false;
+        }
+
+        // Scan frame headers to find the keyframes (payloads are skipped over, not read)
+        _keyFrameIdxs.clear();
+        _keyFrameOffsets.clear();
+        uint32_t offset = HEADER_LEN;
+        for (uint32_t frameIdx = 0; frameIdx < _numFrames; frameIdx++)
+        {
+            uint8_t frameHeader[FRAME_HEADER_LEN];
+            fseek(_pFile, offset, SEEK_SET);
+            if (fileSystem.fileRead(_pFile, frameHeader, FRAME_HEADER_LEN) != FRAME_HEADER_LEN)
+            {
+                _numFrames = frameIdx;
+                break;
+            }
+            if (frameHeader[0] != FRAME_DELTA)
+            {
+                _keyFrameIdxs.push_back(frameIdx);
+                _keyFrameOffsets.push_back(offset);
+            }
+            offset += FRAME_HEADER_LEN + (frameHeader[1] | (frameHeader[2] << 8));
+        }
+
+        // Must have frames and start with a keyframe (deltas need a previous frame)
+        if ((_numFrames == 0) || (_keyFrameIdxs.size() == 0) || (_keyFrameIdxs[0] != 0))
+        {
+            LOG_W(MODULE_PREFIX, "open %s no frames or first frame not a keyframe", fileName.c_str());
+            close();
+            return false;
+        }
+
+        // Frame buffer
+        _frame.assign(_numLEDs * 3, 0);
+        return rewind();
+    }
+
+    // Close file
+    void close()
+    {
+        if (_pFile)
+            fileSystem.fileClose(_pFile, "", _fileName, false);
+        _pFile = nullptr;
+    }
+
+    // Info
+    bool isOpen() const { return _pFile != nullptr; }
+    uint32_t getFPS() const { return _fps; }
+    uint32_t getNumLEDs() const { return _numLEDs; }
+    uint32_t getNumFrames() const { return _numFrames; }
+    uint32_t getNextFrameIdx() const { return _nextFrameIdx; }
+    bool isAtEnd() const { return _nextFrameIdx >= _numFrames; }
+    const uint8_t* getFrameRGB() const { return _frame.data(); }
+
+    // Go back to the first frame
+    bool rewind()
+    {
+        if (!_pFile)
+            return false;
+        seekTo(HEADER_LEN);
+        _nextFrameIdx = 0;
+        return true;
+    }
+
+    // Seek so that the next frame decoded is frameIdx - decodes forward from the nearest keyframe
+    bool seek(uint32_t frameIdx)
+    {
+        if (!_pFile || (_keyFrameIdxs.size() == 0) || (frameIdx >= _numFrames))
+            return false;
+        uint32_t keyIdx = 0;
+        for (uint32_t i = 0; i < _keyFrameIdxs.size(); i++)
+        {
+            if (_keyFrameIdxs[i] > frameIdx)
+                break;
+            keyIdx = i;
+        }
+        seekTo(_keyFrameOffsets[keyIdx]);
+        _nextFrameIdx = _keyFrameIdxs[keyIdx];
+        while (_nextFrameIdx < frameIdx)
+        {
+            if (!decodeNextFrame())
+                return false;
+        }
+        return true;
+    }
+
+    // Decode the next frame into the frame buffer
+    bool decodeNextFrame()
+    {
+        if (!_pFile || isAtEnd())
+            return false;
+        uint8_t frameHeader[FRAME_HEADER_LEN];
+        if (readBytes(frameHeader, FRAME_HEADER_LEN) != FRAME_HEADER_LEN)
+            return false;
+        uint32_t payloadLen = frameHeader[1] | (frameHeader[2] << 8);
+        bool rslt = false;
+        switch (frameHeader[0])
+        {
+            case FRAME_RAW: rslt = decodeRaw(payloadLen); break;
+            case FRAME_RLE: rslt = decodeRLE(payloadLen); break;
+            case FRAME_DELTA: rslt = decodeDelta(payloadLen); break;
+            default: break;
+        }
+        _nextFrameIdx++;
+        return rslt;
+    }
+
+private:
+    // File
+    String _fileName;
+    FILE* _pFile = nullptr;
+
+    // Header info
+    uint32_t _fps = 0;
+    uint32_t _numLEDs = 0;
+    uint32_t _numFrames = 0;
+
+    // Keyframe index (frame number and file offset)
+    std::vector<uint32_t> _keyFrameIdxs;
+    std::vector<uint32_t> _keyFrameOffsets;
+
+    // Current frame (RGB) and next frame to decode
+    std::vector<uint8_t> _frame;
+    uint32_t _nextFrameIdx = 0;
+
+    // Read-ahead buffer
+    uint8_t _readBuf[READ_AHEAD_LEN];
+    uint32_t _readPos = 0;
+    uint32_t _readLen = 0;
+
+    // Debug
+    static constexpr const char* MODULE_PREFIX = "LEDAnimStream";
+
+    void seekTo(uint32_t offset)
+    {
+        fseek(_pFile, offset, SEEK_SET);
+        _readPos = 0;
+        _readLen = 0;
+    }
+
+    uint32_t readBytes(uint8_t* pBuf, uint32_t len)
+    {
+        uint32_t copied = 0;
+        while (copied < len)
+        {
+            if (_readPos >= _readLen)
+            {
+                _readLen = fileSystem.fileRead(_pFile, _readBuf, READ_AHEAD_LEN);
+                _readPos = 0;
+                if (_readLen == 0)
+                    break;
+            }
+            uint32_t toCopy = _readLen - _readPos;
+            if (toCopy > len - copied)
+                toCopy = len - copied;
+            memcpy(pBuf + copied, _readBuf + _readPos, toCopy);
+            _readPos += toCopy;
+            copied += toCopy;
+        }
+        return copied;
+    }
+
+    bool readByte(uint8_t& val)
+    {
+        return readBytes(&val, 1) == 1;
+    }
+
+    bool decodeRaw(uint32_t payloadLen)
+    {
+        if (payloadLen != _frame.size())
+            return false;
+        return readBytes(_frame.data(), payloadLen) == payloadLen;
+    }
+
+    bool decodeRLE(uint32_t payloadLen)
+    {
+        if (payloadLen % 4 != 0)
+            return false;
+        uint32_t pixIdx = 0;
+        uint8_t run[4];
+        for (uint32_t pos = 0; pos + 4 <= payloadLen; pos += 4)
+        {
+            if (readBytes(run, 4) != 4)
+                return false;
+            for (uint32_t i = 0; (i < run[0]) && (pixIdx < _numLEDs); i++, pixIdx++)
+                memcpy(_frame.data() + pixIdx * 3, run + 1, 3);
+        }
+        return pixIdx == _numLEDs;
+    }
+
+    bool decodeDelta(uint32_t payloadLen)
+    {
+        uint32_t pixIdx = 0;
+        uint32_t pos = 0;
+        while (pos + 2 <= payloadLen)
+        {
+            uint8_t skip = 0, count = 0;
+            if (!readByte(skip) || !readByte(count))
+                return false;
+            pos += 2;
+            pixIdx += skip;
+            uint32_t literalLen = count * 3;
+            if ((pixIdx + count > _numLEDs) || (pos + literalLen > payloadLen))
+                return false;
+            if (readBytes(_frame.data() + pixIdx * 3, literalLen) != literalLen)
+                return false;
+            pixIdx += count;
+            pos += literalLen;
+        }
+        return pos == payloadLen;
+    }
+};
@@ -0,0 +1,383 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// LED Bytecode VM
+// Small stack-based interpreter for LED effects that are loaded at runtime rather than compiled in
+//
+// Programs are written as whitespace separated tokens in reverse-polish order and are compiled once into
+// bytecode. A program has an optional "frame:" section (run once per frame) and a "pixel:" section (run once
+// per pixel). Values are 32-bit integers (arithmetic wraps and dividing by 0 gives 0). The stack depth of
+// every instruction is checked at compile time so the execution loop needs no bounds checks and never allocates.
+//
+// Inputs:    i (pixel index), n (number of pixels), t (ms since start), f (frame count),
+//            x y z (LED position in mm), ld0..ld7 (load register)
+// Constants: decimal or 0x hex integers
+// Operators: + - * / % neg abs min max & | ^ << >> < > == sel (c a b -> c ? a : b) clamp (v lo hi)
+//            dup drop swap over sin (phase 0..65535 -> -32767..32767) rnd (0..65535)
+// Outputs:   st0..st7 (store register - persists across frames)
+//            rgb (r g b each 0..255)   hsv (h 0..65535, s 0..255, v 0..255)
+// Comments start with # and run to the end of the line
+//
+// Example (rainbow moving along the strip):
+//   pixel:  i 65536 * n /  t 16 * +  255 128 hsv
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <vector>
+#include "RaftArduino.h"
+
+class LEDBytecodeVM
+{
+public:
+    static constexpr uint32_t MAX_STACK = 16;
+    static constexpr uint32_t NUM_REGS = 8;
+
+    // Inputs to the program
+    struct Context
+    {
+        int32_t i = 0;
+        int32_t n = 0;
+        int32_t t = 0;
+        int32_t f = 0;
+        int32_t x = 0;
+        int32_t y = 0;
+        int32_t z = 0;
+    };
+
+    // Result of running the pixel section
+    enum OutputMode : uint8_t
+    {
+        OUTPUT_NONE,
+        OUTPUT_RGB,
+        OUTPUT_HSV
+    };
+    struct Output
+    {
+        OutputMode mode = OUTPUT_NONE;
+        int32_t a = 0;
+        int32_t b = 0;
+        int32_t c = 0;
+    };
+
+    // Compile program source - returns false (and sets errMsg) if the program is invalid
+    bool compile(const char* pSource, String& errMsg)
+    {
+        _frameCode.clear();
+        _pixelCode.clear();
+        memset(_regs, 0, sizeof(_regs));
+        _isValid = false;
+        if (!pSource)
+        {
+            errMsg = "noSource";
+            return false;
+        }
+
+        // Tokenise
+        std::vector<uint8_t>* pCode = &_pixelCode;
+        int32_t depth = 0;
+        bool outputDone = false;
+        const char* pCur = pSource;
+        char token[16];
+        bool isTooLong = false;
+        while (nextToken(pCur, token, sizeof(token), isTooLong))
+        {
+            // No valid token is longer than the buffer so a truncated one would only mislead
+            if (isTooLong)
+            {
+                errMsg = String("tokenTooLong ") + token;
+                return false;
+            }
+
+            // Section markers
+            if ((strcmp(token, "frame:") == 0) || (strcmp(token, "pixel:") == 0))
+            {
+                if (!checkSectionEnd(pCode, depth, outputDone, errMsg))
+                    return false;
+                pCode = token[0] == 'f' ? &_frameCode : &_pixelCode;
+                pCode->clear();
+                depth = 0;
+                outputDone = false;
+                continue;
+            }
+
+            // Look up token
+            int32_t immediate = 0;
+            uint8_t opcode = lookupToken(token, immediate);
+            if (opcode == OP_INVALID)
+            {
+                errMsg = String("unknownToken ") + token;
+                return false;
+            }
+
+            // Check stack depth
+            const OpInfo& info = OP_INFO[opcode];
+            if (depth < info.pops)
+            {
+                errMsg = String("stackUnderflow ") + token;
+                return false;
+            }
+            depth = depth - info.pops + info.pushes;
+            if (depth > int32_t(MAX_STACK))
+            {
+                errMsg = String("stackOverflow ") + token;
+                return false;
+            }
+            if ((opcode == OP_RGB) || (opcode == OP_HSV))
+            {
+                if ((pCode != &_pixelCode) || outputDone)
+                {
+                    errMsg = String("misplacedOutput ") + token;
+                    return false;
+                }
+                outputDone = true;
+            }
+
+            // Emit
+            pCode->push_back(opcode);
+            if (opcode == OP_PUSH)
+            {
+                uint8_t bytes[4];
+                memcpy(bytes, &immediate, sizeof(bytes));
+                pCode->insert(pCode->end(), bytes, bytes + sizeof(bytes));
+            }
+        }
+        if (!checkSectionEnd(pCode, depth, outputDone, errMsg))
+            return false;
+        _frameCode.push_back(OP_END);
+        _pixelCode.push_back(OP_END);
+        _isValid = true;
+        return true;
+    }
+
+    // Check valid
+    bool isValid() const
+    {
+        return _isValid;
+    }
+
+    // Program size in bytes
+    uint32_t getCodeSize() const
+    {
+        return _frameCode.size() + _pixelCode.size();
+    }
+
+    // Run the frame section
+    void runFrame(const Context& ctx)
+    {
+        Output out;
+        if (_isValid)
+            execute(_frameCode.data(), ctx, out);
+    }
+
+    // Run the pixel section
+    void runPixel(const Context& ctx, Output& out)
+    {
+        out.mode = OUTPUT_NONE;
+        if (_isValid)
+            execute(_pixelCode.data(), ctx, out);
+    }
+
+    // Sine approximation - phase 0..65535 is one cycle, result in -32767..32767
+    static int32_t sin16(int32_t phase)
+    {
+        // Parabolic approximation with a second order correction (max error ~0.2%)
+        int32_t x = int16_t(phase & 0xffff);
+        int32_t absX = x < 0 ? -x : x;
+        int32_t y = (x * (32768 - absX)) >> 13;
+        int32_t absY = y < 0 ? -y : y;
+        y += ((((y * absY) >> 15) - y) * 29) >> 7;
+        return y > 32767 ? 32767 : (y < -32767 ? -32767 : y);
+    }
+
+private:
+    // Opcodes
+    enum Opcode : uint8_t
+    {
+        OP_END, OP_PUSH,
+        OP_I, OP_N, OP_T, OP_F, OP_X, OP_Y, OP_Z,
+        OP_LD0, OP_LD1, OP_LD2, OP_LD3, OP_LD4, OP_LD5, OP_LD6, OP_LD7,
+        OP_ST0, OP_ST1, OP_ST2, OP_ST3, OP_ST4, OP_ST5, OP_ST6, OP_ST7,
+        OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD, OP_NEG, OP_ABS, OP_MIN, OP_MAX,
+        OP_AND, OP_OR, OP_XOR, OP_SHL, OP_SHR, OP_LT, OP_GT, OP_EQ, OP_SEL, OP_CLAMP,
+        OP_DUP, OP_DROP, OP_SWAP, OP_OVER, OP_SIN, OP_RND,
+        OP_RGB, OP_HSV,
+        OP_COUNT,
+        OP_INVALID = 0xff
+    };
+    struct OpInfo
+    {
+        const char* pName;
+        int8_t pops;
+        int8_t pushes;
+    };
+    static constexpr OpInfo OP_INFO[OP_COUNT] = {
+        {"", 0, 0}, {"", 0, 1},
+        {"i", 0, 1}, {"n", 0, 1}, {"t", 0, 1}, {"f", 0, 1}, {"x", 0, 1}, {"y", 0, 1}, {"z", 0, 1},
+        {"ld0", 0, 1}, {"ld1", 0, 1}, {"ld2", 0, 1}, {"ld3", 0, 1}, {"ld4", 0, 1}, {"ld5", 0, 1}, {"ld6", 0, 1}, {"ld7", 0, 1},
+        {"st0", 1, 0}, {"st1", 1, 0}, {"st2", 1, 0}, {"st3", 1, 0}, {"st4", 1, 0}, {"st5", 1, 0}, {"st6", 1, 0}, {"st7", 1, 0},
+        {"+", 2, 1}, {"-", 2, 1}, {"*", 2, 1}, {"/", 2, 1}, {"%", 2, 1}, {"neg", 1, 1}, {"abs", 1, 1}, {"min", 2, 1}, {"max", 2, 1},
+        {"&", 2, 1}, {"|", 2, 1}, {"^", 2, 1}, {"<<", 2, 1}, {">>", 2, 1}, {"<", 2, 1}, {">", 2, 1}, {"==", 2, 1}, {"sel", 3, 1}, {"clamp", 3, 1},
+        {"dup", 1, 2}, {"drop", 1, 0}, {"swap", 2, 2}, {"over", 2, 3}, {"sin", 1, 1}, {"rnd", 0, 1},
+        {"rgb", 3, 0}, {"hsv", 3, 0},
+    };
+
+    // Compiled code
+    std::vector<uint8_t> _frameCode;
+    std::vector<uint8_t> _pixelCode;
+    bool _isValid = false;
+
+    // Registers and random state
+    int32_t _regs[NUM_REGS] = {};
+    uint32_t _rndState = 0x12345678;
+
+    static bool nextToken(const char*& pCur, char* pToken, uint32_t maxLen, bool& isTooLong)
+    {
+        // Skip whitespace and comments
+        while (*pCur)
+        {
+            if (*pCur == '#')
+            {
+                while (*pCur && (*pCur != '\n'))
+                    pCur++;
+            }
+            else if ((*pCur == ' ') || (*pCur == '\t') || (*pCur == '\r') || (*pCur == '\n') || (*pCur == ','))
+            {
+                pCur++;
+            }
+            else
+            {
+                break;
+            }
+        }
+        if (!*pCur)
+            return false;
+
+        // Copy token
+        uint32_t len = 0;
+        isTooLong = false;
+        while (*pCur && (*pCur != ' ') && (*pCur != '\t') && (*pCur != '\r') && (*pCur != '\n') && (*pCur != ','))
+        {
+            if (len < maxLen - 1)
+                pToken[len++] = *pCur;
+            else
+                isTooLong = true;
+            pCur++;
+        }
+        pToken[len] = 0;
+        return true;
+    }
+
+    static uint8_t lookupToken(const char* pToken, int32_t& immediate)
+    {
+        // Numeric constant - decimal (a leading 0 is not octal) or hex with a 0x prefix, in the int32 range
+        // except that hex can give the full 32 bits (e.g. colours)
+        if (isdigit((unsigned char)pToken[0]) || ((pToken[0] == '-') && isdigit((unsigned char)pToken[1])))
+        {
+            const char* pDigits = pToken[0] == '-' ? pToken + 1 : pToken;
+            bool isHex = (pDigits[0] == '0') && ((pDigits[1] == 'x') || (pDigits[1] == 'X'));
+            char* pEnd = nullptr;
+            long long val = strtoll(pToken, &pEnd, isHex ? 16 : 10);
+            if ((pEnd == pToken) || (*pEnd != 0) || (val < INT32_MIN) || (val > (isHex ? (long long)UINT32_MAX : INT32_MAX)))
+                return OP_INVALID;
+            immediate = int32_t(uint32_t(val));
+            return OP_PUSH;
+        }
+        for (uint32_t op = OP_I; op < OP_COUNT; op++)
+        {
+            if (strcmp(pToken, OP_INFO[op].pName) == 0)
+                return op;
+        }
+        return OP_INVALID;
+    }
+
+    bool checkSectionEnd(std::vector<uint8_t>* pCode, int32_t depth, bool outputDone, String& errMsg)
+    {
+        if (depth != 0)
+        {
+            errMsg = String("unbalancedStack ") + String(depth);
+            return false;
+        }
+        if ((pCode == &_pixelCode) && !outputDone && !pCode->empty())
+        {
+            errMsg = "noPixelOutput";
+            return false;
+        }
+        return true;
+    }
+
+    // Execute - stack depth was validated at compile time
+    void execute(const uint8_t* pCode, const Context& ctx, Output& out)
+    {
+        int32_t stack[MAX_STACK + 1];
+        int32_t* sp = stack;
+        while (true)
+        {
+            uint8_t op = *pCode++;
+            switch (op)
+            {
+                case OP_END: return;
+                case OP_PUSH: memcpy(sp++, pCode, sizeof(int32_t)); pCode += sizeof(int32_t); break;
+                case OP_I: *sp++ = ctx.i; break;
+                case OP_N: *sp++ = ctx.n; break;
+                case OP_T: *sp++ = ctx.t; break;
+                case OP_F: *sp++ = ctx.f; break;
+                case OP_X: *sp++ = ctx.x; break;
+                case OP_Y: *sp++ = ctx.y; break;
+                case OP_Z: *sp++ = ctx.z; break;
+                case OP_LD0: case OP_LD1: case OP_LD2: case OP_LD3:
+                case OP_LD4: case OP_LD5: case OP_LD6: case OP_LD7:
+                    *sp++ = _regs[op - OP_LD0]; break;
+                case OP_ST0: case OP_ST1: case OP_ST2: case OP_ST3:
+                case OP_ST4: case OP_ST5: case OP_ST6: case OP_ST7:
+                    _regs[op - OP_ST0] = *--sp; break;
+                // Arithmetic wraps (done unsigned as programs are uploaded and signed overflow is undefined)
+                // and a -1 divisor is handled separately as INT32_MIN / -1 overflows
+                case OP_ADD: sp--; sp[-1] = int32_t(uint32_t(sp[-1]) + uint32_t(sp[0])); break;
+                case OP_SUB: sp--; sp[-1] = int32_t(uint32_t(sp[-1]) - uint32_t(sp[0])); break;
+                case OP_MUL: sp--; sp[-1] = int32_t(uint32_t(sp[-1]) * uint32_t(sp[0])); break;
+                case OP_DIV: sp--; sp[-1] = sp[0] == 0 ? 0 : (sp[0] == -1 ? int32_t(0u - uint32_t(sp[-1])) : sp[-1] / sp[0]); break;
+                case OP_MOD: sp--; sp[-1] = (sp[0] == 0) || (sp[0] == -1) ? 0 : sp[-1] % sp[0]; break;
+                case OP_NEG: sp[-1] = int32_t(0u - uint32_t(sp[-1])); break;
+                case OP_ABS: sp[-1] = sp[-1] < 0 ? int32_t(0u - uint32_t(sp[-1])) : sp[-1]; break;
+                case OP_MIN: sp--; sp[-1] = sp[0] < sp[-1] ? sp[0] : sp[-1]; break;
+                case OP_MAX: sp--; sp[-1] = sp[0] > sp[-1] ? sp[0] : sp[-1]; break;
+                case OP_AND: sp--; sp[-1] &= sp[0]; break;
+                case OP_OR: sp--; sp[-1] |= sp[0]; break;
+                case OP_XOR: sp--; sp[-1] ^= sp[0]; break;
+                case OP_SHL: sp--; sp[-1] = uint32_t(sp[-1]) << (sp[0] & 31); break;
+                case OP_SHR: sp--; sp[-1] >>= (sp[0] & 31); break;
+                case OP_LT: sp--; sp[-1] = sp[-1] < sp[0]; break;
+                case OP_GT: sp--; sp[-1] = sp[-1] > sp[0]; break;
+                case OP_EQ: sp--; sp[-1] = sp[-1] == sp[0]; break;
+                case OP_SEL: sp -= 2; sp[-1] = sp[-1] ? sp[0] : sp[1]; break;
+                case OP_CLAMP: sp -= 2; sp[-1] = sp[-1] < sp[0] ? sp[0] : (sp[-1] > sp[1] ? sp[1] : sp[-1]); break;
+                case OP_DUP: sp[0] = sp[-1]; sp++; break;
+                case OP_DROP: sp--; break;
+                case OP_SWAP: { int32_t tmp = sp[-1]; sp[-1] = sp[-2]; sp[-2] = tmp; break; }
+                case OP_OVER: sp[0] = sp[-2]; sp++; break;
+                case OP_SIN: sp[-1] = sin16(sp[-1]); break;
+                case OP_RND:
+                    _rndState ^= _rndState << 13;
+                    _rndState ^= _rndState >> 17;
+                    _rndState ^= _rndState << 5;
+                    *sp++ = _rndState & 0xffff;
+                    break;
+                case OP_RGB:
+                case OP_HSV:
+                    sp -= 3;
+                    out.mode = op == OP_RGB ? OUTPUT_RGB : OUTPUT_HSV;
+                    out.a = sp[0];
+                    out.b = sp[1];
+                    out.c = sp[2];
+                    break;
+                default: return;
+            }
+        }
+    }
+};
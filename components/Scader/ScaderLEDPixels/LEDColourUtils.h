@@ -0,0 +1,69 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// LEDColourUtils
+// Integer-only colour conversion for LED patterns
+//
+// hsvToRGB takes a 16-bit hue (0..65535 is one turn of the colour wheel) and 8-bit saturation and value. It
+// uses no divisions (the /255 steps are shifts, exact for all 8-bit x 8-bit products) and selects the
+// output channel ordering for each sixth of the wheel from a table rather than a switch.
+//
+// setHSVRange fills a run of pixels with a hue ramp - the hue step is added per pixel so rainbow style
+// patterns avoid a per-pixel division when spreading the wheel across the strip.
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include "LEDPixelIF.h"
+
+namespace LEDColourUtils
+{
+    // x / 255 (exact for 0 <= x < 65535 which covers all 8-bit x 8-bit products)
+    static inline uint32_t div255(uint32_t x)
+    {
+        return (x + 1 + (x >> 8)) >> 8;
+    }
+
+    // HSV to RGB - hue 0..65535, sat and val 0..255
+    static inline void hsvToRGB(uint16_t hue, uint8_t sat, uint8_t val, uint8_t& r, uint8_t& g, uint8_t& b)
+    {
+        // Sector of the wheel (0..5) and position within it (0..255)
+        uint32_t hue6 = uint32_t(hue) * 6;
+        uint32_t sector = hue6 >> 16;
+        uint32_t frac = (hue6 >> 8) & 0xff;
+
+        // Levels: 0 = val, 1 = falling (q), 2 = rising (t), 3 = floor (p)
+        uint8_t levels[4];
+        levels[0] = val;
+        levels[1] = div255(val * (255 - div255(sat * frac)));
+        levels[2] = div255(val * (255 - div255(sat * (255 - frac))));
+        levels[3] = div255(val * (255 - sat));
+
+        // Level used for R, G and B in each sector
+        static const uint8_t SECTOR_LEVELS[6][3] = {
+            { 0, 2, 3 }, { 1, 0, 3 }, { 3, 0, 2 }, { 3, 1, 0 }, { 2, 3, 0 }, { 0, 3, 1 }
+        };
+        const uint8_t* pSector = SECTOR_LEVELS[sector];
+        r = levels[pSector[0]];
+        g = levels[pSector[1]];
+        b = levels[pSector[2]];
+    }
+
+    // Fill count pixels (every stride pixels from start) with hues from hueStart advancing by hueStep
+    static inline void setHSVRange(LEDPixelIF& pixels, uint32_t start, uint32_t count, uint16_t hueStart,
+                int32_t hueStep, uint8_t sat, uint8_t val, uint32_t stride = 1)
+    {
+        uint32_t numPixels = pixels.getNumPixels();
+        uint32_t hue = hueStart;
+        uint8_t r = 0, g = 0, b = 0;
+        for (uint32_t i = 0, pixIdx = start; (i < count) && (pixIdx < numPixels); i++, pixIdx += stride)
+        {
+            hsvToRGB(hue, sat, val, r, g, b);
+            pixels.setRGB(pixIdx, r, g, b);
+            hue += hueStep;
+        }
+    }
+}
@@ -0,0 +1,180 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// LEDFrameScheduler
+// Fixed timeline frame pacing for LED patterns
+//
+// Each frame deadline is the previous deadline plus the period (rather than the time the last frame actually
+// ran plus the period) so loop latency doesn't accumulate as drift. When frames are missed the policy decides
+// whether to skip them (the timeline jumps forward and the frame delta covers the gap) or catch up (frames are
+// due back to back until the timeline is reached, up to a limit after which the timeline restarts).
+//
+// Frame time and delta are timeline values so animation speed is independent of loop jitter. Frames running
+// more than half a period late are counted and reported (rate limited) in the log.
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include "RaftCore.h"
+
+class LEDFrameScheduler
+{
+public:
+    enum Policy
+    {
+        POLICY_SKIP,
+        POLICY_CATCH_UP
+    };
+
+    // Start the timeline from now
+    void start(uint32_t periodMs, Policy policy = POLICY_SKIP, uint32_t maxCatchUpFrames = DEFAULT_MAX_CATCH_UP_FRAMES)
+    {
+        startUs((periodMs > 0 ? periodMs : 1) * 1000, policy, maxCatchUpFrames);
+    }
+
+    // Start the timeline from now with the period in us (e.g. for a frame rate that isn't a whole number of ms)
+    void startUs(uint32_t periodUs, Policy policy = POLICY_SKIP, uint32_t maxCatchUpFrames = DEFAULT_MAX_CATCH_UP_FRAMES)
+    {
+        _periodUs = periodUs > 0 ? periodUs : 1;
+        _policy = policy;
+        _maxCatchUpFrames = maxCatchUpFrames;
+        _startUs = micros();
+        _nextDeadlineUs = _startUs;
+        _frameTimeUs = 0;
+        _frameDeltaUs = 0;
+        _frameCount = 0;
+        _lateFrames = 0;
+        _skippedFrames = 0;
+        _maxLatenessUs = 0;
+        _lastReportMs = millis();
+        _lateFramesReported = 0;
+    }
+
+    // Change period without restarting the timeline
+    void setPeriodMs(uint32_t periodMs)
+    {
+        _periodUs = (periodMs > 0 ? periodMs : 1) * 1000;
+    }
+    uint32_t getPeriodMs() const
+    {
+        return _periodUs / 1000;
+    }
+
+    // Check if a frame is due - if so the frame time and delta are updated and the timeline advanced
+    bool isFrameDue()
+    {
+        uint32_t nowUs = micros();
+        int32_t latenessUs = int32_t(nowUs - _nextDeadlineUs);
+        if (latenessUs < 0)
+            return false;
+
+        // Lateness stats
+        if (uint32_t(latenessUs) > _maxLatenessUs)
+            _maxLatenessUs = latenessUs;
+        if (uint32_t(latenessUs) > _periodUs / 2)
+            _lateFrames++;
+
+        // Advance the timeline
+        uint32_t framesMissed = latenessUs / _periodUs;
+        uint32_t framesAdvanced = 1;
+        if (_policy == POLICY_SKIP)
+        {
+            framesAdvanced += framesMissed;
+            _skippedFrames += framesMissed;
+        }
+        else if (framesMissed > _maxCatchUpFrames)
+        {
+            // Too far behind to catch up - restart the timeline from now
+            _skippedFrames += framesMissed;
+            _frameTimeUs += (framesMissed + 1) * uint64_t(_periodUs);
+            _frameDeltaUs = (framesMissed + 1) * _periodUs;
+            _nextDeadlineUs = nowUs + _periodUs;
+            _frameCount++;
+            reportLateFrames();
+            return true;
+        }
+        _frameDeltaUs = (_frameCount == 0) ? 0 : framesAdvanced * _periodUs;
+        _frameTimeUs += _frameDeltaUs;
+        _nextDeadlineUs += framesAdvanced * _periodUs;
+        _frameCount++;
+        reportLateFrames();
+        return true;
+    }
+
+    // Timeline time of the current frame since start and time since the previous frame
+    uint32_t getFrameTimeMs() const
+    {
+        return _frameTimeUs / 1000;
+    }
+    uint64_t getFrameTimeUs() const
+    {
+        return _frameTimeUs;
+    }
+    uint32_t getFrameDeltaMs() const
+    {
+        return _frameDeltaUs / 1000;
+    }
+    uint32_t getFrameDeltaUs() const
+    {
+        return _frameDeltaUs;
+    }
+
+    // Stats
+    uint32_t getFrameCount() const
+    {
+        return _frameCount;
+    }
+    uint32_t getLateFrames() const
+    {
+        return _lateFrames;
+    }
+    uint32_t getSkippedFrames() const
+    {
+        return _skippedFrames;
+    }
+    uint32_t getMaxLatenessUs() const
+    {
+        return _maxLatenessUs;
+    }
+
+private:
+    // Timeline
+    uint32_t _periodUs = 30000;
+    Policy _policy = POLICY_SKIP;
+    uint32_t _maxCatchUpFrames = DEFAULT_MAX_CATCH_UP_FRAMES;
+    uint32_t _startUs = 0;
+    uint32_t _nextDeadlineUs = 0;
+
+    // Current frame
+    uint64_t _frameTimeUs = 0;
+    uint32_t _frameDeltaUs = 0;
+
+    // Stats
+    uint32_t _frameCount = 0;
+    uint32_t _lateFrames = 0;
+    uint32_t _skippedFrames = 0;
+    uint32_t _maxLatenessUs = 0;
+    uint32_t _lastReportMs = 0;
+    uint32_t _lateFramesReported = 0;
+
+    // Consts
+    static const uint32_t DEFAULT_MAX_CATCH_UP_FRAMES = 3;
+    static const uint32_t LATE_REPORT_INTERVAL_MS = 10000;
+
+    // Debug
+    static constexpr const char *MODULE_PREFIX = "LEDFrameSched";
+
+    void reportLateFrames()
+    {
+        if ((_lateFrames == _lateFramesReported) || !Raft::isTimeout(millis(), _lastReportMs, LATE_REPORT_INTERVAL_MS))
+            return;
+        _lastReportMs = millis();
+        LOG_W(MODULE_PREFIX, "late frames %d (+%d) of %d skipped %d maxLatenessUs %d periodMs %d",
+                _lateFrames, _lateFrames - _lateFramesReported, _frameCount, _skippedFrames,
+                _maxLatenessUs, _periodUs / 1000);
+        _lateFramesReported = _lateFrames;
+    }
+};
@@ -0,0 +1,98 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// LEDNoise3D
+// Fixed-point 3D gradient (Perlin) noise
+//
+// Coordinates are 16.16 fixed point (the top 16 bits select the lattice cell and the low 16 bits are the
+// position within it) and the noise repeats every 256 cells so coordinates can simply wrap. Lattice hashing
+// uses the standard 256 entry permutation table and the 12 cube edge gradients, interpolated with a
+// smoothstep fade - all in 32-bit integer arithmetic with no tables built at runtime.
+//
+// Output is signed 16-bit - most values fall within +/- 16000 with occasional peaks near +/- 32000
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+class LEDNoise3D
+{
+public:
+    static int32_t noise(uint32_t x, uint32_t y, uint32_t z)
+    {
+        // Lattice cell
+        uint8_t cellX = x >> 16;
+        uint8_t cellY = y >> 16;
+        uint8_t cellZ = z >> 16;
+
+        // Position in cell (0..16383) and faded interpolation weights (0..32767) - sized so that the
+        // interpolation products fit in 32 bits
+        int32_t fx = (x & 0xffff) >> 2;
+        int32_t fy = (y & 0xffff) >> 2;
+        int32_t fz = (z & 0xffff) >> 2;
+        int32_t u = fade(x & 0xffff);
+        int32_t v = fade(y & 0xffff);
+        int32_t w = fade(z & 0xffff);
+
+        // Hash the cell corners
+        uint8_t a = perm(cellX) + cellY;
+        uint8_t aa = perm(a) + cellZ;
+        uint8_t ab = perm(uint8_t(a + 1)) + cellZ;
+        uint8_t b = perm(uint8_t(cellX + 1)) + cellY;
+        uint8_t ba = perm(b) + cellZ;
+        uint8_t bb = perm(uint8_t(b + 1)) + cellZ;
+
+        // Blend the corner gradients
+        const int32_t ONE = 16384;
+        int32_t x1 = lerp(grad(perm(aa), fx, fy, fz), grad(perm(ba), fx - ONE, fy, fz), u);
+        int32_t x2 = lerp(grad(perm(ab), fx, fy - ONE, fz), grad(perm(bb), fx - ONE, fy - ONE, fz), u);
+        int32_t y1 = lerp(x1, x2, v);
+        x1 = lerp(grad(perm(uint8_t(aa + 1)), fx, fy, fz - ONE), grad(perm(uint8_t(ba + 1)), fx - ONE, fy, fz - ONE), u);
+        x2 = lerp(grad(perm(uint8_t(ab + 1)), fx, fy - ONE, fz - ONE), grad(perm(uint8_t(bb + 1)), fx - ONE, fy - ONE, fz - ONE), u);
+        int32_t y2 = lerp(x1, x2, v);
+        return lerp(y1, y2, w) * 2;
+    }
+
+private:
+    static uint8_t perm(uint8_t idx)
+    {
+        static const uint8_t PERMUTATION[256] = {
+            151,160,137,91,90,15,131,13,201,95,96,53,194,233,7,225,140,36,103,30,69,142,8,99,37,240,21,10,23,
+            190,6,148,247,120,234,75,0,26,197,62,94,252,219,203,117,35,11,32,57,177,33,88,237,149,56,87,174,20,
+            125,136,171,168,68,175,74,165,71,134,139,48,27,166,77,146,158,231,83,111,229,122,60,211,133,230,220,
+            105,92,41,55,46,245,40,244,102,143,54,65,25,63,161,1,216,80,73,209,76,132,187,208,89,18,169,200,196,
+            135,130,116,188,159,86,164,100,109,198,173,186,3,64,52,217,226,250,124,123,5,202,38,147,118,126,255,
+            82,85,212,207,206,59,227,47,16,58,17,182,189,28,42,223,183,170,213,119,248,152,2,44,154,163,70,221,
+            153,101,155,167,43,172,9,129,22,39,253,19,98,108,110,79,113,224,232,178,185,112,104,218,246,97,228,
+            251,34,242,193,238,210,144,12,191,179,162,241,81,51,145,235,249,14,239,107,49,192,214,31,181,199,
+            106,157,184,84,204,176,115,121,50,45,127,4,150,254,138,236,205,93,222,114,67,29,24,72,243,141,128,
+            195,78,66,215,61,156,180
+        };
+        return PERMUTATION[idx];
+    }
+
+    // Smoothstep 3t^2 - 2t^3 for t in 0..65535 (result 0..32767)
+    static int32_t fade(uint32_t t)
+    {
+        uint32_t t2 = (t * t) >> 16;
+        uint32_t t3 = (t2 * t) >> 16;
+        return (3 * t2 - 2 * t3) >> 1;
+    }
+
+    static int32_t lerp(int32_t a, int32_t b, int32_t t)
+    {
+        return a + (((b - a) * t) >> 15);
+    }
+
+    // Dot product with one of the 12 cube edge gradients
+    static int32_t grad(uint8_t hash, int32_t x, int32_t y, int32_t z)
+    {
+        uint8_t h = hash & 15;
+        int32_t u = h < 8 ? x : y;
+        int32_t v = h < 4 ? y : ((h == 12) || (h == 14) ? x : z);
+        return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
+    }
+};
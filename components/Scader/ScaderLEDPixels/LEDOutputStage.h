@@ -0,0 +1,137 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// LED Output Stage
+// Converts 16-bit per channel pattern output to 8-bit LED values using a gamma LUT and temporal dithering
+//
+// Patterns render into the stage in a perceptually linear 16-bit colour space. On render the stage maps each
+// channel through a precomputed gamma/brightness LUT (8.8 fixed point result) and then adds the fractional
+// part left over from the previous frame before truncating to 8 bits. Over a few frames the average output
+// level then tracks the 16-bit value so low brightness fades don't collapse to a handful of visible steps.
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+#include "RaftCore.h"
+
+class LEDOutputStage
+{
+public:
+    // Setup
+    // gamma of 1.0 gives a linear mapping, brightnessPC scales the output (applied in 16-bit space)
+    void setup(uint32_t numPixels, float gamma, float brightnessPC, bool dither)
+    {
+        _numPixels = numPixels;
+        _dither = dither;
+        _linear.assign(numPixels * 3, 0);
+        _residual.assign(numPixels * 3, 0);
+        buildLUT(gamma, brightnessPC);
+    }
+
+    // Number of pixels
+    uint32_t getNumPixels() const
+    {
+        return _numPixels;
+    }
+
+    // Set pixel value (16 bits per channel)
+    void setRGB16(uint32_t idx, uint16_t r, uint16_t g, uint16_t b)
+    {
+        if (idx >= _numPixels)
+            return;
+        uint16_t* pPix = _linear.data() + idx * 3;
+        pPix[0] = r;
+        pPix[1] = g;
+        pPix[2] = b;
+    }
+
+    // Set pixel value from 8-bit channels
+    void setRGB(uint32_t idx, uint8_t r, uint8_t g, uint8_t b)
+    {
+        setRGB16(idx, r * 257, g * 257, b * 257);
+    }
+
+    // Clear all pixels
+    void clear()
+    {
+        std::fill(_linear.begin(), _linear.end(), 0);
+    }
+
+    // Render to pixels - gamma, brightness and dithering are applied in a single pass
+    // Brightness is normally handled here so the pixels are written without further scaling - applyBrightness
+    // lets the strip scale them when its brightness isn't known (this re-quantises the dithered values)
+    void render(LEDPixelIF& pixels, bool applyBrightness = false)
+    {
+        uint32_t numPix = _numPixels < pixels.getNumPixels() ? _numPixels : pixels.getNumPixels();
+        const uint16_t* pLin = _linear.data();
+        uint8_t* pRes = _residual.data();
+        for (uint32_t i = 0; i < numPix; i++)
+        {
+            uint8_t r = quantise(applyLUT(pLin[0]), pRes[0]);
+            uint8_t g = quantise(applyLUT(pLin[1]), pRes[1]);
+            uint8_t b = quantise(applyLUT(pLin[2]), pRes[2]);
+            pixels.setRGB(i, r, g, b, applyBrightness);
+            pLin += 3;
+            pRes += 3;
+        }
+    }
+
+private:
+    // LUT has 256 segments indexed by the top byte of the 16-bit value with linear interpolation
+    // on the low byte - output is 8.8 fixed point
+    static constexpr uint32_t LUT_SEGMENTS = 256;
+    uint16_t _gammaLUT[LUT_SEGMENTS + 1] = {};
+
+    // Pixel data (RGB interleaved, 16 bits per channel) and dither residuals (fractional part of 8.8 output)
+    uint32_t _numPixels = 0;
+    std::vector<uint16_t> _linear;
+    std::vector<uint8_t> _residual;
+    bool _dither = true;
+
+    void buildLUT(float gamma, float brightnessPC)
+    {
+        if (gamma <= 0)
+            gamma = 1.0f;
+        if (brightnessPC < 0)
+            brightnessPC = 0;
+        if (brightnessPC > 100)
+            brightnessPC = 100;
+        float scale = 65535.0f * brightnessPC / 100.0f;
+        for (uint32_t i = 0; i <= LUT_SEGMENTS; i++)
+        {
+            float val = powf(float(i) / LUT_SEGMENTS, gamma) * scale + 0.5f;
+            _gammaLUT[i] = val > 65535.0f ? 65535 : uint16_t(val);
+        }
+    }
+
+    inline uint16_t applyLUT(uint16_t val) const
+    {
+        uint32_t idx = val >> 8;
+        uint32_t frac = val & 0xff;
+        uint32_t lo = _gammaLUT[idx];
+        uint32_t hi = _gammaLUT[idx + 1];
+        return lo + (((hi - lo) * frac) >> 8);
+    }
+
+    inline uint8_t quantise(uint32_t val88, uint8_t& residual) const
+    {
+        if (!_dither)
+        {
+            val88 += 0x80;
+            return val88 > 0xffff ? 0xff : val88 >> 8;
+        }
+        val88 += residual;
+        if (val88 > 0xffff)
+        {
+            residual = 0;
+            return 0xff;
+        }
+        residual = val88 & 0xff;
+        return val88 >> 8;
+    }
+};
@@ -6,6 +6,8 @@
 #pragma once
 
 #include "RaftCore.h"
+#include "LEDOutputStage.h"
+#include "LEDFrameScheduler.h"
 #include <cmath>
 
 class LEDPatternFire : public LEDPatternBase
@@ -34,7 +36,14 @@ public:
             _flameSpeed = paramsJson.getDouble("flameSpeed", 600.0);
             _jetSpeed = paramsJson.getDouble("jetSpeed", 1500.0);
             _jetSpawnRate = paramsJson.getDouble("jetSpawnRate", 3.0);
+
+            // Dithered output
+            _ditherEnabled = paramsJson.getLong("dither", 0) != 0;
+            _gamma = paramsJson.getDouble("gamma", 1.0);
         }
+        if (_ditherEnabled)
+            _outputStage.setup(NUM_LEDS, _gamma, _stripBrightnessSet ? _stripBrightnessPC : 100, true);
+        _scheduler.start(_refreshRateMs);
         
         // Initialize flame tongues
         for (uint32_t i = 0; i < NUM_FLAMES; i++)
@@ -56,20 +65,25 @@ public:
         }
     }
     
+    // Strip brightness (call before setup) - when dithering it is folded into the output stage LUT as scaling
+    // the dithered values in the strip would re-quantise them (if not set the strip scales the output)
+    void setStripBrightness(float stripBrightnessPC)
+    {
+        _stripBrightnessPC = stripBrightnessPC;
+        _stripBrightnessSet = true;
+    }
+
     virtual void loop() override final
     {
-        if (!Raft::isTimeout(millis(), _lastLoopMs, _refreshRateMs))
+        if (!_scheduler.isFrameDue())
             return;
         
-        uint32_t currentMs = millis();
-        float dt = (currentMs - _lastLoopMs) / 1000.0f;
-        float elapsed = currentMs / 1000.0f;
-        _lastLoopMs = currentMs;
+        float dt = _scheduler.getFrameDeltaUs() / 1000000.0f;
+        float elapsed = _scheduler.getFrameTimeUs() / 1000000.0f;
         
-        // Update animation
-        updateBaseFireEdge(elapsed, dt);
-        updateFlames(elapsed, dt);
-        updateJets(elapsed, dt);
+        // Update animation (the base fire edge is computed per-LED during render)
+        updateFlames(dt);
+        updateJets(dt);
         
         // Render to pixels
         renderToPixels(elapsed);
@@ -129,7 +143,7 @@ private:
     };
     
     // Runtime state
-    uint32_t _lastLoopMs = 0;
+    LEDFrameScheduler _scheduler;
     float _maxBrightnessPC = 100.0f;
     float _baseHeightMm = 800.0f;
     float _flameSpeed = 600.0f;
@@ -154,10 +168,17 @@ private:
     float _jetYOffset[NUM_JETS];
     float _jetBrightness[NUM_JETS];
     
-    // LED color buffer (R, G, B as 0-255)
-    uint8_t _ledR[NUM_LEDS] = {};
-    uint8_t _ledG[NUM_LEDS] = {};
-    uint8_t _ledB[NUM_LEDS] = {};
+    // LED color buffer (R, G, B as 0-65535)
+    uint16_t _ledR[NUM_LEDS] = {};
+    uint16_t _ledG[NUM_LEDS] = {};
+    uint16_t _ledB[NUM_LEDS] = {};
+
+    // Output stage (used when dithering)
+    bool _ditherEnabled = false;
+    float _gamma = 1.0f;
+    float _stripBrightnessPC = 100.0f;
+    bool _stripBrightnessSet = false;
+    LEDOutputStage _outputStage;
     
     // Helper: random float in range [0, max]
     float random(float max) {
@@ -169,18 +190,12 @@ private:
         return v < min ? min : (v > max ? max : v);
     }
     
-    // Helper: max of two uint8_t
-    uint8_t maxU8(uint8_t a, uint8_t b) {
+    // Helper: max of two uint16_t
+    uint16_t maxU16(uint16_t a, uint16_t b) {
         return a > b ? a : b;
     }
     
-    void updateBaseFireEdge(float elapsed, float dt)
-    {
-        // Base fire edge will be computed per-LED during render
-        // This keeps the code simpler and avoids storing per-LED edge heights
-    }
-    
-    void updateFlames(float elapsed, float dt)
+    void updateFlames(float dt)
     {
         float distance = dt * _flameSpeed;
         
@@ -221,7 +236,7 @@ private:
         }
     }
     
-    void updateJets(float elapsed, float dt)
+    void updateJets(float dt)
     {
         // Spawn new jets
         if (random(1.0f) < _jetSpawnRate * dt)
@@ -288,9 +303,9 @@ private:
                 if (heightAboveMin < _baseHeightMm * 0.7f)
                 {
                     // Core - full brightness
-                    _ledR[i] = (uint8_t)(LED_BASE_COLOR_R[i] * flicker * _maxBrightnessPC / 100.0f);
-                    _ledG[i] = (uint8_t)(LED_BASE_COLOR_G[i] * flicker * _maxBrightnessPC / 100.0f);
-                    _ledB[i] = (uint8_t)(LED_BASE_COLOR_B[i] * flicker * _maxBrightnessPC / 100.0f);
+                    _ledR[i] = (uint16_t)(LED_BASE_COLOR_R[i] * 257 * flicker * _maxBrightnessPC / 100.0f);
+                    _ledG[i] = (uint16_t)(LED_BASE_COLOR_G[i] * 257 * flicker * _maxBrightnessPC / 100.0f);
+                    _ledB[i] = (uint16_t)(LED_BASE_COLOR_B[i] * 257 * flicker * _maxBrightnessPC / 100.0f);
                 }
                 else
                 {
@@ -300,9 +315,9 @@ private:
                     flicker *= edgeIntensity;
                     flicker = clamp(flicker, 0.5f, 1.0f);
                     
-                    _ledR[i] = (uint8_t)(LED_BASE_COLOR_R[i] * flicker * _maxBrightnessPC / 100.0f);
-                    _ledG[i] = (uint8_t)(LED_BASE_COLOR_G[i] * flicker * _maxBrightnessPC / 100.0f);
-                    _ledB[i] = (uint8_t)(LED_BASE_COLOR_B[i] * flicker * _maxBrightnessPC / 100.0f);
+                    _ledR[i] = (uint16_t)(LED_BASE_COLOR_R[i] * 257 * flicker * _maxBrightnessPC / 100.0f);
+                    _ledG[i] = (uint16_t)(LED_BASE_COLOR_G[i] * 257 * flicker * _maxBrightnessPC / 100.0f);
+                    _ledB[i] = (uint16_t)(LED_BASE_COLOR_B[i] * 257 * flicker * _maxBrightnessPC / 100.0f);
                 }
             }
         }
@@ -314,9 +329,16 @@ private:
         renderJets(elapsed);
         
         // Write to pixel buffer
+        if (_ditherEnabled)
+        {
+            for (uint32_t i = 0; i < NUM_LEDS; i++)
+                _outputStage.setRGB16(i, _ledR[i], _ledG[i], _ledB[i]);
+            _outputStage.render(_pixels, !_stripBrightnessSet);
+            return;
+        }
         for (uint32_t i = 0; i < NUM_LEDS; i++)
         {
-            _pixels.setRGB(i, _ledR[i], _ledG[i], _ledB[i]);
+            _pixels.setRGB(i, _ledR[i] >> 8, _ledG[i] >> 8, _ledB[i] >> 8);
         }
     }
     
@@ -382,9 +404,9 @@ private:
                 }
                 
                 float finalIntensity = intensity * flicker * _maxBrightnessPC / 100.0f;
-                _ledR[i] = maxU8(_ledR[i], (uint8_t)(r * finalIntensity));
-                _ledG[i] = maxU8(_ledG[i], (uint8_t)(g * finalIntensity));
-                _ledB[i] = maxU8(_ledB[i], (uint8_t)(b * finalIntensity));
+                _ledR[i] = maxU16(_ledR[i], (uint16_t)(r * 257 * finalIntensity));
+                _ledG[i] = maxU16(_ledG[i], (uint16_t)(g * 257 * finalIntensity));
+                _ledB[i] = maxU16(_ledB[i], (uint16_t)(b * 257 * finalIntensity));
             }
         }
     }
@@ -435,9 +457,9 @@ private:
                     color = JET_COLORS[2];  // Orange base
                 
                 float finalIntensity = intensity * flicker * _maxBrightnessPC / 100.0f;
-                _ledR[i] = maxU8(_ledR[i], (uint8_t)(color[0] * finalIntensity));
-                _ledG[i] = maxU8(_ledG[i], (uint8_t)(color[1] * finalIntensity));
-                _ledB[i] = maxU8(_ledB[i], (uint8_t)(color[2] * finalIntensity));
+                _ledR[i] = maxU16(_ledR[i], (uint16_t)(color[0] * 257 * finalIntensity));
+                _ledG[i] = maxU16(_ledG[i], (uint16_t)(color[1] * 257 * finalIntensity));
+                _ledB[i] = maxU16(_ledB[i], (uint16_t)(color[2] * 257 * finalIntensity));
             }
         }
     }
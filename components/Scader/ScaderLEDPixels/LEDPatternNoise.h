@@ -0,0 +1,200 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// LED Pattern Noise
+// Samples 3D gradient noise (LEDNoise3D) at each LED's physical position and maps it through a colour palette
+//
+// Parameters:
+//   posFile       - LED positions CSV file (see LEDPositions.h) - without one LEDs are laid out in a line
+//   palette       - rainbow, fire, ocean, forest, lava or party
+//   scaleMm       - size of a noise feature in mm (default 400)
+//   speed         - noise cells per second that the field drifts through the LEDs (default 0.3)
+//   contrast      - spread of the noise across the palette (default 1.0)
+//   brightnessPC  - max brightness (default 100)
+//   rateMs        - frame period
+//
+// LED positions are converted to noise coordinates once in setup so each frame is one noise sample and a
+// palette lookup per LED.
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "RaftCore.h"
+#include "LEDPositions.h"
+#include "LEDNoise3D.h"
+#include "LEDFrameScheduler.h"
+
+#define DEBUG_LEDPATTERN_NOISE_SETUP
+
+class LEDPatternNoise : public LEDPatternBase
+{
+public:
+    LEDPatternNoise(NamedValueProvider* pNamedValueProvider, LEDPixelIF& pixels) :
+        LEDPatternBase(pNamedValueProvider, pixels)
+    {
+    }
+    virtual ~LEDPatternNoise()
+    {
+    }
+
+    // Create function for factory
+    static LEDPatternBase* create(NamedValueProvider* pNamedValueProvider, LEDPixelIF& pixels)
+    {
+        return new LEDPatternNoise(pNamedValueProvider, pixels);
+    }
+
+    // Setup
+    virtual void setup(const char* pParamsJson = nullptr) override final
+    {
+        String posFileName;
+        String paletteName = "rainbow";
+        double scaleMm = DEFAULT_SCALE_MM;
+        double speed = DEFAULT_SPEED;
+        double contrast = 1.0;
+        double brightnessPC = 100;
+        if (pParamsJson)
+        {
+            RaftJson paramsJson(pParamsJson, false);
+            _refreshRateMs = paramsJson.getLong("rateMs", _refreshRateMs);
+            posFileName = paramsJson.getString("posFile", "");
+            paletteName = paramsJson.getString("palette", paletteName.c_str());
+            scaleMm = paramsJson.getDouble("scaleMm", scaleMm);
+            speed = paramsJson.getDouble("speed", speed);
+            contrast = paramsJson.getDouble("contrast", contrast);
+            brightnessPC = paramsJson.getDouble("brightnessPC", brightnessPC);
+        }
+        _pPalette = getPalette(paletteName);
+        _speedPerMs = speed * 65536 / 1000;
+        // Contrast is limited so the fixed-point product in loop() can't overflow (the whole palette is spanned
+        // well before the limit so larger values would look the same anyway)
+        contrast = contrast > CONTRAST_MAX ? CONTRAST_MAX : (contrast < -CONTRAST_MAX ? -CONTRAST_MAX : contrast);
+        _contrast = contrast * 256;
+        _brightness = brightnessPC >= 100 ? 256 : (brightnessPC <= 0 ? 0 : uint32_t(brightnessPC * 256 / 100));
+
+        // Noise coordinates for each LED (16.16 fixed point cells - wrapping is fine as the noise repeats)
+        LEDPositions positions;
+        positions.setup(_pixels.getNumPixels(), posFileName.c_str());
+        int32_t cellsPerMm = scaleMm >= 1 ? int32_t(65536 / scaleMm) : 65536;
+        _noiseX.resize(positions.size());
+        _noiseY.resize(positions.size());
+        _noiseZ.resize(positions.size());
+        for (uint32_t i = 0; i < positions.size(); i++)
+        {
+            _noiseX[i] = uint32_t(int64_t(positions.x(i)) * cellsPerMm);
+            _noiseY[i] = uint32_t(int64_t(positions.y(i)) * cellsPerMm);
+            _noiseZ[i] = uint32_t(int64_t(positions.z(i)) * cellsPerMm);
+        }
+
+        // Timing
+        _scheduler.start(_refreshRateMs);
+
+#ifdef DEBUG_LEDPATTERN_NOISE_SETUP
+        LOG_I(MODULE_PREFIX, "setup palette %s scaleMm %.0f speed %.2f contrast %.2f rateMs %d numPix %d positions %d",
+                paletteName.c_str(), scaleMm, speed, contrast, _refreshRateMs, _pixels.getNumPixels(),
+                positions.getNumLoaded());
+#endif
+    }
+
+    // Loop
+    virtual void loop() override final
+    {
+        if (!_scheduler.isFrameDue())
+            return;
+
+        // The field drifts mainly along z (time acts as the 4th dimension) with some sideways motion
+        uint32_t timeOffset = uint32_t(int64_t(_scheduler.getFrameTimeMs() * _speedPerMs));
+        uint32_t sideOffset = timeOffset >> 2;
+        uint32_t numPix = _pixels.getNumPixels() < _noiseX.size() ? _pixels.getNumPixels() : _noiseX.size();
+        for (uint32_t pixIdx = 0; pixIdx < numPix; pixIdx++)
+        {
+            int32_t noiseVal = LEDNoise3D::noise(_noiseX[pixIdx] + sideOffset, _noiseY[pixIdx], _noiseZ[pixIdx] + timeOffset);
+            int32_t paletteIdx = 128 + ((noiseVal * _contrast) >> 15);
+            paletteIdx = paletteIdx < 0 ? 0 : (paletteIdx > 255 ? 255 : paletteIdx);
+            uint32_t rgb = paletteLookup(paletteIdx);
+            _pixels.setRGB(pixIdx, (((rgb >> 16) & 0xff) * _brightness) >> 8,
+                        (((rgb >> 8) & 0xff) * _brightness) >> 8, ((rgb & 0xff) * _brightness) >> 8);
+        }
+        _pixels.show();
+    }
+
+private:
+    // Noise coordinates per LED
+    std::vector<uint32_t> _noiseX;
+    std::vector<uint32_t> _noiseY;
+    std::vector<uint32_t> _noiseZ;
+
+    // Settings
+    static constexpr double DEFAULT_SCALE_MM = 400;
+    static constexpr double DEFAULT_SPEED = 0.3;
+    double _speedPerMs = 0;
+    static constexpr double CONTRAST_MAX = 16;
+    int32_t _contrast = 256;
+    uint32_t _brightness = 256;
+
+    // Palette (16 entries of 0xRRGGBB, interpolated)
+    static const uint32_t PALETTE_SIZE = 16;
+    const uint32_t* _pPalette = nullptr;
+
+    // Timing
+    LEDFrameScheduler _scheduler;
+
+    // Debug
+    static constexpr const char *MODULE_PREFIX = "LEDPatNoise";
+
+    uint32_t paletteLookup(uint32_t idx) const
+    {
+        uint32_t entry = idx >> 4;
+        uint32_t frac = idx & 0x0f;
+        uint32_t c1 = _pPalette[entry];
+        uint32_t c2 = _pPalette[entry + 1 < PALETTE_SIZE ? entry + 1 : entry];
+        uint32_t rslt = 0;
+        for (uint32_t shift = 0; shift <= 16; shift += 8)
+        {
+            uint32_t v1 = (c1 >> shift) & 0xff;
+            uint32_t v2 = (c2 >> shift) & 0xff;
+            rslt |= ((v1 * (16 - frac) + v2 * frac) >> 4) << shift;
+        }
+        return rslt;
+    }
+
+    static const uint32_t* getPalette(const String& name)
+    {
+        static const uint32_t RAINBOW[PALETTE_SIZE] = {
+            0xff0000, 0xd52a00, 0xab5500, 0xab7f00, 0xabab00, 0x56d500, 0x00ff00, 0x00d52a,
+            0x00ab55, 0x0056aa, 0x0000ff, 0x2a00d5, 0x5500ab, 0x7f0081, 0xab0055, 0xd5002b
+        };
+        static const uint32_t FIRE[PALETTE_SIZE] = {
+            0x000000, 0x100000, 0x300000, 0x600000, 0x900000, 0xc01000, 0xe03000, 0xff5000,
+            0xff7000, 0xff9000, 0xffb000, 0xffd020, 0xffe050, 0xfff080, 0xfff0b0, 0xffffe0
+        };
+        static const uint32_t OCEAN[PALETTE_SIZE] = {
+            0x000010, 0x000030, 0x000060, 0x000090, 0x0010b0, 0x0030c0, 0x0050d0, 0x0070e0,
+            0x0090e0, 0x00a0d0, 0x10b0c0, 0x30c0c0, 0x60d0d0, 0x90e0e0, 0xc0f0f0, 0x40a0ff
+        };
+        static const uint32_t FOREST[PALETTE_SIZE] = {
+            0x002000, 0x003000, 0x004000, 0x006000, 0x107010, 0x208020, 0x409030, 0x60a020,
+            0x80b010, 0x609020, 0x407010, 0x305010, 0x506000, 0x708010, 0x204010, 0x103010
+        };
+        static const uint32_t LAVA[PALETTE_SIZE] = {
+            0x000000, 0x120000, 0x230000, 0x710000, 0x8e0300, 0xaf1100, 0xd52c00, 0xff5200,
+            0xff7300, 0xff9c00, 0xffc500, 0xffff2d, 0xffffff, 0xffc500, 0xff5200, 0x710000
+        };
+        static const uint32_t PARTY[PALETTE_SIZE] = {
+            0x5500ab, 0x84007c, 0xb5004b, 0xe5001b, 0xe81700, 0xb84700, 0xab7700, 0xabab00,
+            0xab5500, 0xdd2200, 0xf2000e, 0xc2003e, 0x8f0071, 0x5f00a1, 0x2f00d0, 0x0007f9
+        };
+        if (name.equalsIgnoreCase("fire"))
+            return FIRE;
+        if (name.equalsIgnoreCase("ocean"))
+            return OCEAN;
+        if (name.equalsIgnoreCase("forest"))
+            return FOREST;
+        if (name.equalsIgnoreCase("lava"))
+            return LAVA;
+        if (name.equalsIgnoreCase("party"))
+            return PARTY;
+        return RAINBOW;
+    }
+};
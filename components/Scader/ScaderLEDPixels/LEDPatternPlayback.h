@@ -0,0 +1,150 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// LED Pattern Playback
+// Plays a pre-rendered animation streamed from the file system (see LEDAnimStream.h for the format)
+//
+// Parameters:
+//   file        - animation file name
+//   loop        - 1 to loop (default), 0 to hold the last frame
+//   startFrame  - frame to start from (or startMs to start from a time offset)
+//
+// Frames are paced by LEDFrameScheduler on a fixed timeline so loop latency doesn't accumulate. If playback
+// falls behind the timeline skips the missed frames and the stream seeks past them (decoding forward from the
+// nearest keyframe as delta frames depend on the frames before them).
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "RaftCore.h"
+#include "LEDAnimStream.h"
+#include "LEDFrameScheduler.h"
+
+#define DEBUG_LEDPATTERN_PLAYBACK_SETUP
+
+class LEDPatternPlayback : public LEDPatternBase
+{
+public:
+    LEDPatternPlayback(NamedValueProvider* pNamedValueProvider, LEDPixelIF& pixels) :
+        LEDPatternBase(pNamedValueProvider, pixels)
+    {
+    }
+    virtual ~LEDPatternPlayback()
+    {
+    }
+
+    // Create function for factory
+    static LEDPatternBase* create(NamedValueProvider* pNamedValueProvider, LEDPixelIF& pixels)
+    {
+        return new LEDPatternPlayback(pNamedValueProvider, pixels);
+    }
+
+    // Setup
+    virtual void setup(const char* pParamsJson = nullptr) override final
+    {
+        String fileName;
+        uint32_t startFrame = 0;
+        uint32_t startMs = 0;
+        if (pParamsJson)
+        {
+            RaftJson paramsJson(pParamsJson, false);
+            fileName = paramsJson.getString("file", "");
+            _loop = paramsJson.getLong("loop", 1) != 0;
+            startFrame = paramsJson.getLong("startFrame", 0);
+            startMs = paramsJson.getLong("startMs", 0);
+        }
+
+        // Open the animation
+        _isPlaying = _stream.open(fileName);
+        if (_isPlaying)
+        {
+            if (startMs > 0)
+                startFrame = uint64_t(startMs) * _stream.getFPS() / 1000;
+            startFrame %= _stream.getNumFrames();
+            if ((startFrame > 0) && !_stream.seek(startFrame))
+            {
+                LOG_W(MODULE_PREFIX, "setup %s seek to frame %d failed - starting from the beginning",
+                        fileName.c_str(), startFrame);
+                _stream.rewind();
+            }
+            _framePeriodUs = 1000000 / _stream.getFPS();
+            _scheduler.startUs(_framePeriodUs);
+        }
+
+#ifdef DEBUG_LEDPATTERN_PLAYBACK_SETUP
+        LOG_I(MODULE_PREFIX, "setup %s %s fps %d numLEDs %d numFrames %d loop %d startFrame %d",
+                fileName.c_str(), _isPlaying ? "OK" : "FAILED", _stream.getFPS(), _stream.getNumLEDs(),
+                _stream.getNumFrames(), _loop, startFrame);
+#endif
+    }
+
+    // Loop
+    virtual void loop() override final
+    {
+        if (!_isPlaying)
+            return;
+
+        // Check if the next frame is due
+        if (!_scheduler.isFrameDue())
+            return;
+
+        // Frame to show - moves on by the number of timeline periods since the last frame (more than one if
+        // frames were skipped)
+        uint32_t framesDue = _scheduler.getFrameDeltaUs() / _framePeriodUs;
+        if (framesDue == 0)
+            framesDue = 1;
+        uint32_t numFrames = _stream.getNumFrames();
+        uint32_t frameIdx = _stream.getNextFrameIdx() + framesDue - 1;
+        if (frameIdx >= numFrames)
+        {
+            if (!_loop)
+            {
+                // Hold the last frame
+                _isPlaying = false;
+                if (_stream.isAtEnd())
+                    return;
+                frameIdx = numFrames - 1;
+            }
+            frameIdx %= numFrames;
+        }
+
+        // Seek past skipped frames (or back to the start when looping) and decode
+        if ((frameIdx != _stream.getNextFrameIdx()) && !_stream.seek(frameIdx))
+        {
+            LOG_W(MODULE_PREFIX, "loop seek failed frame %d", frameIdx);
+            _stream.rewind();
+            return;
+        }
+        if (!_stream.decodeNextFrame())
+        {
+            LOG_W(MODULE_PREFIX, "loop decode failed frame %d", frameIdx);
+            _stream.rewind();
+            return;
+        }
+
+        // Show
+        const uint8_t* pRGB = _stream.getFrameRGB();
+        uint32_t numPix = _pixels.getNumPixels() < _stream.getNumLEDs() ? _pixels.getNumPixels() : _stream.getNumLEDs();
+        for (uint32_t pixIdx = 0; pixIdx < numPix; pixIdx++)
+        {
+            _pixels.setRGB(pixIdx, pRGB[0], pRGB[1], pRGB[2]);
+            pRGB += 3;
+        }
+        _pixels.show();
+    }
+
+private:
+    // Stream
+    LEDAnimStream _stream;
+
+    // State
+    bool _isPlaying = false;
+    bool _loop = true;
+    uint32_t _framePeriodUs = 0;
+    LEDFrameScheduler _scheduler;
+
+    // Debug
+    static constexpr const char *MODULE_PREFIX = "LEDPatPlay";
+};
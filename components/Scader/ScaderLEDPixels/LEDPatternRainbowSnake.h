@@ -9,6 +9,8 @@
 #pragma once
 
 #include "RaftCore.h"
+#include "LEDFrameScheduler.h"
+#include "LEDColourUtils.h"
 
 #define DEBUG_LEDPATTERN_RAINBOW_SNAKE_SETUP
 
@@ -41,6 +43,7 @@ public:
             // Get max brightness percent
             _maxBrightnessPC = paramsJson.getDouble("brightnessPC", 10);
         }
+        _scheduler.start(_refreshRateMs);
 #ifdef DEBUG_LEDPATTERN_RAINBOW_SNAKE_SETUP
         LOG_I(MODULE_PREFIX, "Setup rateMs %d brightnessPC %f numPix %d", _refreshRateMs, _maxBrightnessPC, _pixels.getNumPixels());
 #endif
@@ -50,17 +53,19 @@ public:
     virtual void loop() override final
     {
         // Check update time
-        if (!Raft::isTimeout(millis(), _lastLoopMs, _refreshRateMs))
+        if (!_scheduler.isFrameDue())
             return;
-        _lastLoopMs = millis();
 
         if (_curState)
         {
+            // Every third pixel with the hue wheel spread across the strip (16-bit hue)
             uint32_t numPix = _pixels.getNumPixels();
-            for (int pixIdx = _curIter; pixIdx < numPix; pixIdx += 3)
+            if (numPix > _curIter)
             {
-                uint16_t hue = pixIdx * 360 / numPix + _curHue;
-                _pixels.setHSV(pixIdx, hue, 100, _maxBrightnessPC);
+                uint32_t hueStep = (3 << 16) / numPix;
+                uint32_t hueStart = (_curIter << 16) / numPix + (_curHue << 16) / 360;
+                uint32_t val = _maxBrightnessPC >= 100 ? 255 : uint32_t(_maxBrightnessPC * 255 / 100);
+                LEDColourUtils::setHSVRange(_pixels, _curIter, (numPix - _curIter + 2) / 3, hueStart, hueStep, 255, val, 3);
             }
             // Show pixels
             _pixels.show();
@@ -78,7 +83,7 @@ public:
 
 private:
     // State
-    uint32_t _lastLoopMs = 0;
+    LEDFrameScheduler _scheduler;
     bool _curState = false;
     uint32_t _curIter = 0;
     uint32_t _curHue = 0;
@@ -0,0 +1,159 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// LED Pattern VM
+// Runs an LED effect program (see LEDBytecodeVM.h) loaded from the file system or passed as a parameter
+//
+// Parameters:
+//   file     - name of program file on the file system (e.g. vmrainbow.lpv)
+//   prog     - program source (used if no file is specified)
+//   posFile  - optional LED positions CSV file for the x, y and z inputs
+//   rateMs   - frame period
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "RaftCore.h"
+#include "FileSystem.h"
+#include "LEDBytecodeVM.h"
+#include "LEDPositions.h"
+#include "LEDFrameScheduler.h"
+#include "LEDColourUtils.h"
+
+#define DEBUG_LEDPATTERN_VM_SETUP
+
+class LEDPatternVM : public LEDPatternBase
+{
+public:
+    LEDPatternVM(NamedValueProvider* pNamedValueProvider, LEDPixelIF& pixels) :
+        LEDPatternBase(pNamedValueProvider, pixels)
+    {
+    }
+    virtual ~LEDPatternVM()
+    {
+    }
+
+    // Create function for factory
+    static LEDPatternBase* create(NamedValueProvider* pNamedValueProvider, LEDPixelIF& pixels)
+    {
+        return new LEDPatternVM(pNamedValueProvider, pixels);
+    }
+
+    // Setup
+    virtual void setup(const char* pParamsJson = nullptr) override final
+    {
+        String progSource;
+        String posFileName;
+        if (pParamsJson)
+        {
+            RaftJson paramsJson(pParamsJson, false);
+            _refreshRateMs = paramsJson.getLong("rateMs", _refreshRateMs);
+            posFileName = paramsJson.getString("posFile", "");
+            String progFileName = paramsJson.getString("file", "");
+            if (progFileName.length() > 0)
+                loadProgramFile(progFileName, progSource);
+            else
+                progSource = paramsJson.getString("prog", "");
+        }
+
+        // Compile once
+        String errMsg;
+        bool compiledOk = _vm.compile(progSource.c_str(), errMsg);
+        if (!compiledOk)
+            LOG_W(MODULE_PREFIX, "setup program invalid %s", errMsg.c_str());
+
+        // LED positions
+        _positions.setup(_pixels.getNumPixels(), posFileName.c_str());
+
+        // Timing
+        _scheduler.start(_refreshRateMs);
+
+#ifdef DEBUG_LEDPATTERN_VM_SETUP
+        LOG_I(MODULE_PREFIX, "setup %s codeBytes %d rateMs %d numPix %d positions %d",
+                compiledOk ? "OK" : "FAILED", _vm.getCodeSize(), _refreshRateMs,
+                _pixels.getNumPixels(), _positions.getNumLoaded());
+#endif
+    }
+
+    // Loop
+    virtual void loop() override final
+    {
+        if (!_vm.isValid())
+            return;
+
+        // Check update time
+        if (!_scheduler.isFrameDue())
+            return;
+
+        // Frame section
+        LEDBytecodeVM::Context ctx;
+        ctx.n = _pixels.getNumPixels();
+        ctx.t = _scheduler.getFrameTimeMs();
+        ctx.f = _scheduler.getFrameCount() - 1;
+        _vm.runFrame(ctx);
+
+        // Pixel section
+        LEDBytecodeVM::Output out;
+        const int16_t* pX = _positions.xData();
+        const int16_t* pY = _positions.yData();
+        const int16_t* pZ = _positions.zData();
+        uint32_t numPix = ctx.n < int32_t(_positions.size()) ? ctx.n : _positions.size();
+        for (uint32_t pixIdx = 0; pixIdx < numPix; pixIdx++)
+        {
+            ctx.i = pixIdx;
+            ctx.x = pX[pixIdx];
+            ctx.y = pY[pixIdx];
+            ctx.z = pZ[pixIdx];
+            _vm.runPixel(ctx, out);
+            if (out.mode == LEDBytecodeVM::OUTPUT_RGB)
+            {
+                _pixels.setRGB(pixIdx, clamp8(out.a), clamp8(out.b), clamp8(out.c));
+            }
+            else if (out.mode == LEDBytecodeVM::OUTPUT_HSV)
+            {
+                uint8_t r = 0, g = 0, b = 0;
+                LEDColourUtils::hsvToRGB(out.a & 0xffff, clamp8(out.b), clamp8(out.c), r, g, b);
+                _pixels.setRGB(pixIdx, r, g, b);
+            }
+        }
+
+        // Show pixels
+        _pixels.show();
+    }
+
+private:
+    // VM and LED positions
+    LEDBytecodeVM _vm;
+    LEDPositions _positions;
+
+    // Frame timing
+    LEDFrameScheduler _scheduler;
+
+    // Max program file size
+    static const uint32_t MAX_PROGRAM_FILE_LEN = 4096;
+
+    // Debug
+    static constexpr const char *MODULE_PREFIX = "LEDPatVM";
+
+    static inline uint32_t clamp8(int32_t val)
+    {
+        return val < 0 ? 0 : (val > 255 ? 255 : val);
+    }
+
+    void loadProgramFile(const String& fileName, String& progSource)
+    {
+        FILE* pFile = fileSystem.fileOpen("", fileName, false, 0);
+        if (!pFile)
+        {
+            LOG_W(MODULE_PREFIX, "loadProgramFile failed to open %s", fileName.c_str());
+            return;
+        }
+        std::vector<uint8_t> buf(MAX_PROGRAM_FILE_LEN + 1);
+        uint32_t bytesRead = fileSystem.fileRead(pFile, buf.data(), MAX_PROGRAM_FILE_LEN);
+        fileSystem.fileClose(pFile, "", fileName, false);
+        buf[bytesRead] = 0;
+        progSource = (const char*)buf.data();
+    }
+};
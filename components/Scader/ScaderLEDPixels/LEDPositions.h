@@ -0,0 +1,167 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// LED Positions
+// Physical (x, y, z) position of each LED in mm - loaded from a CSV file on the file system
+//
+// Each line of the file holds x,y,z (or idx,x,y,z) - lines that don't parse (e.g. a header) are skipped
+// If no file is available the LEDs are laid out along the x axis at a fixed pitch
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+#include "RaftCore.h"
+#include "FileSystem.h"
+
+class LEDPositions
+{
+public:
+    static constexpr int32_t DEFAULT_PITCH_MM = 16;
+
+    // Setup - returns true if positions were loaded from file
+    bool setup(uint32_t numPixels, const char* pFileName)
+    {
+        _x.assign(numPixels, 0);
+        _y.assign(numPixels, 0);
+        _z.assign(numPixels, 0);
+        _numLoaded = 0;
+        if (pFileName && pFileName[0])
+            loadFromFile(pFileName);
+
+        // Default layout for any LEDs not in the file
+        for (uint32_t i = _numLoaded; i < numPixels; i++)
+            _x[i] = clampMM(int32_t(i) * DEFAULT_PITCH_MM);
+        calcBounds();
+        return _numLoaded > 0;
+    }
+
+    // Access
+    uint32_t size() const { return _x.size(); }
+    uint32_t getNumLoaded() const { return _numLoaded; }
+    int32_t x(uint32_t idx) const { return idx < _x.size() ? _x[idx] : 0; }
+    int32_t y(uint32_t idx) const { return idx < _y.size() ? _y[idx] : 0; }
+    int32_t z(uint32_t idx) const { return idx < _z.size() ? _z[idx] : 0; }
+    const int16_t* xData() const { return _x.data(); }
+    const int16_t* yData() const { return _y.data(); }
+    const int16_t* zData() const { return _z.data(); }
+
+    // Bounds
+    int32_t minX() const { return _min[0]; }
+    int32_t minY() const { return _min[1]; }
+    int32_t minZ() const { return _min[2]; }
+    int32_t maxX() const { return _max[0]; }
+    int32_t maxY() const { return _max[1]; }
+    int32_t maxZ() const { return _max[2]; }
+
+private:
+    // Positions in mm (int16 covers +/- 32m which is plenty)
+    std::vector<int16_t> _x;
+    std::vector<int16_t> _y;
+    std::vector<int16_t> _z;
+    uint32_t _numLoaded = 0;
+    int32_t _min[3] = {};
+    int32_t _max[3] = {};
+
+    // Debug
+    static constexpr const char* MODULE_PREFIX = "LEDPositions";
+
+    static int16_t clampMM(int32_t val)
+    {
+        return val < INT16_MIN ? INT16_MIN : (val > INT16_MAX ? INT16_MAX : val);
+    }
+
+    void loadFromFile(const char* pFileName)
+    {
+        FILE* pFile = fileSystem.fileOpen("", pFileName, false, 0);
+        if (!pFile)
+        {
+            LOG_W(MODULE_PREFIX, "loadFromFile failed to open %s", pFileName);
+            return;
+        }
+
+        // Read in chunks and split into lines
+        static const uint32_t CHUNK_SIZE = 128;
+        static const uint32_t MAX_LINE_LEN = 80;
+        uint8_t chunk[CHUNK_SIZE];
+        char line[MAX_LINE_LEN + 1];
+        uint32_t lineLen = 0;
+        while (_numLoaded < _x.size())
+        {
+            uint32_t bytesRead = fileSystem.fileRead(pFile, chunk, CHUNK_SIZE);
+            for (uint32_t i = 0; i < bytesRead; i++)
+            {
+                char ch = chunk[i];
+                if ((ch == '\n') || (ch == '\r'))
+                {
+                    line[lineLen] = 0;
+                    parseLine(line);
+                    lineLen = 0;
+                }
+                else if (lineLen < MAX_LINE_LEN)
+                {
+                    line[lineLen++] = ch;
+                }
+            }
+            if (bytesRead < CHUNK_SIZE)
+                break;
+        }
+        if (lineLen > 0)
+        {
+            line[lineLen] = 0;
+            parseLine(line);
+        }
+        fileSystem.fileClose(pFile, "", pFileName, false);
+        LOG_I(MODULE_PREFIX, "loadFromFile %s loaded %d of %d positions", pFileName, _numLoaded, _x.size());
+    }
+
+    void parseLine(const char* pLine)
+    {
+        if (_numLoaded >= _x.size())
+            return;
+
+        // Extract up to 4 numeric fields
+        float vals[4];
+        uint32_t numVals = 0;
+        const char* pCur = pLine;
+        while (*pCur && (numVals < 4))
+        {
+            char* pEnd = nullptr;
+            float val = strtof(pCur, &pEnd);
+            if (pEnd == pCur)
+                return;
+            vals[numVals++] = val;
+            pCur = pEnd;
+            while (*pCur == ',' || *pCur == ' ' || *pCur == '\t')
+                pCur++;
+        }
+        if (numVals < 3)
+            return;
+        uint32_t firstIdx = numVals == 4 ? 1 : 0;
+        _x[_numLoaded] = clampMM(int32_t(vals[firstIdx]));
+        _y[_numLoaded] = clampMM(int32_t(vals[firstIdx + 1]));
+        _z[_numLoaded] = clampMM(int32_t(vals[firstIdx + 2]));
+        _numLoaded++;
+    }
+
+    void calcBounds()
+    {
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            const std::vector<int16_t>& vals = axis == 0 ? _x : (axis == 1 ? _y : _z);
+            _min[axis] = vals.size() > 0 ? INT16_MAX : 0;
+            _max[axis] = vals.size() > 0 ? INT16_MIN : 0;
+            for (int16_t val : vals)
+            {
+                if (val < _min[axis])
+                    _min[axis] = val;
+                if (val > _max[axis])
+                    _max[axis] = val;
+            }
+        }
+    }
+};
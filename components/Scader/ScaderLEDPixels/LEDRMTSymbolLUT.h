@@ -0,0 +1,127 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// LEDRMTSymbolLUT
+// Byte to 8 RMT symbols lookup table for LED strip encoding
+//
+// Built once from the strip bit timings so that encoding in the RMT refill ISR is a table copy (32 bytes
+// per data byte) rather than a bit by bit loop. Symbols use the RMT symbol word layout:
+//   bits 0..14 duration0, bit 15 level0, bits 16..30 duration1, bit 31 level1
+// This header has no ESP-IDF dependencies so it can be built and checked on a host
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+class LEDRMTSymbolLUT
+{
+public:
+    static const uint32_t SYMBOLS_PER_BYTE = 8;
+    static const uint32_t MAX_DURATION_TICKS = 0x7fff;
+
+    // Bit timings in RMT ticks
+    struct Timing
+    {
+        uint32_t t0hTicks = 0;
+        uint32_t t0lTicks = 0;
+        uint32_t t1hTicks = 0;
+        uint32_t t1lTicks = 0;
+        uint32_t resetTicks = 0;
+        bool msbFirst = true;
+        bool operator==(const Timing& other) const
+        {
+            return (t0hTicks == other.t0hTicks) && (t0lTicks == other.t0lTicks) &&
+                   (t1hTicks == other.t1hTicks) && (t1lTicks == other.t1lTicks) &&
+                   (resetTicks == other.resetTicks) && (msbFirst == other.msbFirst);
+        }
+    };
+
+    // Convert timings in us to ticks at the RMT resolution (rounded to nearest tick)
+    static Timing timingFromUs(uint32_t rmtHz, double t0hUs, double t0lUs, double t1hUs, double t1lUs,
+                double resetUs, bool msbFirst)
+    {
+        Timing timing;
+        double ticksPerUs = rmtHz / 1e6;
+        timing.t0hTicks = usToTicks(t0hUs, ticksPerUs);
+        timing.t0lTicks = usToTicks(t0lUs, ticksPerUs);
+        timing.t1hTicks = usToTicks(t1hUs, ticksPerUs);
+        timing.t1lTicks = usToTicks(t1lUs, ticksPerUs);
+        timing.resetTicks = uint32_t(resetUs * ticksPerUs + 0.5);
+        timing.msbFirst = msbFirst;
+        return timing;
+    }
+
+    // Build the table
+    void build(const Timing& timing)
+    {
+        _timing = timing;
+        uint32_t bit0 = makeSymbol(1, timing.t0hTicks, 0, timing.t0lTicks);
+        uint32_t bit1 = makeSymbol(1, timing.t1hTicks, 0, timing.t1lTicks);
+        for (uint32_t byteVal = 0; byteVal < 256; byteVal++)
+        {
+            for (uint32_t bitIdx = 0; bitIdx < SYMBOLS_PER_BYTE; bitIdx++)
+            {
+                uint32_t mask = timing.msbFirst ? (0x80 >> bitIdx) : (1 << bitIdx);
+                _lut[byteVal][bitIdx] = (byteVal & mask) ? bit1 : bit0;
+            }
+        }
+
+        // Reset (latch) is split across both halves of a single low symbol
+        uint32_t halfTicks = timing.resetTicks / 2;
+        if (halfTicks > MAX_DURATION_TICKS)
+            halfTicks = MAX_DURATION_TICKS;
+        _resetSymbol = makeSymbol(0, halfTicks, 0, halfTicks);
+    }
+
+    // Access
+    const uint32_t* getSymbols(uint8_t byteVal) const
+    {
+        return _lut[byteVal];
+    }
+    uint32_t getResetSymbol() const
+    {
+        return _resetSymbol;
+    }
+    const Timing& getTiming() const
+    {
+        return _timing;
+    }
+
+    // Encode bytes into a symbol buffer (which must hold numBytes * SYMBOLS_PER_BYTE symbols)
+    void encode(const uint8_t* pData, uint32_t numBytes, uint32_t* pSymbols) const
+    {
+        for (uint32_t i = 0; i < numBytes; i++)
+        {
+            const uint32_t* pSrc = _lut[pData[i]];
+            for (uint32_t j = 0; j < SYMBOLS_PER_BYTE; j++)
+                *pSymbols++ = pSrc[j];
+        }
+    }
+
+    // Symbol fields
+    static uint32_t makeSymbol(uint32_t level0, uint32_t duration0, uint32_t level1, uint32_t duration1)
+    {
+        return (duration0 & MAX_DURATION_TICKS) | ((level0 & 1) << 15) |
+               ((duration1 & MAX_DURATION_TICKS) << 16) | ((level1 & 1) << 31);
+    }
+    static uint32_t symbolDuration0(uint32_t symbol) { return symbol & MAX_DURATION_TICKS; }
+    static uint32_t symbolLevel0(uint32_t symbol) { return (symbol >> 15) & 1; }
+    static uint32_t symbolDuration1(uint32_t symbol) { return (symbol >> 16) & MAX_DURATION_TICKS; }
+    static uint32_t symbolLevel1(uint32_t symbol) { return symbol >> 31; }
+
+private:
+    uint32_t _lut[256][SYMBOLS_PER_BYTE] = {};
+    uint32_t _resetSymbol = 0;
+    Timing _timing;
+
+    static uint32_t usToTicks(double us, double ticksPerUs)
+    {
+        uint32_t ticks = uint32_t(us * ticksPerUs + 0.5);
+        if (ticks == 0)
+            ticks = 1;
+        return ticks > MAX_DURATION_TICKS ? MAX_DURATION_TICKS : ticks;
+    }
+};
@@ -0,0 +1,437 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// LEDStripsRMT
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include "LEDStripsRMT.h"
+#include "LEDColourUtils.h"
+#include "RaftArduino.h"
+#include "ConfigPinMap.h"
+#include "esp_check.h"
+#include "soc/soc_caps.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include <new>
+
+#define DEBUG_LED_STRIPS_RMT_SETUP
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Strip encoder - called by the RMT driver to refill the channel memory (from the ISR once transmitting)
+// Each data byte is a 32 byte copy from the symbol LUT and the reset (latch) symbol follows the data
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static size_t RMT_ENCODER_FUNC_ATTR ledStripLUTEncode(const void* pData, size_t dataSize, size_t symbolsWritten,
+                size_t symbolsFree, rmt_symbol_word_t* pSymbols, bool* pDone, void* pArg)
+{
+    LEDStripsRMT::EncoderContext* pCtx = (LEDStripsRMT::EncoderContext*)pArg;
+
+    // Refill timing - if the gap since the last refill is longer than the channel memory takes to
+    // transmit then the hardware ran out of symbols
+    uint32_t nowUs = esp_timer_get_time();
+    if (symbolsWritten == 0)
+    {
+        pCtx->stats.frames++;
+    }
+    else
+    {
+        uint32_t gapUs = nowUs - pCtx->lastRefillUs;
+        pCtx->stats.refills++;
+        if (gapUs > pCtx->stats.maxRefillGapUs)
+            pCtx->stats.maxRefillGapUs = gapUs;
+        if (gapUs > pCtx->underrunGapUs)
+            pCtx->stats.underruns++;
+    }
+    pCtx->lastRefillUs = nowUs;
+
+    // Data complete - add reset
+    size_t bytePos = symbolsWritten / LEDRMTSymbolLUT::SYMBOLS_PER_BYTE;
+    if (bytePos >= dataSize)
+    {
+        if (symbolsFree < 1)
+            return 0;
+        pSymbols[0].val = pCtx->pLUT->getResetSymbol();
+        *pDone = true;
+        return 1;
+    }
+
+    // Copy as many whole bytes as fit
+    size_t numBytes = symbolsFree / LEDRMTSymbolLUT::SYMBOLS_PER_BYTE;
+    if (numBytes > dataSize - bytePos)
+        numBytes = dataSize - bytePos;
+    const uint8_t* pBytes = (const uint8_t*)pData + bytePos;
+    uint32_t* pOut = (uint32_t*)pSymbols;
+    for (size_t i = 0; i < numBytes; i++)
+    {
+        memcpy(pOut, pCtx->pLUT->getSymbols(pBytes[i]), LEDRMTSymbolLUT::SYMBOLS_PER_BYTE * sizeof(uint32_t));
+        pOut += LEDRMTSymbolLUT::SYMBOLS_PER_BYTE;
+    }
+    return numBytes * LEDRMTSymbolLUT::SYMBOLS_PER_BYTE;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Constructor / Destructor
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LEDStripsRMT::LEDStripsRMT()
+{
+}
+
+LEDStripsRMT::~LEDStripsRMT()
+{
+    teardown();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Setup
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LEDStripsRMT::setup(const RaftJsonIF& config)
+{
+    teardown();
+
+    // Brightness and colour order (from the first segment as with LEDPixels)
+    uint32_t brightnessPC = config.getLong("brightnessPC", 100);
+    _brightnessScale = brightnessPC >= 100 ? 256 : brightnessPC * 256 / 100;
+    setColourOrder(config.getString("segments[0]/colorOrder", "GRB"));
+
+    // Strips
+    std::vector<String> stripConfigs;
+    config.getArrayElems("strips", stripConfigs);
+    _strips.resize(stripConfigs.size());
+    _numPixels = 0;
+    bool rslt = stripConfigs.size() > 0;
+    for (uint32_t stripIdx = 0; stripIdx < stripConfigs.size(); stripIdx++)
+    {
+        RaftJson stripConfig(stripConfigs[stripIdx]);
+        _strips[stripIdx].pixelOffset = _numPixels;
+        if (!setupStrip(_strips[stripIdx], stripConfig))
+        {
+            rslt = false;
+            break;
+        }
+        _numPixels += _strips[stripIdx].numPixels;
+    }
+    if (!rslt)
+    {
+        teardown();
+        return false;
+    }
+
+    // Buffers (strips are dirty initially so the first show sends everything)
+    _renderBuf.assign(_numPixels * 3, 0);
+    _txBuf.assign(_numPixels * 3, 0);
+    _framesSkipped = 0;
+    for (auto& strip : _strips)
+        strip.isDirty = true;
+
+    // Optional sync manager so all channels start on the same clock edge - this holds every channel until
+    // all are queued so unchanged strips can't then be skipped individually
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    if ((_strips.size() > 1) && config.getBool("syncStart", false))
+    {
+        std::vector<rmt_channel_handle_t> channels;
+        for (auto& strip : _strips)
+            channels.push_back(strip.hChannel);
+        rmt_sync_manager_config_t syncConfig = {};
+        syncConfig.tx_channel_array = channels.data();
+        syncConfig.array_size = channels.size();
+        if (rmt_new_sync_manager(&syncConfig, &_hSyncManager) != ESP_OK)
+        {
+            LOG_W(MODULE_PREFIX, "setup sync manager failed - channels will start back to back");
+            _hSyncManager = nullptr;
+        }
+    }
+#endif
+
+#ifdef DEBUG_LED_STRIPS_RMT_SETUP
+    LOG_I(MODULE_PREFIX, "setup OK numStrips %d numPixels %d syncManager %s brightnessPC %d",
+                _strips.size(), _numPixels, _hSyncManager ? "Y" : "N", brightnessPC);
+#endif
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Set pixels
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LEDStripsRMT::setRGB(uint32_t ledIdx, uint32_t r, uint32_t g, uint32_t b, bool applyBrightness)
+{
+    if (ledIdx >= _numPixels)
+        return;
+    if (applyBrightness)
+    {
+        r = (r * _brightnessScale) >> 8;
+        g = (g * _brightnessScale) >> 8;
+        b = (b * _brightnessScale) >> 8;
+    }
+    uint8_t* pPix = _renderBuf.data() + ledIdx * 3;
+    if ((pPix[_rOffset] == r) && (pPix[_gOffset] == g) && (pPix[_bOffset] == b))
+        return;
+    pPix[_rOffset] = r;
+    pPix[_gOffset] = g;
+    pPix[_bOffset] = b;
+
+    // Mark the strip containing the pixel as changed
+    uint32_t stripIdx = _strips.size() - 1;
+    while ((stripIdx > 0) && (_strips[stripIdx].pixelOffset > ledIdx))
+        stripIdx--;
+    _strips[stripIdx].isDirty = true;
+}
+
+void LEDStripsRMT::setHSV(uint32_t ledIdx, uint32_t h, uint32_t s, uint32_t v)
+{
+    // h 0..359, s and v 0..100
+    uint8_t r = 0, g = 0, b = 0;
+    LEDColourUtils::hsvToRGB(((h % 360) << 16) / 360, s >= 100 ? 255 : s * 255 / 100, v >= 100 ? 255 : v * 255 / 100, r, g, b);
+    setRGB(ledIdx, r, g, b);
+}
+
+void LEDStripsRMT::clear()
+{
+    // Only strips with something lit are changed by clearing
+    for (auto& strip : _strips)
+    {
+        uint8_t* pData = _renderBuf.data() + strip.pixelOffset * 3;
+        uint32_t dataLen = strip.numPixels * 3;
+        for (uint32_t i = 0; i < dataLen; i++)
+        {
+            if (pData[i])
+            {
+                memset(pData, 0, dataLen);
+                strip.isDirty = true;
+                break;
+            }
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Show - start all strips together
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LEDStripsRMT::show()
+{
+    if (_strips.size() == 0)
+        return false;
+
+    // Nothing to do if no strip has changed since it was last sent
+    bool anyDirty = false;
+    for (auto& strip : _strips)
+        anyDirty |= strip.isDirty;
+    if (!anyDirty)
+    {
+        _framesSkipped++;
+        return true;
+    }
+
+    // Completion barrier - the previous frame must be off the wire before the tx buffer is reused
+    if (!waitAllDone(TX_DONE_TIMEOUT_MS))
+        return false;
+
+    // Queue changed strips (all strips if a sync manager is used as none start until all are queued)
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    if (_hSyncManager)
+        rmt_sync_reset(_hSyncManager);
+#endif
+    rmt_transmit_config_t txConfig = {};
+    txConfig.loop_count = 0;
+    bool rslt = true;
+    for (auto& strip : _strips)
+    {
+        if (!strip.isDirty && !_hSyncManager)
+        {
+            strip.txSkipped++;
+            continue;
+        }
+        uint8_t* pTxData = _txBuf.data() + strip.pixelOffset * 3;
+        memcpy(pTxData, _renderBuf.data() + strip.pixelOffset * 3, strip.numPixels * 3);
+        strip.isDirty = false;
+        if (rmt_transmit(strip.hChannel, strip.hEncoder, pTxData, strip.numPixels * 3, &txConfig) != ESP_OK)
+            rslt = false;
+    }
+    _txInProgress = true;
+    _txStartUs = esp_timer_get_time();
+    return rslt;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Wait for all strips to complete
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LEDStripsRMT::waitAllDone(uint32_t timeoutMs)
+{
+    if (!_txInProgress)
+        return true;
+    for (auto& strip : _strips)
+    {
+        if (rmt_tx_wait_all_done(strip.hChannel, timeoutMs) != ESP_OK)
+        {
+            LOG_W(MODULE_PREFIX, "waitAllDone timeout pin %d", strip.pin);
+            return false;
+        }
+    }
+    _txInProgress = false;
+    _lastTxUs = esp_timer_get_time() - _txStartUs;
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Setup a strip
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LEDStripsRMT::setupStrip(Strip& strip, const RaftJsonIF& stripConfig)
+{
+    strip.pin = ConfigPinMap::getPinFromName(stripConfig.getString("pin", "").c_str());
+    strip.numPixels = stripConfig.getLong("num", 0);
+    uint32_t rmtHz = stripConfig.getLong("rmtHz", 10000000);
+    if ((strip.pin < 0) || (strip.numPixels == 0))
+    {
+        LOG_W(MODULE_PREFIX, "setupStrip invalid pin %d or num %d", strip.pin, strip.numPixels);
+        return false;
+    }
+
+    // Channel
+    rmt_tx_channel_config_t chanConfig = {};
+    chanConfig.gpio_num = (gpio_num_t)strip.pin;
+    chanConfig.clk_src = RMT_CLK_SRC_DEFAULT;
+    chanConfig.resolution_hz = rmtHz;
+    chanConfig.mem_block_symbols = SOC_RMT_MEM_WORDS_PER_CHANNEL;
+    chanConfig.trans_queue_depth = 4;
+    if (rmt_new_tx_channel(&chanConfig, &strip.hChannel) != ESP_OK)
+    {
+        LOG_W(MODULE_PREFIX, "setupStrip failed to create channel pin %d", strip.pin);
+        strip.hChannel = nullptr;
+        return false;
+    }
+
+    // Symbol LUT for the bit timings (config in us) - strips with the same timings share a table
+    LEDRMTSymbolLUT::Timing timing = LEDRMTSymbolLUT::timingFromUs(rmtHz,
+                stripConfig.getDouble("T0H", 0.4), stripConfig.getDouble("T0L", 0.85),
+                stripConfig.getDouble("T1H", 0.8), stripConfig.getDouble("T1L", 0.45),
+                stripConfig.getDouble("resetUs", 50), stripConfig.getBool("msbFirst", true));
+    strip.encoderCtx.pLUT = getSymbolLUT(timing);
+    if (!strip.encoderCtx.pLUT)
+    {
+        LOG_W(MODULE_PREFIX, "setupStrip failed to allocate symbol LUT pin %d", strip.pin);
+        return false;
+    }
+
+    // Time for the hardware to drain the channel memory - refills later than this are underruns
+    uint32_t bitTicks = (timing.t0hTicks + timing.t0lTicks + timing.t1hTicks + timing.t1lTicks) / 2;
+    strip.encoderCtx.underrunGapUs = uint64_t(chanConfig.mem_block_symbols) * bitTicks * 1000000 / rmtHz;
+
+    // Encoder
+    rmt_simple_encoder_config_t encoderConfig = {};
+    encoderConfig.callback = ledStripLUTEncode;
+    encoderConfig.arg = &strip.encoderCtx;
+    encoderConfig.min_chunk_size = LEDRMTSymbolLUT::SYMBOLS_PER_BYTE;
+    if (rmt_new_simple_encoder(&encoderConfig, &strip.hEncoder) != ESP_OK)
+    {
+        LOG_W(MODULE_PREFIX, "setupStrip failed to create encoder pin %d", strip.pin);
+        strip.hEncoder = nullptr;
+        return false;
+    }
+
+    // Enable
+    return rmt_enable(strip.hChannel) == ESP_OK;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Get (or create) the symbol LUT for a timing - kept in internal RAM as it is read from the ISR
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const LEDRMTSymbolLUT* LEDStripsRMT::getSymbolLUT(const LEDRMTSymbolLUT::Timing& timing)
+{
+    for (auto pLUT : _symbolLUTs)
+    {
+        if (pLUT->getTiming() == timing)
+            return pLUT;
+    }
+    void* pMem = heap_caps_malloc(sizeof(LEDRMTSymbolLUT), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!pMem)
+        return nullptr;
+    LEDRMTSymbolLUT* pLUT = new (pMem) LEDRMTSymbolLUT();
+    pLUT->build(timing);
+    _symbolLUTs.push_back(pLUT);
+    return pLUT;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Stats
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+String LEDStripsRMT::getStatsJSON() const
+{
+    String jsonStr;
+    for (auto& strip : _strips)
+    {
+        if (jsonStr.length() > 0)
+            jsonStr += ",";
+        const TxStats& stats = strip.encoderCtx.stats;
+        jsonStr += "{\"pin\":" + String(strip.pin) +
+                   ",\"frames\":" + String(stats.frames) +
+                   ",\"refills\":" + String(stats.refills) +
+                   ",\"underruns\":" + String(stats.underruns) +
+                   ",\"maxGapUs\":" + String(stats.maxRefillGapUs) +
+                   ",\"skipped\":" + String(strip.txSkipped) + "}";
+    }
+    return "{\"txUs\":" + String(_lastTxUs) + ",\"framesSkipped\":" + String(_framesSkipped) + ",\"strips\":[" + jsonStr + "]}";
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Teardown
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LEDStripsRMT::teardown()
+{
+    waitAllDone(TX_DONE_TIMEOUT_MS);
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    if (_hSyncManager)
+        rmt_del_sync_manager(_hSyncManager);
+#endif
+    _hSyncManager = nullptr;
+    for (auto& strip : _strips)
+    {
+        if (strip.hChannel)
+        {
+            rmt_disable(strip.hChannel);
+            rmt_del_channel(strip.hChannel);
+        }
+        if (strip.hEncoder)
+            rmt_del_encoder(strip.hEncoder);
+    }
+    _strips.clear();
+    for (auto pLUT : _symbolLUTs)
+    {
+        pLUT->~LEDRMTSymbolLUT();
+        heap_caps_free(pLUT);
+    }
+    _symbolLUTs.clear();
+    _numPixels = 0;
+    _txInProgress = false;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Colour order
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LEDStripsRMT::setColourOrder(const String& colourOrder)
+{
+    String order = colourOrder;
+    order.toUpperCase();
+    if (order.length() != 3)
+        order = "GRB";
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        if (order[i] == 'R')
+            _rOffset = i;
+        else if (order[i] == 'G')
+            _gOffset = i;
+        else if (order[i] == 'B')
+            _bOffset = i;
+    }
+}
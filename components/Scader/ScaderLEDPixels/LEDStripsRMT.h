@@ -0,0 +1,139 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// LEDStripsRMT
+// Drives several LED strips from RMT channels that transmit concurrently
+//
+// show() queues every strip's RMT channel without blocking so they transmit concurrently and the frame time
+// is set by the longest strip rather than the sum of all strips. Rendering writes to a separate
+// buffer so the next frame can be prepared while the previous one is on the wire - show() waits for all
+// channels to complete (the completion barrier) before copying the new frame across and starting again.
+//
+// Strip config uses the same fields as LEDPixels (pin, num, rmtHz, T0H, T0L, T1H, T1L, resetUs, msbFirst)
+//
+// Encoding uses a byte to symbols lookup table (LEDRMTSymbolLUT) built once from the strip timings so each
+// ISR refill of the channel memory is a table copy. Refill gaps and suspected underruns are counted per strip.
+//
+// Each strip has a dirty flag set when a pixel value actually changes (or clear() blanks lit pixels) and show()
+// only retransmits dirty strips - a show() with nothing changed does no RMT work at all. With the optional
+// sync manager (config syncStart) a frame with any change sends every strip as they start together.
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+#include "RaftCore.h"
+#include "LEDPixelIF.h"
+#include "LEDRMTSymbolLUT.h"
+#include "driver/rmt_tx.h"
+#include "driver/rmt_encoder.h"
+
+class LEDStripsRMT : public LEDPixelIF
+{
+public:
+    LEDStripsRMT();
+    virtual ~LEDStripsRMT();
+
+    // Setup from config (the ScaderLEDPix module config)
+    bool setup(const RaftJsonIF& config);
+
+    // LEDPixelIF
+    virtual uint32_t getNumPixels() const override
+    {
+        return _numPixels;
+    }
+    virtual void setRGB(uint32_t ledIdx, uint32_t r, uint32_t g, uint32_t b, bool applyBrightness = true) override;
+    virtual void setRGB(uint32_t ledIdx, uint32_t c, bool applyBrightness = true) override
+    {
+        setRGB(ledIdx, (c >> 16) & 0xff, (c >> 8) & 0xff, c & 0xff, applyBrightness);
+    }
+    virtual void setHSV(uint32_t ledIdx, uint32_t h, uint32_t s, uint32_t v) override;
+    virtual void clear() override;
+    virtual bool show() override;
+
+    // Wait for all strips to finish transmitting
+    bool waitAllDone(uint32_t timeoutMs);
+
+    // Transmit stats (per strip, updated from the RMT ISR)
+    struct TxStats
+    {
+        uint32_t frames = 0;
+        uint32_t refills = 0;
+        uint32_t underruns = 0;
+        uint32_t maxRefillGapUs = 0;
+    };
+
+    // Encoder context passed to the RMT encoder callback
+    struct EncoderContext
+    {
+        const LEDRMTSymbolLUT* pLUT = nullptr;
+        uint32_t underrunGapUs = 0;
+        uint32_t lastRefillUs = 0;
+        TxStats stats;
+    };
+
+    // Stats
+    String getStatsJSON() const;
+    uint32_t getNumStrips() const
+    {
+        return _strips.size();
+    }
+    uint32_t getLastTxUs() const
+    {
+        return _lastTxUs;
+    }
+
+private:
+    // Strip
+    struct Strip
+    {
+        int pin = -1;
+        uint32_t pixelOffset = 0;
+        uint32_t numPixels = 0;
+        rmt_channel_handle_t hChannel = nullptr;
+        rmt_encoder_handle_t hEncoder = nullptr;
+        EncoderContext encoderCtx;
+        bool isDirty = true;
+        uint32_t txSkipped = 0;
+    };
+    std::vector<Strip> _strips;
+
+    // Symbol LUTs (shared between strips with the same timing)
+    std::vector<LEDRMTSymbolLUT*> _symbolLUTs;
+
+    // Sync manager (null if not supported or only one strip)
+    rmt_sync_manager_handle_t _hSyncManager = nullptr;
+
+    // Render buffer (written by patterns) and transmit buffer (read by RMT) - wire order bytes
+    std::vector<uint8_t> _renderBuf;
+    std::vector<uint8_t> _txBuf;
+    uint32_t _numPixels = 0;
+
+    // Colour order - byte offset in the wire data of each of R, G and B
+    uint8_t _rOffset = 0;
+    uint8_t _gOffset = 1;
+    uint8_t _bOffset = 2;
+
+    // Brightness (0..256)
+    uint32_t _brightnessScale = 256;
+
+    // State
+    bool _txInProgress = false;
+    uint64_t _txStartUs = 0;
+    uint32_t _lastTxUs = 0;
+    uint32_t _framesSkipped = 0;
+
+    // Timeout for the completion barrier
+    static const uint32_t TX_DONE_TIMEOUT_MS = 200;
+
+    // Helpers
+    void teardown();
+    bool setupStrip(Strip& strip, const RaftJsonIF& stripConfig);
+    const LEDRMTSymbolLUT* getSymbolLUT(const LEDRMTSymbolLUT::Timing& timing);
+    void setColourOrder(const String& colourOrder);
+
+    // Debug
+    static constexpr const char *MODULE_PREFIX = "LEDStripsRMT";
+};
@@ -18,6 +18,9 @@
 #include "LEDPatternRainbowSnake.h"
 #include "LEDPatternAutoID.h"
 #include "LEDPatternFire.h"
+#include "LEDPatternVM.h"
+#include "LEDPatternPlayback.h"
+#include "LEDPatternNoise.h"
 
 #define DEBUG_LED_PIXEL_SETUP
 
@@ -48,17 +51,30 @@ void ScaderLEDPixels::setup()
     }
 
     // Add patterns before setup so that initial pattern can be set during setup
-    _ledPixels.addPattern("RainbowSnake", &LEDPatternRainbowSnake::create);
-    _ledPixels.addPattern("autoid", &LEDPatternAutoID::create);
-    _ledPixels.addPattern("fire", &LEDPatternFire::create);
-
-    // Setup LEDs
-    bool rslt = _ledPixels.setup(modConfig());
+    addPattern("RainbowSnake", &LEDPatternRainbowSnake::create);
+    addPattern("autoid", &LEDPatternAutoID::create);
+    addPattern("fire", &LEDPatternFire::create);
+    addPattern("vm", &LEDPatternVM::create);
+    addPattern("playback", &LEDPatternPlayback::create);
+    addPattern("noise", &LEDPatternNoise::create);
+
+    // Setup LEDs - either all strips transmitting concurrently or through LEDPixels
+    _useSyncTx = configGetBool("syncTx", false);
+    bool rslt = false;
+    if (_useSyncTx)
+    {
+        rslt = _syncStrips.setup(modConfig());
+    }
+    else
+    {
+        rslt = _ledPixels.setup(modConfig());
+    }
 
     // Log
 #ifdef DEBUG_LED_PIXEL_SETUP
-    LOG_I(MODULE_PREFIX, "setup %s numPixels %d", 
-          rslt ? "OK" : "FAILED", _ledPixels.getNumPixels());
+    LOG_I(MODULE_PREFIX, "setup %s numPixels %d syncTx %s", 
+          rslt ? "OK" : "FAILED", _useSyncTx ? _syncStrips.getNumPixels() : _ledPixels.getNumPixels(),
+          _useSyncTx ? "Y" : "N");
 #endif
 
     // HW Now initialised
@@ -99,7 +115,16 @@ void ScaderLEDPixels::loop()
     if (!_isInitialised)
         return;
 
-    _ledPixels.loop();
+    // Service pattern
+    if (_useSyncTx)
+    {
+        if (_pSyncPattern)
+            _pSyncPattern->loop();
+    }
+    else
+    {
+        _ledPixels.loop();
+    }
 
 #ifdef RUN_PATTERNS_IN_SYSMOD
     // Handle patterns
@@ -144,7 +169,7 @@ RaftRetCode ScaderLEDPixels::apiControl(const String &reqStr, String &respStr, c
 
     // Get element name or type
     String elemNameOrIdx = RestAPIEndpointManager::getNthArgStr(reqStr.c_str(), 1);
-    int32_t segmentIdx = _ledPixels.getSegmentIdx(elemNameOrIdx);
+    int32_t segmentIdx = pixGetSegmentIdx(elemNameOrIdx);
     if (segmentIdx < 0)
     {
         // Check for elemNameOrIdx being a segment index number - i.e. digits only
@@ -160,7 +185,9 @@ RaftRetCode ScaderLEDPixels::apiControl(const String &reqStr, String &respStr, c
         if (isDigit)
             segmentIdx = elemNameOrIdx.toInt();
     }
-    if ((segmentIdx < 0) || (segmentIdx >= _ledPixels.getNumSegments()))
+    if (_useSyncTx && (elemNameOrIdx.length() > 0) && !isdigit(elemNameOrIdx[0]))
+        segmentIdx = 0;
+    if ((segmentIdx < 0) || (segmentIdx >= pixGetNumSegments()))
         return Raft::setJsonErrorResult(reqStr.c_str(), respStr, "invalidElement");
     String cmd = RestAPIEndpointManager::getNthArgStr(reqStr.c_str(), 2);
     cmd.trim();
@@ -175,7 +202,7 @@ RaftRetCode ScaderLEDPixels::apiControl(const String &reqStr, String &respStr, c
     if (cmd.equalsIgnoreCase("setall") || cmd.equalsIgnoreCase("color") || cmd.equalsIgnoreCase("colour"))
     {
         // Stop any pattern
-        _ledPixels.stopPattern(segmentIdx, false);
+        pixStopPattern(segmentIdx);
 
         // See if a start LED is specified
         int startLED = 0;
@@ -184,7 +211,7 @@ RaftRetCode ScaderLEDPixels::apiControl(const String &reqStr, String &respStr, c
             startLED = strtol(startLEDStr.c_str(), NULL, 10);
 
         // See if an end LED is specified
-        int endLED = _ledPixels.getNumPixels(segmentIdx);
+        int endLED = pixGetNumPixels(segmentIdx);
         String endLEDStr = RestAPIEndpointManager::getNthArgStr(reqStr.c_str(), 5);
         if (endLEDStr.length() > 0)
             endLED = strtol(endLEDStr.c_str(), NULL, 10);
@@ -195,36 +222,36 @@ RaftRetCode ScaderLEDPixels::apiControl(const String &reqStr, String &respStr, c
         auto rgb = Raft::getRGBFromHex(data);
         for (uint32_t i = startLED; i < endLED; i++)
         {
-            _ledPixels.setRGB(segmentIdx, i, rgb.r, rgb.g, rgb.b, true);
+            pixSetRGB(segmentIdx, i, rgb.r, rgb.g, rgb.b, true);
         }
 
         // Show
-        _ledPixels.show();
+        pixShow();
         rslt = true;
     }
     else if (cmd.equalsIgnoreCase("setleds"))
     {
         // Stop any pattern
-        _ledPixels.stopPattern(segmentIdx, false);
+        pixStopPattern(segmentIdx);
 
         // Set LEDs to a series of specified colours
-        for (uint32_t i = 0; i < _ledPixels.getNumPixels(segmentIdx); i++)
+        for (uint32_t i = 0; i < pixGetNumPixels(segmentIdx); i++)
         {
             String subRGB = data.substring(i * 6, i * 6 + 6);
             if (subRGB.length() != 6)
                 break;
             auto rgb = Raft::getRGBFromHex(subRGB);
-            _ledPixels.setRGB(segmentIdx, i, rgb.r, rgb.g, rgb.b, true);
+            pixSetRGB(segmentIdx, i, rgb.r, rgb.g, rgb.b, true);
         }
 
         // Show
-        _ledPixels.show();
+        pixShow();
         rslt = true;
     }
     else if (cmd.equalsIgnoreCase("setledsidx"))
     {
         // Stop any pattern
-        _ledPixels.stopPattern(segmentIdx, false);
+        pixStopPattern(segmentIdx);
 
         // Check minimum length (at least clear flag)
         if (data.length() < 1)
@@ -237,7 +264,7 @@ RaftRetCode ScaderLEDPixels::apiControl(const String &reqStr, String &respStr, c
         bool clearFirst = (data.charAt(0) == '1');
         if (clearFirst)
         {
-            _ledPixels.clear(false);
+            pixClear(false);
         }
 
         // Determine mode based on data length
@@ -275,10 +302,10 @@ RaftRetCode ScaderLEDPixels::apiControl(const String &reqStr, String &respStr, c
             uint32_t ledIdx = strtol(indexStr.c_str(), NULL, 16);
             
             // Validate index bounds
-            if (ledIdx >= _ledPixels.getNumPixels(segmentIdx))
+            if (ledIdx >= pixGetNumPixels(segmentIdx))
             {
                 LOG_W(MODULE_PREFIX, "setledsidx: LED index %d out of bounds (max %d)", 
-                      ledIdx, _ledPixels.getNumPixels(segmentIdx) - 1);
+                      ledIdx, pixGetNumPixels(segmentIdx) - 1);
                 numLEDsSkipped++;
                 dataPos += charsPerLED;
                 continue;
@@ -292,14 +319,14 @@ RaftRetCode ScaderLEDPixels::apiControl(const String &reqStr, String &respStr, c
             // uint8_t w = isRGBW ? strtol(colorStr.substring(6, 8).c_str(), NULL, 16) : 0;
             
             // Set pixel (currently RGB only, W channel ignored for future RGBW support)
-            _ledPixels.setRGB(segmentIdx, ledIdx, r, g, b, false);
+            pixSetRGB(segmentIdx, ledIdx, r, g, b, false);
             numLEDsSet++;
             
             dataPos += charsPerLED;
         }
         
         // Show once at end
-        _ledPixels.show();
+        pixShow();
         
         // Log result
         LOG_I(MODULE_PREFIX, "setledsidx: mode=%s clear=%d set=%d skipped=%d",
@@ -310,7 +337,7 @@ RaftRetCode ScaderLEDPixels::apiControl(const String &reqStr, String &respStr, c
     else if (cmd.equalsIgnoreCase("setled") || cmd.equalsIgnoreCase("set"))
     {
         // Stop pattern
-        _ledPixels.stopPattern(segmentIdx, false);
+        pixStopPattern(segmentIdx);
 
         // Get LED and RGB for a single LED
         int ledID = strtol(data.c_str(), NULL, 10);
@@ -321,30 +348,30 @@ RaftRetCode ScaderLEDPixels::apiControl(const String &reqStr, String &respStr, c
 
         // Set pixel
         // LOG_I(MODULE_PREFIX, "setled %d %s r %d g %d b %d", ledID, rgbStr.c_str(), rgb.r, rgb.g, rgb.b);
-        _ledPixels.setRGB(segmentIdx, ledID, rgb.r, rgb.g, rgb.b, true);
-        _ledPixels.show();
+        pixSetRGB(segmentIdx, ledID, rgb.r, rgb.g, rgb.b, true);
+        pixShow();
         rslt = true;
     }
     else if (cmd.equalsIgnoreCase("off") || cmd.equalsIgnoreCase("clear"))
     {
         // Turn off all LEDs
-        _ledPixels.stopPattern(segmentIdx, false);
-        _ledPixels.clear(true);
+        pixStopPattern(segmentIdx);
+        pixClear(true);
         rslt = true;
     }
     else if (cmd.equalsIgnoreCase("pattern"))
     {
         // Set a named pattern
-        _ledPixels.clear(false);
-        _ledPixels.show();
-        _ledPixels.setPattern(segmentIdx, data, nameValuesJson.c_str());
+        pixClear(false);
+        pixShow();
+        pixSetPattern(segmentIdx, data, nameValuesJson.c_str());
         rslt = true;
     }
     else if (cmd.equalsIgnoreCase("listpatterns"))
     {
         // Get list of patterns
         std::vector<String> patternNames;
-        _ledPixels.getPatternNames(patternNames);
+        pixGetPatternNames(patternNames);
         String jsonResp;
         for (auto& name : patternNames)
         {
@@ -361,6 +388,8 @@ RaftRetCode ScaderLEDPixels::apiControl(const String &reqStr, String &respStr, c
 
 String ScaderLEDPixels::getStatusJSON() const
 {
+    if (_useSyncTx)
+        return "{" + _scaderCommon.getStatusJSON() + ",\"tx\":" + _syncStrips.getStatsJSON() + "}";
     return "{" + _scaderCommon.getStatusJSON() + "}"; 
 }
 
@@ -373,6 +402,114 @@ void ScaderLEDPixels::getStatusHash(std::vector<uint8_t>& stateHash)
     stateHash.clear();
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Pixel access - routed to LEDPixels or (in syncTx mode) the concurrently transmitting strips
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScaderLEDPixels::addPattern(const char* pName, SyncPatternCreateFn createFn)
+{
+    _ledPixels.addPattern(pName, createFn);
+    _syncPatterns.push_back({pName, createFn});
+}
+
+int32_t ScaderLEDPixels::pixGetSegmentIdx(const String& segmentName)
+{
+    // All strips form a single segment in syncTx mode
+    if (_useSyncTx)
+        return -1;
+    return _ledPixels.getSegmentIdx(segmentName);
+}
+
+uint32_t ScaderLEDPixels::pixGetNumSegments()
+{
+    return _useSyncTx ? 1 : _ledPixels.getNumSegments();
+}
+
+uint32_t ScaderLEDPixels::pixGetNumPixels(uint32_t segmentIdx)
+{
+    return _useSyncTx ? _syncStrips.getNumPixels() : _ledPixels.getNumPixels(segmentIdx);
+}
+
+void ScaderLEDPixels::pixSetRGB(uint32_t segmentIdx, uint32_t ledIdx, uint32_t r, uint32_t g, uint32_t b, bool applyBrightness)
+{
+    if (_useSyncTx)
+        _syncStrips.setRGB(ledIdx, r, g, b, applyBrightness);
+    else
+        _ledPixels.setRGB(segmentIdx, ledIdx, r, g, b, applyBrightness);
+}
+
+void ScaderLEDPixels::pixShow()
+{
+    if (_useSyncTx)
+        _syncStrips.show();
+    else
+        _ledPixels.show();
+}
+
+void ScaderLEDPixels::pixClear(bool showAfterClear)
+{
+    if (_useSyncTx)
+    {
+        _syncStrips.clear();
+        if (showAfterClear)
+            _syncStrips.show();
+    }
+    else
+    {
+        _ledPixels.clear(showAfterClear);
+    }
+}
+
+void ScaderLEDPixels::pixStopPattern(uint32_t segmentIdx)
+{
+    if (_useSyncTx)
+    {
+        delete _pSyncPattern;
+        _pSyncPattern = nullptr;
+    }
+    else
+    {
+        _ledPixels.stopPattern(segmentIdx, false);
+    }
+}
+
+void ScaderLEDPixels::pixSetPattern(uint32_t segmentIdx, const String& patternName, const char* pParamsJson)
+{
+    if (!_useSyncTx)
+    {
+        _ledPixels.setPattern(segmentIdx, patternName, pParamsJson);
+        return;
+    }
+    pixStopPattern(segmentIdx);
+    for (auto& pattern : _syncPatterns)
+    {
+        if (pattern.first.equalsIgnoreCase(patternName))
+        {
+            _pSyncPattern = pattern.second(nullptr, _syncStrips);
+            if (!_pSyncPattern)
+                return;
+
+            // Dithered fire output folds the strip brightness into its LUT rather than being scaled by the strips
+            if (pattern.second == &LEDPatternFire::create)
+                ((LEDPatternFire*)_pSyncPattern)->setStripBrightness(configGetLong("brightnessPC", 100));
+            _pSyncPattern->setup(pParamsJson);
+            return;
+        }
+    }
+}
+
+void ScaderLEDPixels::pixGetPatternNames(std::vector<String>& patternNames)
+{
+    if (!_useSyncTx)
+    {
+        _ledPixels.getPatternNames(patternNames);
+        return;
+    }
+    patternNames.clear();
+    for (auto& pattern : _syncPatterns)
+        patternNames.push_back(pattern.first);
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Clear all pixels
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -14,6 +14,7 @@
 #include "ScaderCommon.h"
 #include "RaftUtils.h"
 #include "LEDPixels.h"
+#include "LEDStripsRMT.h"
 
 class APISourceInfo;
 
@@ -53,6 +54,14 @@ private:
     // LED pixels
     LEDPixels _ledPixels;
 
+    // Concurrent transmission of all strips (config syncTx) - in this mode the strips are driven by
+    // _syncStrips rather than _ledPixels and a single pattern runs across all pixels
+    bool _useSyncTx = false;
+    LEDStripsRMT _syncStrips;
+    typedef LEDPatternBase* (*SyncPatternCreateFn)(NamedValueProvider* pNamedValueProvider, LEDPixelIF& pixels);
+    std::vector<std::pair<String, SyncPatternCreateFn>> _syncPatterns;
+    LEDPatternBase* _pSyncPattern = nullptr;
+
 #ifdef RUN_PATTERNS_IN_SYSMOD
     // Patterns
     enum LedStripPattern
@@ -82,6 +91,18 @@ private:
     void show();
     uint32_t totalNumPixels();
 
+    // Pixel access routed to _ledPixels or _syncStrips
+    void addPattern(const char* pName, SyncPatternCreateFn createFn);
+    int32_t pixGetSegmentIdx(const String& segmentName);
+    uint32_t pixGetNumSegments();
+    uint32_t pixGetNumPixels(uint32_t segmentIdx);
+    void pixSetRGB(uint32_t segmentIdx, uint32_t ledIdx, uint32_t r, uint32_t g, uint32_t b, bool applyBrightness);
+    void pixShow();
+    void pixClear(bool showAfterClear);
+    void pixStopPattern(uint32_t segmentIdx);
+    void pixSetPattern(uint32_t segmentIdx, const String& patternName, const char* pParamsJson);
+    void pixGetPatternNames(std::vector<String>& patternNames);
+
 #ifdef RUN_PATTERNS_IN_SYSMOD
     // Pattern locate
     static const uint32_t PATTERN_LOCATE_INITIAL_FLASHES = 3;
@@ -0,0 +1,134 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// DimmerTimingStats
+// Histogram of dimming event lateness (actual vs scheduled firing time relative to the predicted zero crossing)
+//
+// Bins are 4us wide up to 128us then double in width up to 64ms - events firing early or on time go in the
+// first bin. Recording is a handful of integer operations so it is safe to call from the timer ISR - the caller
+// provides any locking needed between recording and reading.
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "esp_attr.h"
+
+class DimmerTimingStats
+{
+public:
+    // Record an event fired latenessUs after its scheduled time (negative if early)
+    void IRAM_ATTR recordEvent(int32_t latenessUs)
+    {
+        _numEvents++;
+        _sumLatenessUs += latenessUs;
+        if ((_numEvents == 1) || (latenessUs < _minLatenessUs))
+            _minLatenessUs = latenessUs;
+        if ((_numEvents == 1) || (latenessUs > _maxLatenessUs))
+            _maxLatenessUs = latenessUs;
+        _bins[getBinIdx(latenessUs)]++;
+    }
+
+    // Record events that didn't fire before the next half-cycle started
+    void IRAM_ATTR recordMissed(uint32_t numMissed)
+    {
+        _numMissed += numMissed;
+    }
+
+    // Reset
+    void reset()
+    {
+        _numEvents = 0;
+        _numMissed = 0;
+        _sumLatenessUs = 0;
+        _minLatenessUs = 0;
+        _maxLatenessUs = 0;
+        memset(_bins, 0, sizeof(_bins));
+    }
+
+    // Counts
+    uint32_t getNumEvents() const
+    {
+        return _numEvents;
+    }
+    uint32_t getNumMissed() const
+    {
+        return _numMissed;
+    }
+
+    // Lateness
+    float getMeanUs() const
+    {
+        return _numEvents > 0 ? float(_sumLatenessUs) / _numEvents : 0;
+    }
+    int32_t getMinUs() const
+    {
+        return _minLatenessUs;
+    }
+    int32_t getMaxUs() const
+    {
+        return _maxLatenessUs;
+    }
+
+    // Percentile (upper edge of the bin containing it, limited to the max seen)
+    int32_t getPercentileUs(uint32_t percent) const
+    {
+        if (_numEvents == 0)
+            return 0;
+        uint64_t target = (uint64_t(_numEvents) * percent + 99) / 100;
+        uint64_t cumulative = 0;
+        for (uint32_t binIdx = 0; binIdx < NUM_BINS; binIdx++)
+        {
+            cumulative += _bins[binIdx];
+            if (cumulative >= target)
+            {
+                int32_t binUpperUs = getBinUpperUs(binIdx);
+                return binUpperUs < _maxLatenessUs ? binUpperUs : _maxLatenessUs;
+            }
+        }
+        return _maxLatenessUs;
+    }
+
+    // Histogram
+    static const uint32_t NUM_BINS = 41;
+    uint32_t getBinCount(uint32_t binIdx) const
+    {
+        return binIdx < NUM_BINS ? _bins[binIdx] : 0;
+    }
+    static int32_t getBinUpperUs(uint32_t binIdx)
+    {
+        if (binIdx < NUM_LINEAR_BINS)
+            return (binIdx + 1) * LINEAR_BIN_US - 1;
+        return (LINEAR_BIN_US * NUM_LINEAR_BINS << (binIdx - NUM_LINEAR_BINS + 1)) - 1;
+    }
+
+private:
+    // Linear bins (4us) up to 128us then doubling
+    static const uint32_t LINEAR_BIN_US = 4;
+    static const uint32_t NUM_LINEAR_BINS = 32;
+
+    // Stats
+    uint32_t _numEvents = 0;
+    uint32_t _numMissed = 0;
+    int64_t _sumLatenessUs = 0;
+    int32_t _minLatenessUs = 0;
+    int32_t _maxLatenessUs = 0;
+    uint32_t _bins[NUM_BINS] = {};
+
+    static uint32_t IRAM_ATTR getBinIdx(int32_t latenessUs)
+    {
+        if (latenessUs < int32_t(LINEAR_BIN_US * NUM_LINEAR_BINS))
+            return latenessUs <= 0 ? 0 : latenessUs / LINEAR_BIN_US;
+        uint32_t binIdx = NUM_LINEAR_BINS;
+        uint32_t upperUs = LINEAR_BIN_US * NUM_LINEAR_BINS * 2;
+        while ((uint32_t(latenessUs) >= upperUs) && (binIdx < NUM_BINS - 1))
+        {
+            upperUs <<= 1;
+            binIdx++;
+        }
+        return binIdx;
+    }
+};
@@ -0,0 +1,279 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// MainsSyncPLL
+// Phase-locked timing model for the mains sync edges used by SPIDimmer
+//
+// The model holds an estimate of the latest sync edge time and the half-cycle period. Each edge is matched to
+// the nearest predicted edge (so missing edges are counted rather than doubling the measured period) and the
+// phase error between the actual and predicted edge corrects both estimates (alpha-beta / second order PLL).
+// Edges well away from the prediction are rejected as noise and if no edge arrives the model can coast on its
+// prediction for a limited number of half-cycles. Once locked the window narrows to UNLOCK_ERR_US and a single
+// edge with a large error is held back - it only corrects the model if the next edge is out in the same
+// direction (a real phase step) so a lone noise edge near the prediction can't pull the firing times.
+//
+// Acquisition needs two consecutive similar intervals within the 50/60Hz range and the model reports lock once
+// the phase error has stayed small for several edges.
+//
+// All integer arithmetic (period is held in 1/256 us) - onEdge() and coast() are called from ISRs
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_attr.h"
+
+class MainsSyncPLL
+{
+public:
+    // Reset to unacquired
+    void IRAM_ATTR reset()
+    {
+        _isAcquired = false;
+        _isLocked = false;
+        _acqIntervalUs = 0;
+        _lastRawEdgeUs = 0;
+        _lockCount = 0;
+        _consecutiveRejects = 0;
+        _consecutiveCoasts = 0;
+        _outlierErrUs = 0;
+    }
+
+    // Sync edge at nowUs - returns true if the edge was accepted (and the edge estimate updated)
+    bool IRAM_ATTR onEdge(uint64_t nowUs)
+    {
+        _edgeCount++;
+
+        // Acquire from two consecutive similar intervals
+        if (!_isAcquired)
+        {
+            uint32_t intervalUs = _lastRawEdgeUs ? uint32_t(nowUs - _lastRawEdgeUs) : 0;
+            _lastRawEdgeUs = nowUs;
+            if ((intervalUs < PERIOD_MIN_US) || (intervalUs > PERIOD_MAX_US))
+            {
+                _acqIntervalUs = 0;
+                return false;
+            }
+            if ((_acqIntervalUs == 0) || (absDiff(intervalUs, _acqIntervalUs) > _acqIntervalUs / ACQUIRE_MATCH_DIV))
+            {
+                _acqIntervalUs = intervalUs;
+                return false;
+            }
+            _periodQ8 = ((intervalUs + _acqIntervalUs) << 8) / 2;
+            _edgeUs = nowUs;
+            _phaseErrUs = 0;
+            _isAcquired = true;
+            _lockCount = 0;
+            _consecutiveRejects = 0;
+            _consecutiveCoasts = 0;
+            _outlierErrUs = 0;
+            return true;
+        }
+
+        // Match to the nearest predicted edge
+        uint64_t sinceEdgeQ8 = (nowUs - _edgeUs) << 8;
+        uint32_t numPeriods = (sinceEdgeQ8 + _periodQ8 / 2) / _periodQ8;
+        if (numPeriods == 0)
+        {
+            // Too early to be the next edge
+            rejectEdge();
+            return false;
+        }
+        uint64_t predictedUs = _edgeUs + ((uint64_t(numPeriods) * _periodQ8) >> 8);
+        int32_t phaseErrUs = int32_t(nowUs - predictedUs);
+
+        // Reject edges outside the capture window
+        uint32_t absErrUs = phaseErrUs < 0 ? -phaseErrUs : phaseErrUs;
+        if (absErrUs > getWindowUs())
+        {
+            if (_isLocked)
+                unlockStep();
+            rejectEdge();
+            return false;
+        }
+
+        // When locked a large error must be seen on two consecutive edges (in the same direction) to be used
+        if (_isLocked && (absErrUs > LOCK_ERR_US))
+        {
+            bool confirmed = (_outlierErrUs != 0) && ((_outlierErrUs < 0) == (phaseErrUs < 0));
+            if (!confirmed)
+            {
+                _outlierErrUs = phaseErrUs;
+                rejectEdge();
+                return false;
+            }
+        }
+        _outlierErrUs = 0;
+        _consecutiveRejects = 0;
+        _consecutiveCoasts = 0;
+        if (numPeriods > 1)
+            _missedEdges += numPeriods - 1;
+
+        // Correct phase and period
+        _phaseErrUs = phaseErrUs;
+        _edgeUs = predictedUs + phaseErrUs / ALPHA_DIV;
+        int32_t periodAdjQ8 = (phaseErrUs * 256) / int32_t(numPeriods * BETA_DIV);
+        _periodQ8 += periodAdjQ8;
+        if (_periodQ8 < (PERIOD_MIN_US << 8))
+            _periodQ8 = PERIOD_MIN_US << 8;
+        if (_periodQ8 > (PERIOD_MAX_US << 8))
+            _periodQ8 = PERIOD_MAX_US << 8;
+
+        // Smoothed absolute phase error (1/16 us)
+        uint32_t absErrX16 = absErrUs << 4;
+        _phaseErrAvgX16 += (int32_t(absErrX16) - int32_t(_phaseErrAvgX16)) / 16;
+
+        // Lock detection (with hysteresis)
+        if (absErrUs <= LOCK_ERR_US)
+        {
+            if (_lockCount < LOCK_COUNT)
+                _lockCount++;
+            if (_lockCount >= LOCK_COUNT)
+                _isLocked = true;
+        }
+        else if (absErrUs > UNLOCK_ERR_US)
+        {
+            unlockStep();
+        }
+        return true;
+    }
+
+    // No edge has arrived by the expected time - advance the estimate by one period
+    // Returns false if coasted for too long (the model drops back to acquiring)
+    bool IRAM_ATTR coast()
+    {
+        if (!_isAcquired)
+            return false;
+        _missedEdges++;
+        if (++_consecutiveCoasts > MAX_COAST_HALF_CYCLES)
+        {
+            reset();
+            return false;
+        }
+        _edgeUs += _periodQ8 >> 8;
+        return true;
+    }
+
+    // Estimated time of the latest sync edge
+    uint64_t getEdgeUs() const
+    {
+        return _edgeUs;
+    }
+
+    // Time by which the next edge should have arrived (after which coasting is appropriate)
+    uint64_t getCoastDeadlineUs() const
+    {
+        uint32_t periodUs = _periodQ8 >> 8;
+        return _edgeUs + periodUs + (_isLocked ? UNLOCK_ERR_US : periodUs / LOCKED_WINDOW_DIV);
+    }
+
+    // Status
+    bool isAcquired() const
+    {
+        return _isAcquired;
+    }
+    bool isLocked() const
+    {
+        return _isLocked;
+    }
+    uint32_t getPeriodUs() const
+    {
+        return _periodQ8 >> 8;
+    }
+    float getPeriodUsFloat() const
+    {
+        return _periodQ8 / 256.0f;
+    }
+    int32_t getPhaseErrUs() const
+    {
+        return _phaseErrUs;
+    }
+    float getPhaseErrAvgUs() const
+    {
+        return _phaseErrAvgX16 / 16.0f;
+    }
+    uint32_t getEdgeCount() const
+    {
+        return _edgeCount;
+    }
+    uint32_t getMissedEdges() const
+    {
+        return _missedEdges;
+    }
+    uint32_t getRejectedEdges() const
+    {
+        return _rejectedEdges;
+    }
+
+    // Half-cycle period range (covers 50Hz and 60Hz with drift)
+    static const uint32_t PERIOD_MIN_US = 7500;
+    static const uint32_t PERIOD_MAX_US = 11000;
+
+private:
+    // State
+    bool _isAcquired = false;
+    bool _isLocked = false;
+    uint64_t _edgeUs = 0;
+    uint32_t _periodQ8 = 10000 << 8;
+    int32_t _phaseErrUs = 0;
+    uint32_t _phaseErrAvgX16 = 0;
+
+    // Acquisition
+    uint64_t _lastRawEdgeUs = 0;
+    uint32_t _acqIntervalUs = 0;
+
+    // Lock detection
+    uint32_t _lockCount = 0;
+    uint32_t _consecutiveRejects = 0;
+    uint32_t _consecutiveCoasts = 0;
+
+    // Large phase error held back until confirmed by the next edge (0 if none)
+    int32_t _outlierErrUs = 0;
+
+    // Stats
+    uint32_t _edgeCount = 0;
+    uint32_t _missedEdges = 0;
+    uint32_t _rejectedEdges = 0;
+
+    // Loop gains (phase 1/4, period 1/32 of the phase error)
+    static const int32_t ALPHA_DIV = 4;
+    static const int32_t BETA_DIV = 32;
+
+    // Capture window (fraction of period either side of the prediction until locked, then UNLOCK_ERR_US)
+    static const uint32_t LOCKED_WINDOW_DIV = 8;
+    static const uint32_t ACQUIRED_WINDOW_DIV = 4;
+
+    // Acquisition intervals must match to 1/20 (5%)
+    static const uint32_t ACQUIRE_MATCH_DIV = 20;
+
+    // Lock thresholds
+    static const uint32_t LOCK_ERR_US = 150;
+    static const uint32_t UNLOCK_ERR_US = 500;
+    static const uint32_t LOCK_COUNT = 8;
+    static const uint32_t UNLOCK_STEP = 2;
+    static const uint32_t MAX_CONSECUTIVE_REJECTS = 10;
+    static const uint32_t MAX_COAST_HALF_CYCLES = 10;
+
+    uint32_t IRAM_ATTR getWindowUs() const
+    {
+        return _isLocked ? UNLOCK_ERR_US : (_periodQ8 >> 8) / ACQUIRED_WINDOW_DIV;
+    }
+    void IRAM_ATTR unlockStep()
+    {
+        _lockCount = _lockCount > UNLOCK_STEP ? _lockCount - UNLOCK_STEP : 0;
+        if (_lockCount == 0)
+            _isLocked = false;
+    }
+    void IRAM_ATTR rejectEdge()
+    {
+        _rejectedEdges++;
+        if (++_consecutiveRejects > MAX_CONSECUTIVE_REJECTS)
+            reset();
+    }
+    static uint32_t absDiff(uint32_t a, uint32_t b)
+    {
+        return a > b ? a - b : b - a;
+    }
+};
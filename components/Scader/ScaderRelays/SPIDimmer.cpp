@@ -4,20 +4,23 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <string.h>
+#include <math.h>
 #include "SPIDimmer.h"
 #include "driver/gpio.h"
+#include "hal/gpio_ll.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
 
 // #define DEBUG_MAINS_FREQ
 
-// TODO - investigate ESP_TIMER_ISR flag
+// Dispatch the esp_timer sequence callback from ISR (with the GPTimer ISR schedule mode available
+// via setup this is only relevant when that mode isn't used)
 // #define USE_ISR_FOR_TIMER_SEQUENCE
 
 // Use an extra timer to start the dimming sequence at a specific phase offset from zero cross
 // #define USE_ZERO_CROSS_OFFSET_TIMER
 
-// Adjust timing by monitoring difference from zero cross period start
-// #define ADJUST_TIMING_BASED_ON_ZERO_CROSS_PERIOD
-
 // #define TEST_ISR_USING_GPIO 5
 // #define TEST_DIMMING_TIMER_USING_GPIO 5
 // #define DEBUG_TIMING_SEQUENCE
@@ -32,6 +35,13 @@ SPIDimmer::SPIDimmer()
 /// @brief Destructor
 SPIDimmer::~SPIDimmer()
 {
+    if (_hGPTimer)
+    {
+        gptimer_stop(_hGPTimer);
+        gptimer_disable(_hGPTimer);
+        gptimer_del_timer(_hGPTimer);
+    }
+    teardownHWSPI();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -40,27 +50,33 @@ SPIDimmer::~SPIDimmer()
 /// @param spiSCLK SPI SCLK pin
 /// @param spiCSPins SPI CS pins
 /// @param mainsSyncPin Mains sync pin
-bool SPIDimmer::setup(int spiMOSI, int spiSCLK, std::vector<int>& spiCSPins, int mainsSyncPin)
+/// @param hwSPIHz Hardware SPI clock rate (0 to bit-bang the SPI pins)
+/// @param useISRSchedule Walk the dimming sequence from a GPTimer alarm ISR
+/// @note In ISR schedule mode the SPI pins are bit-banged with direct register writes as the
+///       SPI master driver can't be used from an ISR
+bool SPIDimmer::setup(int spiMOSI, int spiSCLK, std::vector<int>& spiCSPins, int mainsSyncPin, uint32_t hwSPIHz,
+            bool useISRSchedule)
 {
     // Check number of CS pins is less than or equal to 4
-    if (spiCSPins.size() > 4)
+    if (spiCSPins.size() > MAX_CHIPS)
     {
         LOG_E(MODULE_PREFIX, "Number of CS pins must be less than or equal to 4");
         return false;
     }
 
     // Check if already setup
-    if (_timerSeq.size() > 0)
+    if (_timerSeqs[0].entries.size() > 0)
     {
         LOG_E(MODULE_PREFIX, "Already setup");
         return false;
     }
 
-    // Setup channel values
-    _channelValuesPct.resize(spiCSPins.size() * NUM_CHANNELS_PER_CHIP, 0);
-
-    // Setup flag for any channel dimmed
-    _anyChannelOnChipDimmed.resize(spiCSPins.size(), false);    
+    // Setup channel levels and curves
+    _channelLevels.resize(spiCSPins.size() * NUM_CHANNELS_PER_CHIP, 0);
+    _channelCurves.resize(spiCSPins.size() * NUM_CHANNELS_PER_CHIP, CURVE_LINEAR);
+    _channelSeqPhases.resize(spiCSPins.size() * NUM_CHANNELS_PER_CHIP, NOT_IN_SEQ);
+    _channelFades.resize(spiCSPins.size() * NUM_CHANNELS_PER_CHIP);
+    buildCurveTables();
 
     // Save SPI pins
     _spiMOSI = spiMOSI;
@@ -68,9 +84,21 @@ bool SPIDimmer::setup(int spiMOSI, int spiSCLK, std::vector<int>& spiCSPins, int
     _spiCSPins = spiCSPins;
     _mainsSyncPin = mainsSyncPin;
     _useMainsSync = mainsSyncPin >= 0;
+    _useISRSchedule = useISRSchedule && _useMainsSync;
+
+    // Half bit time for fast bit-banging (125ns gives a 4MHz clock - NCV7240 max is 5MHz)
+    _fastSPIHalfBitCycles = esp_rom_get_cpu_ticks_per_us() / 8;
 
-    // Setup SPI pins
-    if ((_spiMOSI >= 0) && (_spiSCLK >= 0))
+    // Use the SPI peripheral if requested (falls back to bit-banging if it can't be setup)
+    if ((hwSPIHz > 0) && !_useISRSchedule && (_spiMOSI >= 0) && (_spiSCLK >= 0))
+    {
+        _useHWSPI = setupHWSPI(hwSPIHz);
+        if (!_useHWSPI)
+            LOG_W(MODULE_PREFIX, "setup hardware SPI failed - using bit-banged SPI");
+    }
+
+    // Setup SPI pins for bit-banging
+    if (!_useHWSPI && (_spiMOSI >= 0) && (_spiSCLK >= 0))
     {
         pinMode(_spiMOSI, OUTPUT);
         digitalWrite(_spiMOSI, LOW);
@@ -78,10 +106,10 @@ bool SPIDimmer::setup(int spiMOSI, int spiSCLK, std::vector<int>& spiCSPins, int
         digitalWrite(_spiSCLK, LOW);
     }
 
-    // Setup SPI CS pins
+    // Setup SPI CS pins (the SPI driver controls these when hardware SPI is used)
     for (int i = 0; i < _spiCSPins.size(); i++)
     {
-        if (_spiCSPins[i] >= 0)
+        if (!_useHWSPI && (_spiCSPins[i] >= 0))
         {
             pinMode(_spiCSPins[i], OUTPUT);
             digitalWrite(_spiCSPins[i], HIGH);
@@ -92,7 +120,8 @@ bool SPIDimmer::setup(int spiMOSI, int spiSCLK, std::vector<int>& spiCSPins, int
     if (_useMainsSync)
     {
         // Setup sequence entries
-        _timerSeq.resize(spiCSPins.size() * NUM_CHANNELS_PER_CHIP + 1);
+        for (TimerSeq& timerSeq : _timerSeqs)
+            timerSeq.entries.resize(spiCSPins.size() * NUM_CHANNELS_PER_CHIP + 1);
 
         // Setup timer for zero crossing offset mo mains sync edge time
     #ifdef USE_ZERO_CROSS_OFFSET_TIMER
@@ -107,18 +136,44 @@ bool SPIDimmer::setup(int spiMOSI, int spiSCLK, std::vector<int>& spiCSPins, int
     #endif
 
         // Setup timer for dimming
-        const esp_timer_create_args_t dimmingTimerArgs = {
-            .callback = &dimmingTimerCallbackStatic,
-            .arg = this,
-    #ifdef USE_ISR_FOR_TIMER_SEQUENCE
-            .dispatch_method = ESP_TIMER_ISR,
-    #else
-            .dispatch_method = ESP_TIMER_TASK,
-    #endif
-            .name = "dimming_timer",
-            .skip_unhandled_events = 0
-        };
-        esp_timer_create(&dimmingTimerArgs, &_dimmingTimerHandle);
+        if (_useISRSchedule)
+        {
+            // GPTimer at 1MHz - the count is set to the time since the mains sync edge at each
+            // zero crossing and alarms are set for each sequence entry
+            gptimer_config_t gptimerConfig = {
+                .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+                .direction = GPTIMER_COUNT_UP,
+                .resolution_hz = 1000000,
+                .intr_priority = 0,
+                .flags = {}
+            };
+            gptimer_event_callbacks_t gptimerCallbacks = {
+                .on_alarm = gptimerAlarmISRStatic
+            };
+            if ((gptimer_new_timer(&gptimerConfig, &_hGPTimer) != ESP_OK) ||
+                (gptimer_register_event_callbacks(_hGPTimer, &gptimerCallbacks, this) != ESP_OK) ||
+                (gptimer_enable(_hGPTimer) != ESP_OK) ||
+                (gptimer_start(_hGPTimer) != ESP_OK))
+            {
+                LOG_E(MODULE_PREFIX, "setup GPTimer failed");
+                return false;
+            }
+        }
+        else
+        {
+            const esp_timer_create_args_t dimmingTimerArgs = {
+                .callback = &dimmingTimerCallbackStatic,
+                .arg = this,
+        #ifdef USE_ISR_FOR_TIMER_SEQUENCE
+                .dispatch_method = ESP_TIMER_ISR,
+        #else
+                .dispatch_method = ESP_TIMER_TASK,
+        #endif
+                .name = "dimming_timer",
+                .skip_unhandled_events = 0
+            };
+            esp_timer_create(&dimmingTimerArgs, &_dimmingTimerHandle);
+        }
 
         // Setup mains sync interrupt
         gpio_config_t io_conf = {
@@ -133,9 +188,6 @@ bool SPIDimmer::setup(int spiMOSI, int spiSCLK, std::vector<int>& spiCSPins, int
         gpio_isr_handler_add((gpio_num_t) _mainsSyncPin, mainsSyncISRStatic, this);
     }
 
-    // Initialize mains cycle period average
-    _zeroCrossPeriodUsAvg.sample(ZERO_CROSS_PERIOD_US_DEFAULT);
-
     // Debugging
 #ifdef TEST_ISR_USING_GPIO
     pinMode(TEST_ISR_USING_GPIO, OUTPUT);
@@ -155,21 +207,26 @@ bool SPIDimmer::setup(int spiMOSI, int spiSCLK, std::vector<int>& spiCSPins, int
 /// @brief Loop (called frequently)
 void SPIDimmer::loop()
 {
-    // Check if mains cycle period is valid for the first time
-    if (!_mainsCyclePeriodSet && (_mainsCyclePeriodValid || !_useMainsSync))
+    // Check if mains sync has become valid (or invalid) - dimmed channels are off without mains sync
+    bool mainsSyncValid = _mainsCyclePeriodValid || !_useMainsSync;
+    if ((!_mainsCyclePeriodSet && mainsSyncValid) || (_mainsCyclePeriodSet && (mainsSyncValid != _mainsCyclePeriodValidApplied)))
     {
         // Set flag indicating mains cycle period is set
         _mainsCyclePeriodSet = true;
+        _mainsCyclePeriodValidApplied = mainsSyncValid;
 
         // Set values (if no mains sync) or recalculate timer sequence
         setValuesOrRecalculateTimerSequence();
     }
 
+    // Step any fading channels
+    serviceFades();
+
 #ifdef DEBUG_MAINS_FREQ
     if (Raft::isTimeout(millis(), _debugLastLoopMs, 1000))
     {
-        LOG_I(MODULE_PREFIX, "Mains freq: %f Hz _mainsCyclePeriodValid %d _mainsCyclePeriodSet %d _useMainsSync %d", 
-                getMainsHz(), _mainsCyclePeriodValid, _mainsCyclePeriodSet, _useMainsSync);
+        LOG_I(MODULE_PREFIX, "Mains freq: %f Hz _mainsCyclePeriodValid %d _mainsCyclePeriodSet %d _useMainsSync %d sync %s", 
+                getMainsHz(), _mainsCyclePeriodValid, _mainsCyclePeriodSet, _useMainsSync, getSyncStatusJSON().c_str());
         _debugLastLoopMs = millis();
     }
 #endif
@@ -178,35 +235,236 @@ void SPIDimmer::loop()
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief Set channel value in percent
 /// @param channelNum Channel index (0 based)
-/// @param valuePct Value in percent
-void SPIDimmer::setChannelValue(uint32_t channelIdx, uint32_t valuePct)
+/// @param valuePct Value in percent (resolution 0.1%)
+/// @param fadeMs Fade time in ms (0 to set immediately)
+void SPIDimmer::setChannelValue(uint32_t channelIdx, float valuePct, uint32_t fadeMs)
+{
+    // Set values (if no mains sync) or recalculate timer sequence
+    if (setChannelLevel(channelIdx, valuePct, fadeMs))
+        setValuesOrRecalculateTimerSequence();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Set several channel values in percent
+/// @param pChannelIdxs Channel indices (0 based)
+/// @param pValuesPct Values in percent (resolution 0.1%)
+/// @param numChannels Number of channels
+/// @param fadeMs Fade time in ms (0 to set immediately)
+/// @note The SPI data is sent or the timer sequence recalculated once for all channels
+void SPIDimmer::setChannelValues(const uint32_t* pChannelIdxs, const float* pValuesPct, uint32_t numChannels, uint32_t fadeMs)
+{
+    bool anyChanged = false;
+    for (uint32_t i = 0; i < numChannels; i++)
+    {
+        if (setChannelLevel(pChannelIdxs[i], pValuesPct[i], fadeMs))
+            anyChanged = true;
+    }
+    if (anyChanged)
+        setValuesOrRecalculateTimerSequence();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Set channel level or start a fade
+/// @param channelIdx Channel index (0 based)
+/// @param valuePct Value in percent (resolution 0.1%)
+/// @param fadeMs Fade time in ms (0 to set immediately)
+/// @return true if the level was set (and the outputs need updating)
+bool SPIDimmer::setChannelLevel(uint32_t channelIdx, float valuePct, uint32_t fadeMs)
 {
     // Validate channel number
-    if (channelIdx >= _channelValuesPct.size())
-        return;
+    if (channelIdx >= _channelLevels.size())
+        return false;
 
     // Validate value
-    if ((valuePct > 100) || (!_useMainsSync && (valuePct != 0)))
-        valuePct = 100;
+    uint32_t level = valuePct <= 0 ? 0 : uint32_t(valuePct * LEVEL_MAX / 100 + 0.5f);
+    if ((level > LEVEL_MAX) || (!_useMainsSync && (level != 0)))
+        level = LEVEL_MAX;
 
-    // Save the channel value
-    _channelValuesPct[channelIdx] = valuePct;
+    // Cancel any fade in progress
+    ChannelFade& fade = _channelFades[channelIdx];
+    if (fade.stepsLeft > 0)
+    {
+        fade.stepsLeft = 0;
+        _numChannelsFading--;
+    }
 
-    // Set values (if no mains sync) or recalculate timer sequence
-    setValuesOrRecalculateTimerSequence();
+    // Start a fade from the current level (only possible when dimming)
+    if ((fadeMs > 0) && _useMainsSync && _mainsCyclePeriodValid && (level != _channelLevels[channelIdx]))
+    {
+        uint32_t numSteps = uint64_t(fadeMs) * 1000 / _halfCyclePeriodUs;
+        if (numSteps < 1)
+            numSteps = 1;
+        if (_numChannelsFading == 0)
+            _fadeHalfCycleCount = _halfCycleCount;
+        fade.levelQ16 = int32_t(_channelLevels[channelIdx]) << 16;
+        fade.stepQ16 = ((int32_t(level) << 16) - fade.levelQ16) / int32_t(numSteps);
+        fade.stepsLeft = numSteps;
+        fade.targetLevel = level;
+        _numChannelsFading++;
+        return false;
+    }
+
+    // Save the channel level
+    _channelLevels[channelIdx] = level;
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Step fading channels by the number of half-cycles since last serviced
+/// @note Only the channels whose level changed are updated in the timer sequence
+void SPIDimmer::serviceFades()
+{
+    if (_numChannelsFading == 0)
+        return;
+
+    // Fades complete immediately if not dimming
+    bool isDimming = _useMainsSync && _mainsCyclePeriodValid;
+    uint32_t halfCycleCount = _halfCycleCount;
+    uint32_t elapsedSteps = isDimming ? halfCycleCount - _fadeHalfCycleCount : UINT32_MAX;
+    if (elapsedSteps == 0)
+        return;
+    _fadeHalfCycleCount = halfCycleCount;
+
+    // Step the fading channels
+    uint32_t changedIdxs[MAX_CHANNELS];
+    uint32_t numChanged = 0;
+    for (uint32_t i = 0; i < _channelFades.size(); i++)
+    {
+        ChannelFade& fade = _channelFades[i];
+        if (fade.stepsLeft == 0)
+            continue;
+        uint32_t numSteps = elapsedSteps < fade.stepsLeft ? elapsedSteps : fade.stepsLeft;
+        fade.stepsLeft -= numSteps;
+        fade.levelQ16 += fade.stepQ16 * int32_t(numSteps);
+        uint16_t level = fade.targetLevel;
+        if (fade.stepsLeft == 0)
+            _numChannelsFading--;
+        else
+            level = (fade.levelQ16 + 0x8000) >> 16;
+        if (level != _channelLevels[i])
+        {
+            _channelLevels[i] = level;
+            changedIdxs[numChanged++] = i;
+        }
+    }
+    if (numChanged == 0)
+        return;
+
+    // Update the sequence
+    if (isDimming)
+        updateTimerSequenceChannels(changedIdxs, numChanged);
+    else
+        setValuesOrRecalculateTimerSequence();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Set channel dimming curve
+/// @param channelIdx Channel index (0 based)
+/// @param curve Dimming curve
+void SPIDimmer::setChannelCurve(uint32_t channelIdx, DimmingCurve curve)
+{
+    if ((channelIdx >= _channelCurves.size()) || (curve >= NUM_CURVES) || (_channelCurves[channelIdx] == curve))
+        return;
+    _channelCurves[channelIdx] = curve;
+    if (_channelLevels[channelIdx] != 0)
+        setValuesOrRecalculateTimerSequence();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Set firing window
+/// @param minFiringPct Firing time (percent of half-cycle after zero crossing) for the highest dimmed level
+/// @param maxFiringPct Firing time (percent of half-cycle after zero crossing) for the lowest dimmed level
+/// @param mergeUs Channels whose firing times are within this are switched by a single event
+void SPIDimmer::setFiringWindow(float minFiringPct, float maxFiringPct, uint32_t mergeUs)
+{
+    _minFiringPct = minFiringPct < 0 ? 0 : (minFiringPct > 100 ? 100 : minFiringPct);
+    _maxFiringPct = maxFiringPct < _minFiringPct ? _minFiringPct : (maxFiringPct > 100 ? 100 : maxFiringPct);
+    _mergeUs = mergeUs;
+    buildCurveTables();
+    if (_channelLevels.size() > 0)
+        setValuesOrRecalculateTimerSequence();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 // Set timing
-void SPIDimmer::setTiming(uint32_t zeroCrossOffsetFromSyncUs, uint32_t valOffsetUs)
+void SPIDimmer::setTiming(uint32_t zeroCrossOffsetFromSyncUs)
 {
     // Set phase offset from zero cross
     if (zeroCrossOffsetFromSyncUs != UINT32_MAX)
         _zeroCrossOffsetFromSyncUs = zeroCrossOffsetFromSyncUs;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Build the firing phase table for each curve
+/// @note Levels between 0% and 100% map onto firing times from the max firing time (lowest level)
+///       to the min firing time (highest level) - the curve sets the shape between those
+void SPIDimmer::buildCurveTables()
+{
+    // Firing window as phase angles (0..PI is the half-cycle)
+    double minAngle = M_PI * _minFiringPct / 100;
+    double maxAngle = M_PI * _maxFiringPct / 100;
+
+    // Relative power delivered by leading edge phase control firing at angle a
+    auto powerAtAngle = [](double a) {
+        return 1 - a / M_PI + sin(2 * a) / (2 * M_PI);
+    };
+    double maxPower = powerAtAngle(minAngle);
+    double minPower = powerAtAngle(maxAngle);
 
-    // TODO - remove
-    if (valOffsetUs != UINT32_MAX)
-        _timerSeq[0].us = valOffsetUs;
+    for (uint32_t levelPct = 0; levelPct < CURVE_TABLE_SIZE; levelPct++)
+    {
+        double level = levelPct / 100.0;
+        for (uint32_t curve = 0; curve < NUM_CURVES; curve++)
+        {
+            double angle = maxAngle;
+            if (curve == CURVE_LINEAR)
+            {
+                angle = maxAngle - (maxAngle - minAngle) * level;
+            }
+            else if (curve == CURVE_LED)
+            {
+                angle = maxAngle - (maxAngle - minAngle) * level * level;
+            }
+            else
+            {
+                // Find the angle delivering the required power (power falls as the angle increases)
+                double targetPower = minPower + (maxPower - minPower) * level * level;
+                double lowAngle = minAngle;
+                double highAngle = maxAngle;
+                for (int i = 0; i < 24; i++)
+                {
+                    angle = (lowAngle + highAngle) / 2;
+                    if (powerAtAngle(angle) > targetPower)
+                        lowAngle = angle;
+                    else
+                        highAngle = angle;
+                }
+            }
+            double phase = angle / M_PI * PHASE_ONE;
+            _curvePhaseTables[curve][levelPct] = phase >= PHASE_ONE - 1 ? PHASE_ONE - 1 : uint16_t(phase);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Get firing phase for a channel
+/// @param channelIdx Channel index (0 based)
+/// @return Firing phase (1/65536ths of the half-cycle) quantised to the merge window
+uint16_t SPIDimmer::getFiringPhase(uint32_t channelIdx) const
+{
+    // Interpolate the curve table
+    const uint16_t* pTable = _curvePhaseTables[_channelCurves[channelIdx]];
+    uint32_t levelSteps = LEVEL_MAX / (CURVE_TABLE_SIZE - 1);
+    uint32_t tableIdx = _channelLevels[channelIdx] / levelSteps;
+    uint32_t frac = _channelLevels[channelIdx] % levelSteps;
+    uint32_t phase = tableIdx >= CURVE_TABLE_SIZE - 1 ? pTable[CURVE_TABLE_SIZE - 1] :
+                (pTable[tableIdx] * (levelSteps - frac) + pTable[tableIdx + 1] * frac) / levelSteps;
+
+    // Quantise to the merge window
+    uint32_t mergePhase = uint64_t(_mergeUs) * PHASE_ONE / (_halfCyclePeriodUs > 0 ? _halfCyclePeriodUs : ZERO_CROSS_PERIOD_US_DEFAULT);
+    if (mergePhase > 1)
+        phase = ((phase + mergePhase / 2) / mergePhase) * mergePhase;
+    return phase >= PHASE_ONE ? PHASE_ONE - 1 : phase;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -231,37 +489,64 @@ void IRAM_ATTR SPIDimmer::mainsSyncISR()
     if (!_sequencesValid)
         return;
 
-    // Calculate the zero cross period
-    uint64_t nowUs = esp_timer_get_time();
-#ifdef ADJUST_TIMING_BASED_ON_ZERO_CROSS_PERIOD
-    uint32_t timerCorrectionUs = 0;
-#endif
-    if (_lastMainsSyncUs > 0)
-    {
-        uint32_t zeroCrossingPeriod = nowUs - _lastMainsSyncUs;
-        _mainsCyclePeriodValid = zeroCrossingPeriod >= ZERO_CROSS_PERIOD_MIN_US && zeroCrossingPeriod <= ZERO_CROSS_PERIOD_MAX_US;
-        if (_mainsCyclePeriodValid)
-        {
-#ifdef ADJUST_TIMING_BASED_ON_ZERO_CROSS_PERIOD
-            timerCorrectionUs = _zeroCrossPeriodUsAvg.getAverage() - zeroCrossingPeriod;
-#endif
-            _zeroCrossPeriodUsAvg.sample(zeroCrossingPeriod);
-        }
-    }
+    // Update the timing model - rejected edges (noise) don't restart the sequence
+    portENTER_CRITICAL_ISR(&_mainsSyncMux);
+    bool edgeAccepted = _mainsSyncPLL.onEdge(esp_timer_get_time());
+    updateMainsSyncValid();
+    portEXIT_CRITICAL_ISR(&_mainsSyncMux);
+    if (edgeAccepted && _mainsCyclePeriodValid)
+        startHalfCycle();
+}
 
-    // Save the mains sync time
-    _lastMainsSyncUs = esp_timer_get_time();
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Start the dimming sequence for a half-cycle from the modelled sync edge
+void IRAM_ATTR SPIDimmer::startHalfCycle()
+{
+    // Timing is from the modelled edge rather than the ISR entry time
+    _lastMainsSyncUs = _mainsSyncPLL.getEdgeUs();
+    _halfCyclePeriodUs = _mainsSyncPLL.getPeriodUs();
 
 #ifdef USE_ZERO_CROSS_OFFSET_TIMER
     // Start the zero crossing offset timer
+    int32_t zeroCrossingFromNowUs = int32_t(_zeroCrossOffsetFromSyncUs) - int32_t(esp_timer_get_time() - _lastMainsSyncUs);
     esp_timer_stop(_zeroCrossTimerHandle);
-    esp_timer_start_once(_zeroCrossTimerHandle, _zeroCrossOffsetFromSyncUs + timerCorrectionUs);
+    esp_timer_start_once(_zeroCrossTimerHandle, zeroCrossingFromNowUs > 0 ? zeroCrossingFromNowUs : 1);
 #else
     // Use the zero cross timer callback directly
     zeroCrossTimerCallback();
 #endif
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Arm the flywheel - if no sync edge arrives by the model's deadline the next half-cycle
+///        is started from the predicted edge
+void IRAM_ATTR SPIDimmer::armFlywheel()
+{
+    uint64_t deadlineUs = _mainsSyncPLL.getCoastDeadlineUs();
+    if (_useISRSchedule)
+    {
+        setGPTimerAlarm(deadlineUs - _lastMainsSyncUs);
+        return;
+    }
+    int64_t delayUs = int64_t(deadlineUs) - esp_timer_get_time();
+    _dimmingTimerFlywheel = true;
+    esp_timer_stop(_dimmingTimerHandle);
+    esp_timer_start_once(_dimmingTimerHandle, delayUs > 0 ? delayUs : 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Flywheel deadline reached without a sync edge
+void IRAM_ATTR SPIDimmer::onFlywheel()
+{
+    // Check an edge hasn't arrived meanwhile (moving the deadline) and coast on the prediction
+    portENTER_CRITICAL_SAFE(&_mainsSyncMux);
+    bool coasting = (uint64_t(esp_timer_get_time()) >= _mainsSyncPLL.getCoastDeadlineUs()) && _mainsSyncPLL.coast();
+    updateMainsSyncValid();
+    portEXIT_CRITICAL_SAFE(&_mainsSyncMux);
+    if (coasting && _mainsCyclePeriodValid)
+        startHalfCycle();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief Zero cross timer callback static
 /// @param pArg Pointer to this object
@@ -274,34 +559,56 @@ void SPIDimmer::zeroCrossTimerCallbackStatic(void* pArg)
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief Zero cross timer callback
-void SPIDimmer::zeroCrossTimerCallback()
+/// @note Called from the mains sync ISR unless USE_ZERO_CROSS_OFFSET_TIMER is defined
+void IRAM_ATTR SPIDimmer::zeroCrossTimerCallback()
 {
     // Debug
 #ifdef TEST_ISR_USING_GPIO
     digitalWrite(TEST_ISR_USING_GPIO, HIGH);
 #endif
 
-    // Check if initial set required
-    if (_initialSetReqd)
+    // Start the half-cycle under the lock (the dimming timer callback snapshots this state) - count events of
+    // the previous half-cycle that didn't fire, swap in a recalculated sequence (this is the only place the
+    // active sequence changes) and start the sequence
+    portENTER_CRITICAL_SAFE(&_timerSeqMux);
+    uint32_t prevNumEntries = _timerSeqs[_activeSeqIdx].numEntries;
+    uint32_t numMissed = _timerSeqIdx < prevNumEntries ? prevNumEntries - _timerSeqIdx : 0;
+    swapInBackTimerSeq();
+    _timerSeqIdx = 0;
+    uint32_t halfCycleCount = ++_halfCycleCount;
+    portEXIT_CRITICAL_SAFE(&_timerSeqMux);
+    const TimerSeq& timerSeq = _timerSeqs[_activeSeqIdx];
+    if (numMissed > 0)
     {
-        // Send the SPI data for steady state
-        sendSPIData(_steadyStateData, true);
-
-        // Set flag indicating initial set not required
-        _initialSetReqd = false;
+        portENTER_CRITICAL_SAFE(&_timingStatsMux);
+        _timingStats.recordMissed(numMissed);
+        portEXIT_CRITICAL_SAFE(&_timingStatsMux);
     }
 
-    // Start sequence
-    _timerSeqIdx = 0;
+    // ISR schedule mode
+    if (_useISRSchedule)
+    {
+        // Check if initial set required
+        if (_initialSetReqd)
+        {
+            sendSPIData(timerSeq.steadyStateData, allChipsMask());
+            _initialSetReqd = false;
+        }
+
+        // Timer counts from the mains sync edge (which may be slightly in the future)
+        int64_t timeSinceSyncUs = int64_t(esp_timer_get_time()) - int64_t(_lastMainsSyncUs);
+        gptimer_set_raw_count(_hGPTimer, GPTIMER_SYNC_COUNT_OFFSET_US + timeSinceSyncUs);
+        if (timerSeq.numEntries > 0)
+            setGPTimerAlarm(_zeroCrossOffsetFromSyncUs + phaseToUs(timerSeq.entries[0].phase));
+        else
+            armFlywheel();
+    }
 
-    // Start the timer for the next sequence entry
-    if (_timerSeqIdx < _timerSeqTotal)
+    // Start the timer for the first sequence entry (or immediately if only the initial set is needed
+    // - SPI isn't sent from here as this may be ISR context)
+    else
     {
-        esp_timer_stop(_dimmingTimerHandle);
-        int32_t timeSinceSyncUs = esp_timer_get_time() - _lastMainsSyncUs;
-        int32_t zeroCrossingFromNowUs = int32_t(_zeroCrossOffsetFromSyncUs) - timeSinceSyncUs;
-        uint32_t timeToFirstEventUs = int32_t(_timerSeq[_timerSeqIdx].us) + zeroCrossingFromNowUs;
-        esp_timer_start_once(_dimmingTimerHandle, timeToFirstEventUs);
+        startDimmingTimer(timerSeq, 0, halfCycleCount);
     }
 
     // Debug
@@ -310,6 +617,20 @@ void SPIDimmer::zeroCrossTimerCallback()
 #endif
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Swap in the back timer sequence if one is ready
+/// @note Called with _timerSeqMux held
+void IRAM_ATTR SPIDimmer::swapInBackTimerSeq()
+{
+    if (_backSeqReady)
+    {
+        _activeSeqIdx ^= 1;
+        _backSeqReady = false;
+        if (_backSeqSetReqd)
+            _initialSetReqd = true;
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief Timer callback static (may be ISR if USE_ISR_FOR_TIMER_SEQUENCE is defined)
 /// @param pArg Pointer to this object
@@ -333,75 +654,358 @@ void SPIDimmer::dimmingTimerCallback()
     digitalWrite(TEST_DIMMING_TIMER_USING_GPIO, HIGH);
 #endif
 
-    // Send the SPI data
-    sendSPIData(_timerSeq[_timerSeqIdx].data, false);
+    // Check for flywheel (no sync edge by the deadline)
+    if (_dimmingTimerFlywheel)
+    {
+        _dimmingTimerFlywheel = false;
+        onFlywheel();
+        return;
+    }
+
+    // Snapshot the sequence, entry and half-cycle under the lock - the sync ISR starts each half-cycle
+    // (swapping the sequence and resetting the entry index) and may do so while this callback runs
+    portENTER_CRITICAL_SAFE(&_timerSeqMux);
+    uint32_t halfCycleCount = _halfCycleCount;
+    const TimerSeq& timerSeq = _timerSeqs[_activeSeqIdx];
+    uint32_t seqIdx = _timerSeqIdx;
+    bool isStale = _dimmingTimerHalfCycle != halfCycleCount;
+    bool initialSetReqd = _initialSetReqd && !isStale;
+    if (initialSetReqd)
+        _initialSetReqd = false;
+    portEXIT_CRITICAL_SAFE(&_timerSeqMux);
 
-    // Restore channels to steady state
-    sendSPIData(_steadyStateData, false);
+    // Timer armed in an earlier half-cycle - drop the event and make sure the current entry is timed
+    if (isStale)
+    {
+        startDimmingTimer(timerSeq, seqIdx, halfCycleCount);
+        return;
+    }
 
-    // Check if at end of sequence
-    _timerSeqIdx++;
-    if (_timerSeqIdx < _timerSeqTotal)
+    // Check if initial set required
+    if (initialSetReqd)
+        sendSPIData(timerSeq.steadyStateData, allChipsMask());
+
+    // Check sequence entry valid
+    if (seqIdx < timerSeq.numEntries)
+    {
+        // Record the event timing
+        recordEventTiming(esp_timer_get_time() - _lastMainsSyncUs, timerSeq.entries[seqIdx].phase);
+
+        // Send the SPI data (channels fully on in the dimmed chips stay on)
+        sendSPIData(timerSeq.entries[seqIdx].data & timerSeq.steadyStateData, timerSeq.chipsDimmedMask);
+
+        // Restore channels to steady state
+        sendSPIData(timerSeq.steadyStateData, timerSeq.chipsDimmedMask);
+        seqIdx++;
+    }
+
+    // Move on to the next entry unless the sync ISR started a new half-cycle meanwhile (it has reset the
+    // index and timed the new sequence)
+    portENTER_CRITICAL_SAFE(&_timerSeqMux);
+    bool isCurrent = _halfCycleCount == halfCycleCount;
+    if (isCurrent)
+        _timerSeqIdx = seqIdx;
+    portEXIT_CRITICAL_SAFE(&_timerSeqMux);
+    if (isCurrent)
+        startDimmingTimer(timerSeq, seqIdx, halfCycleCount);
+
+    // Debug
+#ifdef TEST_DIMMING_TIMER_USING_GPIO
+    digitalWrite(TEST_DIMMING_TIMER_USING_GPIO, LOW);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Start the dimming timer for a sequence entry (or arm the flywheel if the sequence is complete)
+/// @note Called from the sync ISR at the start of each half-cycle and from the timer callback
+/// @param timerSeq Active timer sequence
+/// @param seqIdx Index of the next entry
+/// @param halfCycleCount Half-cycle the entry belongs to
+void IRAM_ATTR SPIDimmer::startDimmingTimer(const TimerSeq& timerSeq, uint32_t seqIdx, uint32_t halfCycleCount)
+{
+    // Sequence complete - arm the flywheel unless the initial set is still to be sent
+    if ((seqIdx >= timerSeq.numEntries) && !_initialSetReqd)
+    {
+        armFlywheel();
+        return;
+    }
+
+    // Time until the entry from the zero crossing (or immediately for the initial set)
+    int32_t nextEventUs = 1;
+    if (seqIdx < timerSeq.numEntries)
     {
-        // Time since sequence started
         uint32_t timeSinceSyncUs = esp_timer_get_time() - _lastMainsSyncUs;
         int32_t timeSinceZeroCrossUs = timeSinceSyncUs - int32_t(_zeroCrossOffsetFromSyncUs);
+        nextEventUs = int32_t(phaseToUs(timerSeq.entries[seqIdx].phase)) - timeSinceZeroCrossUs;
+    }
 
-        // Calculate the time until the next sequence event
-        uint32_t nextEventUs = _timerSeq[_timerSeqIdx].us <= timeSinceZeroCrossUs ? 1 : _timerSeq[_timerSeqIdx].us - timeSinceZeroCrossUs;
+    // Start the timer
+    _dimmingTimerFlywheel = false;
+    _dimmingTimerHalfCycle = halfCycleCount;
+    esp_timer_stop(_dimmingTimerHandle);
+    esp_timer_start_once(_dimmingTimerHandle, nextEventUs > 0 ? nextEventUs : 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief GPTimer alarm ISR static
+/// @param hTimer Timer handle
+/// @param pEvent Alarm event data
+/// @param pArg Pointer to this object
+/// @return true if a higher priority task was woken
+bool IRAM_ATTR SPIDimmer::gptimerAlarmISRStatic(gptimer_handle_t hTimer, const gptimer_alarm_event_data_t* pEvent, void* pArg)
+{
+    SPIDimmer* pThis = (SPIDimmer*)pArg;
+    if (pThis)
+        return pThis->gptimerAlarmISR(pEvent->count_value);
+    return false;
+}
 
-        // Start the timer for the next sequence entry
-        esp_timer_stop(_dimmingTimerHandle);
-        esp_timer_start_once(_dimmingTimerHandle, nextEventUs);
+////////////////////////////////////////////////////////////////////////////////
+/// @brief GPTimer alarm ISR - fires the current sequence entry and sets the alarm for the next
+/// @param timerCountUs Timer count (offset us since mains sync edge) at the alarm
+/// @return true if a higher priority task was woken
+bool IRAM_ATTR SPIDimmer::gptimerAlarmISR(uint64_t timerCountUs)
+{
+    // Alarm after the sequence is complete is the flywheel (no sync edge by the deadline)
+    const TimerSeq& timerSeq = _timerSeqs[_activeSeqIdx];
+    if (_timerSeqIdx >= timerSeq.numEntries)
+    {
+        onFlywheel();
+        return false;
     }
 
+    // Debug
+#ifdef TEST_DIMMING_TIMER_USING_GPIO
+    digitalWrite(TEST_DIMMING_TIMER_USING_GPIO, HIGH);
+#endif
+
+    // Record the event timing (the timer counts from the mains sync edge)
+    uint64_t nowCountUs = timerCountUs;
+    gptimer_get_raw_count(_hGPTimer, &nowCountUs);
+    recordEventTiming(nowCountUs - GPTIMER_SYNC_COUNT_OFFSET_US, timerSeq.entries[_timerSeqIdx].phase);
+
+    // Send the SPI data (channels fully on in the dimmed chips stay on) and restore channels to steady state
+    sendSPIData(timerSeq.entries[_timerSeqIdx].data & timerSeq.steadyStateData, timerSeq.chipsDimmedMask);
+    sendSPIData(timerSeq.steadyStateData, timerSeq.chipsDimmedMask);
+
+    // Set the alarm for the next entry
+    _timerSeqIdx++;
+    if (_timerSeqIdx < timerSeq.numEntries)
+        setGPTimerAlarm(_zeroCrossOffsetFromSyncUs + phaseToUs(timerSeq.entries[_timerSeqIdx].phase));
+    else
+        armFlywheel();
+
     // Debug
 #ifdef TEST_DIMMING_TIMER_USING_GPIO
     digitalWrite(TEST_DIMMING_TIMER_USING_GPIO, LOW);
 #endif
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Record the timing of a dimming event
+/// @param timeSinceSyncUs Time since the mains sync edge at which the event fired
+/// @param phase Firing phase of the event
+void IRAM_ATTR SPIDimmer::recordEventTiming(uint32_t timeSinceSyncUs, uint16_t phase)
+{
+    int32_t scheduledUs = _zeroCrossOffsetFromSyncUs + phaseToUs(phase);
+    portENTER_CRITICAL_SAFE(&_timingStatsMux);
+    _timingStats.recordEvent(int32_t(timeSinceSyncUs) - scheduledUs);
+    portEXIT_CRITICAL_SAFE(&_timingStatsMux);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Set GPTimer alarm
+/// @param alarmUs Alarm time (us since mains sync edge) - if already passed the alarm is set to fire immediately
+void IRAM_ATTR SPIDimmer::setGPTimerAlarm(uint64_t alarmUs)
+{
+    uint64_t nowCount = 0;
+    gptimer_get_raw_count(_hGPTimer, &nowCount);
+    uint64_t alarmCount = GPTIMER_SYNC_COUNT_OFFSET_US + alarmUs;
+    gptimer_alarm_config_t alarmConfig = {
+        .alarm_count = alarmCount > nowCount ? alarmCount : nowCount + 1,
+        .reload_count = 0,
+        .flags = {
+            .auto_reload_on_alarm = false
+        }
+    };
+    gptimer_set_alarm_action(_hGPTimer, &alarmConfig);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief Send SPI data
-void IRAM_ATTR SPIDimmer::sendSPIData(uint64_t spiData, bool forceSend)
+/// @param spiData Data for all chips (16 bits per chip)
+/// @param chipMask Bit mask of chips to send to
+void IRAM_ATTR SPIDimmer::sendSPIData(uint64_t spiData, uint32_t chipMask)
 {
-    // Send the SPI data for each chip
+    // Send the SPI data for each chip (chips without a CS pin aren't fitted)
     for (int chipIdx = 0; chipIdx < _spiCSPins.size(); chipIdx++)
     {
-        // Check if any channel is dimmed on the chip
-        if (forceSend || _anyChannelOnChipDimmed[chipIdx])
+        // Check if the chip is to be sent to
+        if ((chipMask & (1 << chipIdx)) && (_spiCSPins[chipIdx] >= 0))
         {
             // Write the sequence entry data to the chip
-            bitBangSPI16Tx(chipIdx, spiData);
+            if (_useHWSPI)
+                hwSPI16Tx(chipIdx, spiData);
+            else
+                fastBitBangSPI16Tx(chipIdx, spiData);
         }
     }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief Bit-bang SPI 16-bit transmit
+/// @brief Bit-bang SPI 16-bit transmit using direct GPIO register writes
 /// @param chipIdx Chip index
-/// @param data Data to transmit
-void IRAM_ATTR SPIDimmer::bitBangSPI16Tx(uint16_t chipIdx, uint64_t data)
+/// @param data Data to transmit (the chip's 16 bits are extracted as for bit-banging)
+/// @note Used whenever hardware SPI isn't - ISR safe and the half bit time is a CPU cycle count wait so a
+///       16-bit frame takes ~4us
+void IRAM_ATTR SPIDimmer::fastBitBangSPI16Tx(uint16_t chipIdx, uint64_t data)
 {
+    gpio_dev_t* pGPIO = GPIO_LL_GET_HW(GPIO_PORT_0);
+    uint16_t chipData = data >> (chipIdx * NUM_CHANNELS_PER_CHIP * NUM_BITS_PER_CHANNEL);
+    auto halfBitWait = [this]() {
+        uint32_t startCycles = esp_cpu_get_cycle_count();
+        while (esp_cpu_get_cycle_count() - startCycles < _fastSPIHalfBitCycles)
+            ;
+    };
+
     // Select the chip
-    digitalWrite(_spiCSPins[chipIdx], LOW);
-    
-    // Shift the data for the specific chip
-    data = data >> (chipIdx * NUM_CHANNELS_PER_CHIP * NUM_BITS_PER_CHANNEL);
-    
-    // Transmit the data
+    gpio_ll_set_level(pGPIO, _spiCSPins[chipIdx], 0);
+    halfBitWait();
+
+    // Transmit the data MSB first
     for (int i = 0; i < NUM_CHANNELS_PER_CHIP * NUM_BITS_PER_CHANNEL; i++)
     {
-        digitalWrite(_spiMOSI, (data & 0x8000) ? HIGH : LOW);
-        digitalWrite(_spiSCLK, HIGH);
-        delayMicroseconds(1);
-        digitalWrite(_spiSCLK, LOW);
-        delayMicroseconds(1);
-        data <<= 1;
+        gpio_ll_set_level(pGPIO, _spiMOSI, (chipData & 0x8000) ? 1 : 0);
+        halfBitWait();
+        gpio_ll_set_level(pGPIO, _spiSCLK, 1);
+        halfBitWait();
+        gpio_ll_set_level(pGPIO, _spiSCLK, 0);
+        chipData <<= 1;
     }
 
     // Deselect the chip
-    digitalWrite(_spiCSPins[chipIdx], HIGH);
+    halfBitWait();
+    gpio_ll_set_level(pGPIO, _spiCSPins[chipIdx], 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Setup hardware SPI
+/// @param hwSPIHz SPI clock rate
+/// @return true if the SPI bus and a device for each chip are ready
+/// @note Fails if the bus is already initialised by another module (e.g. ScaderElecMeters
+///       on the same pins) - sharing it would hold dimming events up while that module
+///       has the bus acquired so the caller falls back to bit-banging
+bool SPIDimmer::setupHWSPI(uint32_t hwSPIHz)
+{
+    // SPI bus (MOSI and clock only - the NCV7240 status output isn't used)
+    spi_bus_config_t busCfg = {
+        .mosi_io_num = _spiMOSI,
+        .miso_io_num = GPIO_NUM_NC,
+        .sclk_io_num = _spiSCLK,
+        .quadwp_io_num = GPIO_NUM_NC,
+        .quadhd_io_num = GPIO_NUM_NC,
+        .data4_io_num = -1,
+        .data5_io_num = -1,
+        .data6_io_num = -1,
+        .data7_io_num = -1,
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 4, 0)
+        .data_io_default_level = false,
+#endif
+        .max_transfer_sz = 0,
+        .flags = 0,
+        .isr_cpu_id = ESP_INTR_CPU_AFFINITY_AUTO,
+        .intr_flags = 0,
+    };
+    esp_err_t err = spi_bus_initialize(HW_SPI_HOST, &busCfg, SPI_DMA_DISABLED);
+    if (err == ESP_ERR_INVALID_STATE)
+    {
+        LOG_W(MODULE_PREFIX, "setupHWSPI bus already in use by another module MOSI %d CLK %d", _spiMOSI, _spiSCLK);
+        return false;
+    }
+    if (err != ESP_OK)
+    {
+        LOG_E(MODULE_PREFIX, "setupHWSPI bus init failed MOSI %d CLK %d err %d", _spiMOSI, _spiSCLK, err);
+        return false;
+    }
+    _hwSPIBusOwned = true;
+
+    // Device for each chip - NCV7240 is CPOL = 0, CPHA = 1 with a 16-bit frame per chip
+    _hwSPIDevices.resize(_spiCSPins.size(), nullptr);
+    _hwSPITransactions.resize(_spiCSPins.size());
+    for (int chipIdx = 0; chipIdx < _spiCSPins.size(); chipIdx++)
+    {
+        if (_spiCSPins[chipIdx] < 0)
+            continue;
+        spi_device_interface_config_t devCfg = {
+            .command_bits = 0,
+            .address_bits = 0,
+            .dummy_bits = 0,
+            .mode = 1,
+            .clock_source = SPI_CLK_SRC_DEFAULT,
+            .duty_cycle_pos = 128,
+            .cs_ena_pretrans = 1,
+            .cs_ena_posttrans = 1,
+            .clock_speed_hz = (int)hwSPIHz,
+            .input_delay_ns = 0,
+            .sample_point = SPI_SAMPLING_POINT_PHASE_0,
+            .spics_io_num = _spiCSPins[chipIdx],
+            .flags = SPI_DEVICE_NO_DUMMY,
+            .queue_size = 1,
+            .pre_cb = nullptr,
+            .post_cb = nullptr
+        };
+        err = spi_bus_add_device(HW_SPI_HOST, &devCfg, &_hwSPIDevices[chipIdx]);
+        if (err != ESP_OK)
+        {
+            LOG_E(MODULE_PREFIX, "setupHWSPI add device failed chip %d CS %d err %d", chipIdx, _spiCSPins[chipIdx], err);
+            teardownHWSPI();
+            return false;
+        }
+
+        // Preload the transaction - only the two data bytes change per transfer
+        spi_transaction_t& trans = _hwSPITransactions[chipIdx];
+        memset(&trans, 0, sizeof(trans));
+        trans.flags = SPI_TRANS_USE_TXDATA;
+        trans.length = NUM_CHANNELS_PER_CHIP * NUM_BITS_PER_CHANNEL;
+    }
+
+    LOG_I(MODULE_PREFIX, "setupHWSPI ok MOSI %d CLK %d numChips %d clockHz %d",
+                _spiMOSI, _spiSCLK, _spiCSPins.size(), hwSPIHz);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Remove hardware SPI devices (and free the bus if this object initialised it)
+void SPIDimmer::teardownHWSPI()
+{
+    for (spi_device_handle_t& hDevice : _hwSPIDevices)
+    {
+        if (hDevice)
+            spi_bus_remove_device(hDevice);
+        hDevice = nullptr;
+    }
+    _hwSPIDevices.clear();
+    _hwSPITransactions.clear();
+    if (_hwSPIBusOwned)
+        spi_bus_free(HW_SPI_HOST);
+    _hwSPIBusOwned = false;
+    _useHWSPI = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Hardware SPI 16-bit transmit
+/// @param chipIdx Chip index
+/// @param data Data to transmit (the chip's 16 bits are extracted as for bit-banging)
+/// @note Polling transmit of the preloaded transaction avoids interrupt and task
+///       switch overhead - a 16-bit frame at 4MHz takes around 4us on the wire
+void SPIDimmer::hwSPI16Tx(uint16_t chipIdx, uint64_t data)
+{
+    uint16_t chipData = data >> (chipIdx * NUM_CHANNELS_PER_CHIP * NUM_BITS_PER_CHANNEL);
+    spi_transaction_t& trans = _hwSPITransactions[chipIdx];
+    trans.tx_data[0] = chipData >> 8;
+    trans.tx_data[1] = chipData & 0xff;
+    spi_device_polling_transmit(_hwSPIDevices[chipIdx], &trans);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -411,8 +1015,17 @@ void SPIDimmer::setValuesOrRecalculateTimerSequence()
     // Check if mains sync is used
     if (!_useMainsSync || !_mainsCyclePeriodValid)
     {
-        // Set values
-        sendSPIData(getSteadyStateSPIData(), true);
+        // Set values (in ISR schedule mode the pins are shared with the ISR so interrupts are held off)
+        if (_useISRSchedule)
+        {
+            portENTER_CRITICAL(&_timerSeqMux);
+            sendSPIData(getSteadyStateSPIData(), allChipsMask());
+            portEXIT_CRITICAL(&_timerSeqMux);
+        }
+        else
+        {
+            sendSPIData(getSteadyStateSPIData(), allChipsMask());
+        }
     }
     else
     {
@@ -429,11 +1042,10 @@ uint64_t SPIDimmer::getSteadyStateSPIData()
     // Calculate initial timer sequence entry which turns on all channels
     // that are at 100% brightness (and others off)
     uint64_t steadyStateData = UINT64_MAX;
-    for (int i = 0; i < _channelValuesPct.size(); i++)
+    for (int i = 0; i < _channelLevels.size(); i++)
     {
-        // Calculate dimmer level bin
-        uint32_t dimmerLevelBin = _channelValuesPct[i] / DIMMER_LEVEL_BIN_SIZE;
-        bool isMaxDimmerLevel = (dimmerLevelBin >= NUM_DIMMER_BINS-1);
+        // Check for fully on
+        bool isMaxDimmerLevel = _channelLevels[i] >= LEVEL_MAX;
 
         // Calculate initial bit sequence for all channels
         uint64_t bitField = isMaxDimmerLevel ? CHANNEL_ON_BIT_SEQ : CHANNEL_OFF_BIT_SEQ;
@@ -445,130 +1057,251 @@ uint64_t SPIDimmer::getSteadyStateSPIData()
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief Recalculate the timer sequence
+/// @note Dimmed channels with the same (merge window quantised) firing phase share a
+///       sequence entry so the number of SPI events is bounded by the firing window
+///       rather than the number of channels
+/// @note The sequence is built in place in the back buffer (whose entries are sized at setup)
+///       by insertion in order of firing phase - no allocation and bounded time for the
+///       number of channels
 void SPIDimmer::recalculateTimerSequence()
 {
-    // Sequence working variables
-    class DimmerLevelEntry
+    // Get the back sequence - any back sequence waiting to be swapped in is withdrawn first so it
+    // can't be swapped in while being rewritten
+    portENTER_CRITICAL(&_timerSeqMux);
+    _backSeqReady = false;
+    TimerSeq& timerSeq = _timerSeqs[_activeSeqIdx ^ 1];
+    portEXIT_CRITICAL(&_timerSeqMux);
+
+    // Clear the sequence
+    timerSeq.numEntries = 0;
+
+    // Add dimmed channels to the firing group for their firing phase
+    for (int i = 0; i < _channelLevels.size(); i++)
     {
-    public:
-        uint32_t dimmerLevelBin = 0;
-        std::vector<uint32_t> channelIdxs;
-    };
-    std::vector<DimmerLevelEntry> dimmerLevels;
+        // Check for dimmed (not off or fully on)
+        if ((_channelLevels[i] != 0) && (_channelLevels[i] < LEVEL_MAX) && _mainsCyclePeriodValid)
+        {
+            uint16_t phase = getFiringPhase(i);
+            addChannelToSeq(timerSeq, i, phase);
+            _channelSeqPhases[i] = phase;
+        }
+        else
+        {
+            _channelSeqPhases[i] = NOT_IN_SEQ;
+        }
+    }
 
-    // Clear any channel dimmed flag for each chip
-    for (int i = 0; i < _spiCSPins.size(); i++)
-        _anyChannelOnChipDimmed[i] = false;
+    // Save steady state data and chips with any channel dimmed
+    timerSeq.steadyStateData = getSteadyStateSPIData();
+    timerSeq.chipsDimmedMask = getChipsDimmedMask();
 
-    // Calculate initial timer sequence entry which turns on all channels
-    // that are at 100% brightness (and others off)
-    for (int i = 0; i < _channelValuesPct.size(); i++)
-    {
-        // Calculate dimmer level bin
-        uint32_t dimmerLevelBin = _channelValuesPct[i] / DIMMER_LEVEL_BIN_SIZE;
-        bool isMaxDimmerLevel = (dimmerLevelBin >= NUM_DIMMER_BINS-1);
+    // Back sequence is ready to be swapped in at the next zero crossing
+    portENTER_CRITICAL(&_timerSeqMux);
+    _backSeqReady = true;
+    _backSeqSetReqd = true;
+    portEXIT_CRITICAL(&_timerSeqMux);
 
-        // Set any channel dimmed flag for each chip
-        if ((_channelValuesPct[i] != 0) && (!isMaxDimmerLevel) && _mainsCyclePeriodValid)
+    // Debug
+#ifdef DEBUG_TIMING_SEQUENCE
+    String anyChannelDimmedStr;
+    for (int i = 0; i < _spiCSPins.size(); i++)
+    {
+        anyChannelDimmedStr += " [" + String(i) + ((timerSeq.chipsDimmedMask & (1 << i)) ? "]=Y" : "]=N");
+    }
+    LOG_I(MODULE_PREFIX, "Initial data: 0x%016llx anyDimmed:%s", timerSeq.steadyStateData, anyChannelDimmedStr.c_str());
+    for (int i = 0; i < timerSeq.numEntries; i++)
+    {
+        String channelIdxsStr;
+        for (int j = 0; j < _channelSeqPhases.size(); j++)
         {
-            // Set flag
-            _anyChannelOnChipDimmed[i / NUM_CHANNELS_PER_CHIP] = true;
-
-            // Insert the channel into the dimmer level entry table, keeping it in order
-            // from highest to lowest dimmer level bin
-            bool found = false;
-            for (int j = 0; j < dimmerLevels.size(); j++)
-            {
-                if (dimmerLevels[j].dimmerLevelBin == dimmerLevelBin)
-                {
-                    dimmerLevels[j].channelIdxs.push_back(i);
-                    found = true;
-                    break;
-                }
-                else if (dimmerLevels[j].dimmerLevelBin < dimmerLevelBin)
-                {
-                    DimmerLevelEntry newEntry;
-                    newEntry.dimmerLevelBin = dimmerLevelBin;
-                    newEntry.channelIdxs.push_back(i);
-                    dimmerLevels.insert(dimmerLevels.begin() + j, newEntry);
-                    found = true;
-                    break;
-                }
-            }
-            if (!found)
-            {
-                DimmerLevelEntry newEntry;
-                newEntry.dimmerLevelBin = dimmerLevelBin;
-                newEntry.channelIdxs.push_back(i);
-                dimmerLevels.push_back(newEntry);
-            }
+            if (_channelSeqPhases[j] == timerSeq.entries[i].phase)
+                channelIdxsStr += " " + String(j);
         }
+        LOG_I(MODULE_PREFIX, "Firing phase %u (%uus) data: 0x%016llx channels:%s", timerSeq.entries[i].phase,
+                phaseToUs(timerSeq.entries[i].phase), timerSeq.entries[i].data, channelIdxsStr.c_str());
     }
+#endif
+}
 
-    // Calculate the timer sequence entries for each dimmer level
-    uint32_t timingSeqTotal = 0;
-    std::vector<TimerSeqEntry> tempTimerSeq;
-    tempTimerSeq.reserve(dimmerLevels.size());
-    for (int i = 0; i < dimmerLevels.size(); i++)
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Update the timer sequence for changed channels
+/// @param pChannelIdxs Indices of channels whose level has changed
+/// @param numChannels Number of changed channels
+/// @note The latest sequence (a back sequence not yet swapped in or else a copy of the active
+///       sequence) is updated by moving each changed channel between firing groups - the
+///       steady state is only sent to the chips when swapped in if it has changed
+void SPIDimmer::updateTimerSequenceChannels(const uint32_t* pChannelIdxs, uint32_t numChannels)
+{
+    // Get the back sequence (withdrawing it if waiting to be swapped in)
+    portENTER_CRITICAL(&_timerSeqMux);
+    bool backSeqIsLatest = _backSeqReady;
+    bool setReqd = _backSeqReady && _backSeqSetReqd;
+    _backSeqReady = false;
+    const TimerSeq& activeSeq = _timerSeqs[_activeSeqIdx];
+    TimerSeq& timerSeq = _timerSeqs[_activeSeqIdx ^ 1];
+    portEXIT_CRITICAL(&_timerSeqMux);
+
+    // Copy the active sequence if the back sequence is stale
+    if (!backSeqIsLatest)
     {
-        // Calculate the dimmer level data
-        uint64_t dimmerLevelData = UINT64_MAX;
-        for (int j = 0; j < dimmerLevels[i].channelIdxs.size(); j++)
-        {
-            // Calculate the bit field for the channel
-            uint32_t channelIdx = dimmerLevels[i].channelIdxs[j];
-            dimmerLevelData &= ~(CHANNEL_MASK_BIT_SEQ << (channelIdx * NUM_BITS_PER_CHANNEL));
-            dimmerLevelData |= (CHANNEL_ON_BIT_SEQ << (channelIdx * NUM_BITS_PER_CHANNEL));
-        }
+        for (uint32_t i = 0; i < activeSeq.numEntries; i++)
+            timerSeq.entries[i] = activeSeq.entries[i];
+        timerSeq.numEntries = activeSeq.numEntries;
+        timerSeq.steadyStateData = activeSeq.steadyStateData;
+        timerSeq.chipsDimmedMask = activeSeq.chipsDimmedMask;
+    }
 
-        // Save the dimmer level data
-        tempTimerSeq[timingSeqTotal].data = dimmerLevelData;
+    // Move changed channels between firing groups
+    for (uint32_t i = 0; i < numChannels; i++)
+    {
+        uint32_t channelIdx = pChannelIdxs[i];
+        bool isDimmed = (_channelLevels[channelIdx] != 0) && (_channelLevels[channelIdx] < LEVEL_MAX);
+        uint32_t newPhase = isDimmed ? getFiringPhase(channelIdx) : NOT_IN_SEQ;
+        uint32_t oldPhase = _channelSeqPhases[channelIdx];
+        if (newPhase == oldPhase)
+            continue;
+        if (oldPhase != NOT_IN_SEQ)
+            removeChannelFromSeq(timerSeq, channelIdx, oldPhase);
+        if (newPhase != NOT_IN_SEQ)
+            addChannelToSeq(timerSeq, channelIdx, newPhase);
+        _channelSeqPhases[channelIdx] = newPhase;
+    }
 
-        // Calculate the time for the dimmer level
-        tempTimerSeq[timingSeqTotal].us = getDimmerUsForBin(dimmerLevels[i].dimmerLevelBin);
+    // Steady state and dimmed chips
+    uint64_t steadyStateData = getSteadyStateSPIData();
+    if (steadyStateData != timerSeq.steadyStateData)
+        setReqd = true;
+    timerSeq.steadyStateData = steadyStateData;
+    timerSeq.chipsDimmedMask = getChipsDimmedMask();
+
+    // Back sequence is ready to be swapped in at the next zero crossing
+    portENTER_CRITICAL(&_timerSeqMux);
+    _backSeqReady = true;
+    _backSeqSetReqd = setReqd;
+    portEXIT_CRITICAL(&_timerSeqMux);
+}
 
-        // Increment the total timer sequence entries
-        timingSeqTotal++;
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Add a channel to the firing group at a phase (inserting the group if required)
+/// @param timerSeq Timer sequence
+/// @param channelIdx Channel index
+/// @param phase Firing phase
+void SPIDimmer::addChannelToSeq(TimerSeq& timerSeq, uint32_t channelIdx, uint16_t phase)
+{
+    // Find the group or the position to insert it (in order of firing phase)
+    uint32_t entryIdx = 0;
+    while ((entryIdx < timerSeq.numEntries) && (timerSeq.entries[entryIdx].phase < phase))
+        entryIdx++;
+    if ((entryIdx >= timerSeq.numEntries) || (timerSeq.entries[entryIdx].phase != phase))
+    {
+        if (timerSeq.numEntries >= timerSeq.entries.size())
+            return;
+        for (uint32_t i = timerSeq.numEntries; i > entryIdx; i--)
+            timerSeq.entries[i] = timerSeq.entries[i - 1];
+        timerSeq.entries[entryIdx].phase = phase;
+        timerSeq.entries[entryIdx].data = UINT64_MAX;
+        timerSeq.numEntries++;
     }
 
-    // Set flag indicating sequences are not valid
-    _sequencesValid = false;
-    
-    // Save steady state data
-    _steadyStateData = getSteadyStateSPIData();
-
-    // Restart the timing sequence
-    _timerSeqIdx = 0;
+    // Set the channel on in the group
+    uint64_t& data = timerSeq.entries[entryIdx].data;
+    data &= ~(CHANNEL_MASK_BIT_SEQ << (channelIdx * NUM_BITS_PER_CHANNEL));
+    data |= (CHANNEL_ON_BIT_SEQ << (channelIdx * NUM_BITS_PER_CHANNEL));
+}
 
-    // Copy over temporary values for timing sequences
-    _timerSeqTotal = timingSeqTotal;
-    for (int i = 0; i < timingSeqTotal; i++)
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Remove a channel from the firing group at a phase (removing the group if empty)
+/// @param timerSeq Timer sequence
+/// @param channelIdx Channel index
+/// @param phase Firing phase
+void SPIDimmer::removeChannelFromSeq(TimerSeq& timerSeq, uint32_t channelIdx, uint16_t phase)
+{
+    for (uint32_t entryIdx = 0; entryIdx < timerSeq.numEntries; entryIdx++)
     {
-        _timerSeq[i] = tempTimerSeq[i];
-    }
+        if (timerSeq.entries[entryIdx].phase != phase)
+            continue;
 
-    // Set flag indicating sequences are valid
-    _sequencesValid = true;
-    _initialSetReqd = true;
+        // Set the channel off in the group (all channels off means the group is empty)
+        uint64_t& data = timerSeq.entries[entryIdx].data;
+        data |= (CHANNEL_OFF_BIT_SEQ << (channelIdx * NUM_BITS_PER_CHANNEL));
+        if (data == UINT64_MAX)
+        {
+            for (uint32_t i = entryIdx + 1; i < timerSeq.numEntries; i++)
+                timerSeq.entries[i - 1] = timerSeq.entries[i];
+            timerSeq.numEntries--;
+        }
+        return;
+    }
+}
 
-    // Debug
-#ifdef DEBUG_TIMING_SEQUENCE
-    String anyChannelDimmedStr;
-    for (int i = 0; i < _spiCSPins.size(); i++)
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Get mask of chips with any channel dimmed (in the latest built sequence)
+/// @return Bit mask of chips
+uint32_t SPIDimmer::getChipsDimmedMask() const
+{
+    uint32_t chipsDimmedMask = 0;
+    for (uint32_t i = 0; i < _channelSeqPhases.size(); i++)
     {
-        anyChannelDimmedStr += " [" + String(i) + (_anyChannelOnChipDimmed[i] ? "]=Y" : "]=N");
+        if (_channelSeqPhases[i] != NOT_IN_SEQ)
+            chipsDimmedMask |= 1 << (i / NUM_CHANNELS_PER_CHIP);
     }
-    LOG_I(MODULE_PREFIX, "Initial %s data: 0x%016llx anyDimmed:%s",
-            dimmerLevels.size() == _timerSeqTotal ? "OK" : "INVALID",
-            initialData, anyChannelDimmedStr.c_str());
-    for (int i = 0; i < dimmerLevels.size(); i++)
+    return chipsDimmedMask;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Get mains sync timing model status as JSON
+/// @return JSON object with lock state, period, last and average phase error and edge counts
+String SPIDimmer::getSyncStatusJSON() const
+{
+    char jsonStr[200];
+    snprintf(jsonStr, sizeof(jsonStr),
+            R"({"lock":%d,"acq":%d,"periodUs":%.1f,"errUs":%d,"errAvgUs":%.1f,"edges":%u,"missed":%u,"rejected":%u})",
+            _mainsSyncPLL.isLocked(), _mainsSyncPLL.isAcquired(), _mainsSyncPLL.getPeriodUsFloat(),
+            (int)_mainsSyncPLL.getPhaseErrUs(), _mainsSyncPLL.getPhaseErrAvgUs(),
+            (unsigned)_mainsSyncPLL.getEdgeCount(), (unsigned)_mainsSyncPLL.getMissedEdges(),
+            (unsigned)_mainsSyncPLL.getRejectedEdges());
+    return jsonStr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Get dimming event timing stats as JSON
+/// @param includeHistogram Include the histogram bins (upper edge in us and count for each non-empty bin)
+/// @return JSON string
+String SPIDimmer::getTimingStatsJSON(bool includeHistogram) const
+{
+    // Take a copy so the stats are consistent
+    portENTER_CRITICAL_SAFE(&_timingStatsMux);
+    DimmerTimingStats stats = _timingStats;
+    portEXIT_CRITICAL_SAFE(&_timingStatsMux);
+
+    char jsonStr[200];
+    snprintf(jsonStr, sizeof(jsonStr),
+            R"({"events":%u,"missed":%u,"meanUs":%.1f,"minUs":%d,"p50Us":%d,"p99Us":%d,"maxUs":%d)",
+            (unsigned)stats.getNumEvents(), (unsigned)stats.getNumMissed(), stats.getMeanUs(),
+            (int)stats.getMinUs(), (int)stats.getPercentileUs(50), (int)stats.getPercentileUs(99),
+            (int)stats.getMaxUs());
+    String json = jsonStr;
+    if (includeHistogram)
     {
-        String channelIdxsStr;
-        for (int j = 0; j < dimmerLevels[i].channelIdxs.size(); j++)
+        String binsStr;
+        for (uint32_t binIdx = 0; binIdx < DimmerTimingStats::NUM_BINS; binIdx++)
         {
-            channelIdxsStr += " " + String(dimmerLevels[i].channelIdxs[j]);
+            if (stats.getBinCount(binIdx) == 0)
+                continue;
+            if (binsStr.length() > 0)
+                binsStr += ",";
+            binsStr += "[" + String(DimmerTimingStats::getBinUpperUs(binIdx)) + "," + String(stats.getBinCount(binIdx)) + "]";
         }
-        LOG_I(MODULE_PREFIX, "Dimmer bin %u data: 0x%016llx us: %u channels:%s", dimmerLevels[i].dimmerLevelBin, _timerSeq[i].data, _timerSeq[i].us, channelIdxsStr.c_str());
+        json += ",\"hist\":[" + binsStr + "]";
     }
-#endif
+    return json + "}";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Reset dimming event timing stats
+void SPIDimmer::resetTimingStats()
+{
+    portENTER_CRITICAL_SAFE(&_timingStatsMux);
+    _timingStats.reset();
+    portEXIT_CRITICAL_SAFE(&_timingStatsMux);
 }
@@ -8,40 +8,90 @@
 
 #include "RaftArduino.h"
 #include "RaftUtils.h"
-#include "SimpleMovingAverage.h"
+#include "MainsSyncPLL.h"
+#include "DimmerTimingStats.h"
 #include <vector>
 #include "esp_timer.h"
+#include "driver/spi_master.h"
+#include "driver/gptimer.h"
+#include "freertos/FreeRTOS.h"
 
 class SPIDimmer
 {
 public:
+    // Dimming curves - map the channel level onto the firing angle within the firing window
+    //   LINEAR - conduction time proportional to level
+    //   LED - conduction time proportional to level squared (perceptual for LED lamps whose output follows conduction time)
+    //   INCANDESCENT - delivered power proportional to level squared (accounts for the sinusoidal power distribution)
+    enum DimmingCurve
+    {
+        CURVE_LINEAR,
+        CURVE_LED,
+        CURVE_INCANDESCENT,
+        NUM_CURVES
+    };
+    static DimmingCurve getCurveFromString(const String& curveStr)
+    {
+        if (curveStr.equalsIgnoreCase("led"))
+            return CURVE_LED;
+        if (curveStr.equalsIgnoreCase("incandescent"))
+            return CURVE_INCANDESCENT;
+        return CURVE_LINEAR;
+    }
+
     SPIDimmer();
     virtual ~SPIDimmer();
 
-    // Setup
-    bool setup(int spiMOSI, int spiSCLK, std::vector<int>& spiCSPins, int mainsSyncPin);
+    // Setup (hwSPIHz > 0 uses the SPI peripheral at that clock rate, 0 bit-bangs the SPI pins)
+    // useISRSchedule walks the dimming sequence from a GPTimer alarm ISR rather than an esp_timer task callback
+    bool setup(int spiMOSI, int spiSCLK, std::vector<int>& spiCSPins, int mainsSyncPin, uint32_t hwSPIHz = 0,
+                bool useISRSchedule = false);
 
     // Loop (called frequently)
     void loop();
 
-    // Set channel value in percent
-    void setChannelValue(uint32_t channelIdx, uint32_t valuePct);
+    // Set channel value in percent (resolution 0.1%) - fadeMs > 0 moves the channel to the value over that
+    // time by stepping its level every half-cycle (fades complete immediately without mains sync)
+    void setChannelValue(uint32_t channelIdx, float valuePct, uint32_t fadeMs = 0);
+
+    // Set several channel values (as setChannelValue) with a single sequence recalculation or SPI update
+    void setChannelValues(const uint32_t* pChannelIdxs, const float* pValuesPct, uint32_t numChannels, uint32_t fadeMs = 0);
+
+    // Check if any channel is fading
+    bool isFading() const { return _numChannelsFading > 0; }
+
+    // Set channel dimming curve
+    void setChannelCurve(uint32_t channelIdx, DimmingCurve curve);
+
+    // Set firing window (percent of the half-cycle after the zero crossing for the highest and lowest dimmed
+    // levels) and merge window (channels whose firing times are within this are switched by a single event)
+    void setFiringWindow(float minFiringPct, float maxFiringPct, uint32_t mergeUs);
 
     // Set timing
-    void setTiming(uint32_t zeroCrossOffsetFromSyncUs, uint32_t valOffsetUs);
+    void setTiming(uint32_t zeroCrossOffsetFromSyncUs);
 
     // Get zero crossing period in us
-    uint32_t getZeroCrossPeriodUs() const { return _zeroCrossPeriodUsAvg.getAverage(); }
+    uint32_t getZeroCrossPeriodUs() const { return _mainsSyncPLL.getPeriodUs(); }
 
     // Get mains frequency in Hz
-    float getMainsHz() const { return _mainsCyclePeriodValid ? (500000.0 / _zeroCrossPeriodUsAvg.getAverage()) : 0; }
+    float getMainsHz() const { return _mainsCyclePeriodValid ? (500000.0 / _mainsSyncPLL.getPeriodUsFloat()) : 0; }
 
     // Check if mains sync is valid
     bool isMainsSyncValid() const { return _mainsCyclePeriodValid; }
 
+    // Mains sync timing model status (lock state, phase error, etc) as JSON
+    String getSyncStatusJSON() const;
+
+    // Dimming event timing stats (lateness of each event against its scheduled time after the predicted
+    // zero crossing and events missed) as JSON - includeHistogram adds the histogram bin counts
+    String getTimingStatsJSON(bool includeHistogram) const;
+    void resetTimingStats();
+
 private:
     // Constants
+    static constexpr int MAX_CHIPS = 4;
     static constexpr int NUM_CHANNELS_PER_CHIP = 8;
+    static constexpr int MAX_CHANNELS = MAX_CHIPS * NUM_CHANNELS_PER_CHIP;
     static constexpr int NUM_BITS_PER_CHANNEL = 2;
     static constexpr uint64_t CHANNEL_ON_BIT_SEQ = 0b10;
     static constexpr uint64_t CHANNEL_OFF_BIT_SEQ = 0b11;
@@ -49,57 +99,135 @@ private:
 
     // Flag indicating that sequences are valid
     bool _sequencesValid = false;
-    bool _initialSetReqd = false;
+    volatile bool _initialSetReqd = false;
 
     // SPI pins
     int _spiMOSI = -1;
     int _spiSCLK = -1;
     std::vector<int> _spiCSPins;
 
+    // Hardware SPI - one device per chip (each with its own CS) and a preloaded transaction for each
+    static constexpr spi_host_device_t HW_SPI_HOST = SPI2_HOST;
+    bool _useHWSPI = false;
+    bool _hwSPIBusOwned = false;
+    std::vector<spi_device_handle_t> _hwSPIDevices;
+    std::vector<spi_transaction_t> _hwSPITransactions;
+
+    // GPTimer (1MHz, counting from the mains sync edge) used to walk the sequence in ISR mode - the count is
+    // offset as the modelled sync edge can be later than the edge that started the half-cycle
+    static constexpr uint64_t GPTIMER_SYNC_COUNT_OFFSET_US = 5000;
+    bool _useISRSchedule = false;
+    gptimer_handle_t _hGPTimer = nullptr;
+
     // Mains sync
     bool _useMainsSync = false;
     int _mainsSyncPin = -1;
 
-    // Dimmer bin timing values
-    static constexpr uint32_t NUM_DIMMER_BINS = 10;
-    float _dimmerBinTimingPct[NUM_DIMMER_BINS] = { 50.0, 47.5, 45.0, 40.0, 35.0, 32.5, 30.0, 25.0, 20.0, 0.1 };
-    static constexpr uint32_t DIMMER_LEVEL_BIN_SIZE = 100 / NUM_DIMMER_BINS;
+    // Channel levels are in 0.1% steps (LEVEL_MAX is fully on)
+    static constexpr uint32_t LEVEL_MAX = 1000;
+
+    // Firing phase is in 1/65536ths of the half-cycle after the zero crossing
+    static constexpr uint32_t PHASE_ONE = 65536;
+
+    // Firing window and merge window
+    static constexpr float MIN_FIRING_PCT_DEFAULT = 0.1;
+    static constexpr float MAX_FIRING_PCT_DEFAULT = 50.0;
+    static constexpr uint32_t MERGE_US_DEFAULT = 50;
+    float _minFiringPct = MIN_FIRING_PCT_DEFAULT;
+    float _maxFiringPct = MAX_FIRING_PCT_DEFAULT;
+    uint32_t _mergeUs = MERGE_US_DEFAULT;
+
+    // Firing phase for each curve at 1% steps of level (interpolated for finer levels)
+    static constexpr uint32_t CURVE_TABLE_SIZE = 101;
+    uint16_t _curvePhaseTables[NUM_CURVES][CURVE_TABLE_SIZE] = {};
 
     // Timing of zero crossings
+    // The sequence is timed from the modelled sync edge (_lastMainsSyncUs) rather than the ISR entry time
+    // and if an edge is missing the model's prediction is used (flywheel)
     static constexpr uint32_t ZERO_CROSS_PERIOD_US_DEFAULT = 10000;
-    static constexpr uint32_t ZERO_CROSS_PERIOD_MIN_US = (ZERO_CROSS_PERIOD_US_DEFAULT * 0.9);
-    static constexpr uint32_t ZERO_CROSS_PERIOD_MAX_US = (ZERO_CROSS_PERIOD_US_DEFAULT * 1.1);
-    uint64_t _lastMainsSyncUs = 0;
-    SimpleMovingAverage<50> _zeroCrossPeriodUsAvg;
+    MainsSyncPLL _mainsSyncPLL;
+    portMUX_TYPE _mainsSyncMux = portMUX_INITIALIZER_UNLOCKED;
+    volatile uint64_t _lastMainsSyncUs = 0;
+    volatile uint32_t _halfCyclePeriodUs = ZERO_CROSS_PERIOD_US_DEFAULT;
+    volatile bool _dimmingTimerFlywheel = false;
     bool _mainsCyclePeriodSet = false;
-    bool _mainsCyclePeriodValid = false;
+    bool _mainsCyclePeriodValidApplied = false;
+    volatile bool _mainsCyclePeriodValid = false;
     uint32_t _zeroCrossOffsetFromSyncUs = 3000;
 
     // Timer handles
     esp_timer_handle_t _zeroCrossTimerHandle = nullptr;
     esp_timer_handle_t _dimmingTimerHandle = nullptr;
 
-    // Channel values in percent
-    std::vector<uint8_t> _channelValuesPct;
-    std::vector<bool> _anyChannelOnChipDimmed;
-
-    // Steady-state data (non-dimmed channels are set on or off)
-    // Dimmed channels are set to the off state
-    uint64_t _steadyStateData = UINT64_MAX;
+    // Channel levels (0..LEVEL_MAX) and dimming curves
+    std::vector<uint16_t> _channelLevels;
+    std::vector<uint8_t> _channelCurves;
 
-    // Timer sequence entry
+    // Timer sequence entry - data is sent at the firing phase
     struct TimerSeqEntry
     {
-        uint32_t us = 0;
+        uint16_t phase = 0;
         uint64_t data = 0;
     };
 
-    // Timer sequence
-    std::vector<TimerSeqEntry> _timerSeq;
-    uint32_t _timerSeqTotal = 0;
+    // Timer sequence for a half-cycle
+    struct TimerSeq
+    {
+        // Entries (sized at setup) and number in use
+        std::vector<TimerSeqEntry> entries;
+        uint32_t numEntries = 0;
+
+        // Steady-state data (non-dimmed channels are set on or off)
+        // Dimmed channels are set to the off state
+        uint64_t steadyStateData = UINT64_MAX;
+
+        // Bit mask of chips with any channel dimmed
+        uint32_t chipsDimmedMask = 0;
+    };
+
+    // Double-buffered timer sequences - the sequence is recalculated into the back buffer
+    // and swapped in at the next zero crossing so a running sequence is never modified
+    // (_backSeqSetReqd indicates the steady state must be sent to all chips when swapped in)
+    TimerSeq _timerSeqs[2];
+    volatile uint32_t _activeSeqIdx = 0;
+    volatile bool _backSeqReady = false;
+    volatile bool _backSeqSetReqd = false;
+    portMUX_TYPE _timerSeqMux = portMUX_INITIALIZER_UNLOCKED;
 
     // Timer sequence index
-    int _timerSeqIdx = 0;
+    volatile uint32_t _timerSeqIdx = 0;
+
+    // Half-cycle (_halfCycleCount) in which the dimming timer was armed for a sequence entry - the timer
+    // callback drops an event armed before the sync ISR started the current half-cycle
+    volatile uint32_t _dimmingTimerHalfCycle = 0;
+
+    // Firing phase of each channel in the latest built sequence (NOT_IN_SEQ if not dimmed) so
+    // individual channels can be moved between firing groups without a full recalculation
+    static constexpr uint32_t NOT_IN_SEQ = UINT32_MAX;
+    std::vector<uint32_t> _channelSeqPhases;
+
+    // Fades - the level step per half-cycle is computed when the fade starts and the fading channels are
+    // stepped by the number of half-cycles elapsed each time the fades are serviced
+    struct ChannelFade
+    {
+        int32_t levelQ16 = 0;
+        int32_t stepQ16 = 0;
+        uint32_t stepsLeft = 0;
+        uint16_t targetLevel = 0;
+    };
+    std::vector<ChannelFade> _channelFades;
+    uint32_t _numChannelsFading = 0;
+    volatile uint32_t _halfCycleCount = 0;
+    uint32_t _fadeHalfCycleCount = 0;
+    void serviceFades();
+
+    // Set channel level or start a fade - returns true if the level changed immediately
+    bool setChannelLevel(uint32_t channelIdx, float valuePct, uint32_t fadeMs);
+
+    // Dimming event timing stats (recorded from the sequence walk which may be ISR context)
+    DimmerTimingStats _timingStats;
+    mutable portMUX_TYPE _timingStatsMux = portMUX_INITIALIZER_UNLOCKED;
+    void recordEventTiming(uint32_t timeSinceSyncUs, uint16_t phase);
 
     // Debug last loop timer
     uint32_t _debugLastLoopMs = 0;
@@ -112,26 +240,63 @@ private:
     static void zeroCrossTimerCallbackStatic(void* pArg);
     void zeroCrossTimerCallback();
 
+    // Half-cycle start (from the modelled sync edge) and flywheel for missing edges
+    void startHalfCycle();
+    void armFlywheel();
+    void onFlywheel();
+    void updateMainsSyncValid()
+    {
+        // Dimming starts once locked and continues while the model stays acquired
+        _mainsCyclePeriodValid = _mainsSyncPLL.isLocked() || (_mainsCyclePeriodValid && _mainsSyncPLL.isAcquired());
+    }
+
     // Dimming timer ISR
     static void dimmingTimerCallbackStatic(void* pArg);
     void dimmingTimerCallback();
+    void startDimmingTimer(const TimerSeq& timerSeq, uint32_t seqIdx, uint32_t halfCycleCount);
+
+    // GPTimer alarm ISR (ISR schedule mode)
+    static bool gptimerAlarmISRStatic(gptimer_handle_t hTimer, const gptimer_alarm_event_data_t* pEvent, void* pArg);
+    bool gptimerAlarmISR(uint64_t timerCountUs);
+    void setGPTimerAlarm(uint64_t alarmUs);
+
+    // Swap in the back timer sequence if one is ready (_timerSeqMux must be held)
+    void swapInBackTimerSeq();
+
+    // Bit-bang SPI 16-bit transmit using direct GPIO register writes (ISR safe)
+    void fastBitBangSPI16Tx(uint16_t chipIdx, uint64_t data);
+    uint32_t _fastSPIHalfBitCycles = 0;
 
-    // Bit-bang SPI 16-bit transmit
-    void bitBangSPI16Tx(uint16_t chipIdx, uint64_t data);
+    // Hardware SPI setup and 16-bit transmit
+    bool setupHWSPI(uint32_t hwSPIHz);
+    void teardownHWSPI();
+    void hwSPI16Tx(uint16_t chipIdx, uint64_t data);
 
-    // Send SPI data
-    void sendSPIData(uint64_t spiData, bool forceSend);
+    // Send SPI data to the chips in chipMask
+    void sendSPIData(uint64_t spiData, uint32_t chipMask);
+    uint32_t allChipsMask() const
+    {
+        return (1 << _spiCSPins.size()) - 1;
+    }
     
     // Set values (if no mains sync) or recalculate timer sequence (if mains sync)
     void setValuesOrRecalculateTimerSequence();
     void recalculateTimerSequence();
 
-    // Get dimmer us for specific bin
-    uint32_t getDimmerUsForBin(uint32_t binNum)
+    // Update the timer sequence for changed channels only (moving each between firing groups)
+    void updateTimerSequenceChannels(const uint32_t* pChannelIdxs, uint32_t numChannels);
+    static void addChannelToSeq(TimerSeq& timerSeq, uint32_t channelIdx, uint16_t phase);
+    static void removeChannelFromSeq(TimerSeq& timerSeq, uint32_t channelIdx, uint16_t phase);
+    uint32_t getChipsDimmedMask() const;
+
+    // Curves
+    void buildCurveTables();
+    uint16_t getFiringPhase(uint32_t channelIdx) const;
+
+    // Time after the zero crossing for a firing phase
+    uint32_t phaseToUs(uint16_t phase) const
     {
-        if (binNum >= NUM_DIMMER_BINS)
-            binNum = NUM_DIMMER_BINS - 1;
-        return (uint32_t) (_dimmerBinTimingPct[binNum] * _zeroCrossPeriodUsAvg.getAverage() / 100.0);
+        return (uint32_t(phase) * _halfCyclePeriodUs) >> 16;
     }
 
     // Get steady-state data for SPI command
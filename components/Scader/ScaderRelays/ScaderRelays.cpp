@@ -91,6 +91,8 @@ void ScaderRelays::setup()
     spiChipSelects[2] = configGetLong("SPI_CS3", -1);
     int mainsSyncPin = configGetLong("mainsSyncPin", -1);
     bool enableMainsSync = configGetBool("enableMainsSync", false);
+    uint32_t hwSPIHz = configGetBool("hwSPI", false) ? configGetLong("spiHz", DEFAULT_SPI_HZ) : 0;
+    bool isrSchedule = configGetBool("isrSchedule", false);
     
     // On/Off key pin
     _onOffKey = configGetLong("onOffKey", -1);
@@ -105,34 +107,41 @@ void ScaderRelays::setup()
         return;
     }
 
+    // Hardware SPI can't be shared with ScaderElecMeters - it uses the same SPI host (and pins on the standard
+    // hardware) and holds the bus while reading so bit-bang if that module is enabled
+    const RaftJsonIF& sysConfig = _scaderCommon.getSysConfig();
+    if ((hwSPIHz > 0) && sysConfig.getBool("ScaderElecMeters/enable", false))
+    {
+        LOG_E(MODULE_PREFIX, "setup hwSPI REFUSED - ScaderElecMeters is enabled on the same SPI bus (its MOSI %d CLK %d, ours MOSI %d CLK %d) - using bit-banged SPI",
+                (int)sysConfig.getLong("ScaderElecMeters/SPI_MOSI", -1), (int)sysConfig.getLong("ScaderElecMeters/SPI_CLK", -1),
+                spiMosi, spiClk);
+        hwSPIHz = 0;
+    }
+
     // Setup SPIDimmer
-    if (!_spiDimmer.setup(spiMosi, spiClk, spiChipSelects, enableMainsSync ? mainsSyncPin : -1))
+    if (!_spiDimmer.setup(spiMosi, spiClk, spiChipSelects, enableMainsSync ? mainsSyncPin : -1, hwSPIHz, isrSchedule))
     {
         LOG_E(MODULE_PREFIX, "setup FAILED SPIDimmer");
         return;
     }
 
+    // Dimming firing window (percent of half-cycle after zero crossing for highest and lowest levels)
+    const RaftJsonIF& config = configGetConfig();
+    _spiDimmer.setFiringWindow(config.getDouble("minFiringPct", 0.1), config.getDouble("maxFiringPct", 50),
+                config.getLong("mergeUs", 50));
+
+    // Default fade time for API changes
+    _defaultFadeMs = config.getLong("fadeMs", 0);
+
+    // Default dimming curve (linear, led or incandescent)
+    String defaultCurveStr = configGetString("dimCurve", "linear");
+
     // Clear states
     _elemStates.resize(_maxElems);
     std::fill(_elemStates.begin(), _elemStates.end(), 0);
 
-    // Set states from scader state
-    std::vector<String> elemStateStrs;
-    if (_scaderModuleState.getArrayElems("relayStates", elemStateStrs))
-    {
-        // Set states
-        for (int i = 0; i < elemStateStrs.size(); i++)
-        {
-            // Check if valid
-            if (i < _elemStates.size())
-                _elemStates[i] = getElemStateFromString(elemStateStrs[i]);
-
-            // Set channel value
-            _spiDimmer.setChannelValue(i, _elemStates[i]);
-        }
-    }
-
-    // Element names
+    // Element names and dimming curves (set before the states are restored so the dimming sequence is
+    // calculated once with the right curves)
     std::vector<String> elemInfos;
     if (configGetArrayElems("elems", elemInfos))
     {
@@ -145,17 +154,54 @@ void ScaderRelays::setup()
         {
             RaftJson elemInfo = elemInfos[i];
             _elemNames[i] = elemInfo.getString("name", ("Relay " + String(i+1)).c_str());
-            LOG_I(MODULE_PREFIX, "Relay %d name %s", i+1, _elemNames[i].c_str());
+            String curveStr = elemInfo.getString("curve", defaultCurveStr.c_str());
+            _spiDimmer.setChannelCurve(i, SPIDimmer::getCurveFromString(curveStr));
+            LOG_I(MODULE_PREFIX, "Relay %d name %s curve %s", i+1, _elemNames[i].c_str(), curveStr.c_str());
         }
     }
 
+    // Set states from scader state
+    std::vector<String> elemStateStrs;
+    if (_scaderModuleState.getArrayElems("relayStates", elemStateStrs))
+    {
+        // Set states (in one update)
+        std::vector<uint32_t> elemIdxs;
+        std::vector<uint32_t> states;
+        for (int i = 0; i < elemStateStrs.size(); i++)
+        {
+            elemIdxs.push_back(i);
+            states.push_back(getElemStateFromString(elemStateStrs[i]));
+        }
+        setElemStates(elemIdxs, states, 0);
+        _mutableDataDirty = false;
+    }
+
+    // Scenes
+    std::vector<String> sceneInfos;
+    if (configGetArrayElems("scenes", sceneInfos))
+    {
+        for (const String& sceneInfoStr : sceneInfos)
+        {
+            RaftJson sceneInfo = sceneInfoStr;
+            Scene scene;
+            scene.name = sceneInfo.getString("name", "");
+            std::vector<String> sceneStateStrs;
+            sceneInfo.getArrayElems("states", sceneStateStrs);
+            for (const String& sceneStateStr : sceneStateStrs)
+                scene.states.push_back(sceneStateStr.toInt());
+            if (scene.name.length() > 0)
+                _scenes.push_back(scene);
+        }
+        LOG_I(MODULE_PREFIX, "setup %d scenes", _scenes.size());
+    }
+
     // Debug
-    LOG_I(MODULE_PREFIX, "setup enabled scaderUIName %s maxRelays %d MOSI %d MISO %d CLK %d CS1 %d CS2 %d CS3 %d onOffKey %d",
+    LOG_I(MODULE_PREFIX, "setup enabled scaderUIName %s maxRelays %d MOSI %d MISO %d CLK %d CS1 %d CS2 %d CS3 %d onOffKey %d spiHz %d isrSchedule %s",
                 _scaderCommon.getUIName().c_str(),
                 _maxElems, 
                 spiMosi, spiMiso, spiClk, 
                 spiChipSelects[0], spiChipSelects[1], spiChipSelects[2], 
-                _onOffKey);
+                _onOffKey, hwSPIHz, isrSchedule ? "Y" : "N");
 
     // Debug show states
     debugShowCurrentState();
@@ -216,7 +262,12 @@ void ScaderRelays::addRestAPIEndpoints(RestAPIEndpointManager &endpointManager)
     // Control shade
     endpointManager.addEndpoint("relay", RestAPIEndpoint::ENDPOINT_CALLBACK, RestAPIEndpoint::ENDPOINT_GET,
                             std::bind(&ScaderRelays::apiControl, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3),
-                            "relay/<relay>/<state> relay is 1-based, state %% on/off (but 1 is full on)");
+                            "relay/<relay>/<state>?fadeMs=<ms> relay is 1-based (or a list e.g. 1,2,3), state %% on/off (but 1 is full on), fadeMs optional fade time, relay/timing[/reset] dimming timing stats");
+
+    // Scenes
+    endpointManager.addEndpoint("scene", RestAPIEndpoint::ENDPOINT_CALLBACK, RestAPIEndpoint::ENDPOINT_GET,
+                            std::bind(&ScaderRelays::apiScene, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3),
+                            "scene/<name>?fadeMs=<ms> set relays to a configured scene, scene lists the scenes");
     // LOG_I(MODULE_PREFIX, "addRestAPIEndpoints scader relays");
 }
 
@@ -233,9 +284,18 @@ RaftRetCode ScaderRelays::apiControl(const String &reqStr, String &respStr, cons
         return Raft::setJsonBoolResult(reqStr.c_str(), respStr, false);
     }
 
+    // Check for dimming timing stats request
+    String elemNumsStr = RestAPIEndpointManager::getNthArgStr(reqStr.c_str(), 1);
+    if (elemNumsStr.equalsIgnoreCase("timing"))
+    {
+        if (RestAPIEndpointManager::getNthArgStr(reqStr.c_str(), 2).equalsIgnoreCase("reset"))
+            _spiDimmer.resetTimingStats();
+        String timingJson = R"("timing":)" + _spiDimmer.getTimingStatsJSON(true);
+        return Raft::setJsonBoolResult(reqStr.c_str(), respStr, true, timingJson.c_str());
+    }
+
     // Get list of elems to control
     bool rslt = false;
-    String elemNumsStr = RestAPIEndpointManager::getNthArgStr(reqStr.c_str(), 1);
     std::vector<int> elemNums;
     if (elemNumsStr.length() > 0)
     { 
@@ -253,28 +313,23 @@ RaftRetCode ScaderRelays::apiControl(const String &reqStr, String &respStr, cons
     String relayCmdStr = RestAPIEndpointManager::getNthArgStr(reqStr.c_str(), 2);
     uint32_t newDimValue = getElemStateFromString(relayCmdStr);
 
-    // Execute command
-    uint32_t numElemsSet = 0;
+    // Get fade time (e.g. relay/3/40?fadeMs=2000)
+    uint32_t fadeMs = getFadeMsFromRequest(reqStr);
+
+    // Execute command (all relays are updated together)
+    std::vector<uint32_t> elemIdxs;
     for (auto elemNum : elemNums)
     {
         int elemIdx = elemNum - 1;
         if (elemIdx >= 0 && elemIdx < _elemNames.size())
-        {
-            // Set state
-            _elemStates[elemIdx] = newDimValue;
-            _mutableDataChangeLastMs = millis();
-            numElemsSet++;
-
-            // Set channel value
-            _spiDimmer.setChannelValue(elemIdx, newDimValue);
-        }
+            elemIdxs.push_back(elemIdx);
     }
+    std::vector<uint32_t> states(elemIdxs.size(), newDimValue);
+    uint32_t numElemsSet = setElemStates(elemIdxs, states, fadeMs);
 
     // Check something changed
     if (numElemsSet > 0)
     {
-        // Set relays
-        _mutableDataDirty = true;
         rslt = true;
         
         // Debug
@@ -304,6 +359,90 @@ RaftRetCode ScaderRelays::apiControl(const String &reqStr, String &respStr, cons
     return Raft::setJsonBoolResult(reqStr.c_str(), respStr, rslt);
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Scene via API
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+RaftRetCode ScaderRelays::apiScene(const String &reqStr, String &respStr, const APISourceInfo& sourceInfo)
+{
+    // Check init
+    if (!_isInitialised)
+        return Raft::setJsonBoolResult(reqStr.c_str(), respStr, false);
+
+    // List scenes if no name given
+    String sceneName = RestAPIEndpointManager::getNthArgStr(reqStr.c_str(), 1);
+    if (sceneName.length() == 0)
+    {
+        String scenesJson = R"("scenes":[)";
+        for (uint32_t i = 0; i < _scenes.size(); i++)
+            scenesJson += (i > 0 ? ",\"" : "\"") + _scenes[i].name + "\"";
+        scenesJson += "]";
+        return Raft::setJsonBoolResult(reqStr.c_str(), respStr, true, scenesJson.c_str());
+    }
+
+    // Find the scene
+    for (const Scene& scene : _scenes)
+    {
+        if (!scene.name.equalsIgnoreCase(sceneName))
+            continue;
+
+        // Apply the scene to all elements in one update
+        std::vector<uint32_t> elemIdxs;
+        std::vector<uint32_t> states;
+        for (uint32_t i = 0; (i < scene.states.size()) && (i < _elemNames.size()); i++)
+        {
+            if (scene.states[i] < 0)
+                continue;
+            elemIdxs.push_back(i);
+            states.push_back(scene.states[i]);
+        }
+        setElemStates(elemIdxs, states, getFadeMsFromRequest(reqStr));
+#ifdef DEBUG_RELAYS_API
+        LOG_I(MODULE_PREFIX, "apiScene %s set %d relays", scene.name.c_str(), elemIdxs.size());
+#endif
+        return Raft::setJsonBoolResult(reqStr.c_str(), respStr, true);
+    }
+    return Raft::setJsonErrorResult(reqStr.c_str(), respStr, "unknownScene");
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Set element states (the dimmer is updated once for all elements)
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t ScaderRelays::setElemStates(const std::vector<uint32_t>& elemIdxs, const std::vector<uint32_t>& states, uint32_t fadeMs)
+{
+    std::vector<float> valuesPct;
+    std::vector<uint32_t> channelIdxs;
+    for (uint32_t i = 0; (i < elemIdxs.size()) && (i < states.size()); i++)
+    {
+        uint32_t elemIdx = elemIdxs[i];
+        if (elemIdx >= _elemStates.size())
+            continue;
+        _elemStates[elemIdx] = states[i] > 100 ? 100 : states[i];
+        channelIdxs.push_back(elemIdx);
+        valuesPct.push_back(_elemStates[elemIdx]);
+    }
+    if (channelIdxs.size() == 0)
+        return 0;
+    _spiDimmer.setChannelValues(channelIdxs.data(), valuesPct.data(), channelIdxs.size(), fadeMs);
+    _mutableDataChangeLastMs = millis();
+    _mutableDataDirty = true;
+    return channelIdxs.size();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Get fade time from request parameters (e.g. ?fadeMs=2000)
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t ScaderRelays::getFadeMsFromRequest(const String &reqStr) const
+{
+    std::vector<String> params;
+    std::vector<RaftJson::NameValuePair> nameValues;
+    RestAPIEndpointManager::getParamsAndNameValues(reqStr.c_str(), params, nameValues);
+    RaftJson nameValuesJson = RaftJson::getJSONFromNVPairs(nameValues, true);
+    return nameValuesJson.getLong("fadeMs", _defaultFadeMs);
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Get JSON status
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -320,7 +459,8 @@ String ScaderRelays::getStatusJSON() const
     }
 
     // Get mains sync status
-    String mainsSyncJson = ",\"mainsHz\":" + String(_spiDimmer.getMainsHz(), 1);
+    String mainsSyncJson = ",\"mainsHz\":" + String(_spiDimmer.getMainsHz(), 1) + ",\"sync\":" + _spiDimmer.getSyncStatusJSON() +
+                ",\"timing\":" + _spiDimmer.getTimingStatsJSON(false);
 
     // Add base JSON
     return "{" + _scaderCommon.getStatusJSON() + mainsSyncJson + ",\"elems\":[" + elemStatus + "]}";
@@ -59,6 +59,12 @@ private:
     // Settings
     uint32_t _maxElems = DEFAULT_MAX_ELEMS;
 
+    // Default fade time for API changes (overridden by the fadeMs request parameter)
+    uint32_t _defaultFadeMs = 0;
+
+    // SPI clock rate for the NCV7240 relay drivers (5MHz max)
+    static const uint32_t DEFAULT_SPI_HZ = 4000000;
+
     // On/Off Key
     int _onOffKey = -1;
 
@@ -68,6 +74,14 @@ private:
     // Current state of elements
     std::vector<uint8_t> _elemStates;
 
+    // Scenes (state for each element, -1 leaves the element unchanged)
+    struct Scene
+    {
+        String name;
+        std::vector<int32_t> states;
+    };
+    std::vector<Scene> _scenes;
+
     // Mutable data saving
     static const uint32_t MUTABLE_DATA_SAVE_MIN_MS = 5000;
     uint32_t _mutableDataChangeLastMs = 0;
@@ -76,6 +90,9 @@ private:
     // Helper functions
     void deinit();
     RaftRetCode apiControl(const String &reqStr, String &respStr, const APISourceInfo& sourceInfo);
+    RaftRetCode apiScene(const String &reqStr, String &respStr, const APISourceInfo& sourceInfo);
+    uint32_t setElemStates(const std::vector<uint32_t>& elemIdxs, const std::vector<uint32_t>& states, uint32_t fadeMs);
+    uint32_t getFadeMsFromRequest(const String &reqStr) const;
     void saveMutableData();
     void debugShowCurrentState();
     void getStatusHash(std::vector<uint8_t>& stateHash);
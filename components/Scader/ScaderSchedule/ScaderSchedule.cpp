@@ -0,0 +1,526 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// ScaderSchedule.cpp
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <time.h>
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+#include "Logger.h"
+#include "RaftArduino.h"
+#include "ScaderCommon.h"
+#include "ScaderSchedule.h"
+#include "SunTimes.h"
+#include "RaftUtils.h"
+#include "RestAPIEndpointManager.h"
+#include "APISourceInfo.h"
+#include "SysManager.h"
+#include "CommsChannelMsg.h"
+
+// #define DEBUG_SCHEDULE_RULES
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Constructor
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ScaderSchedule::ScaderSchedule(const char *pModuleName, RaftJsonIF& sysConfig)
+        : RaftSysMod(pModuleName, sysConfig),
+          _scaderCommon(*this, sysConfig, pModuleName)
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Setup
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScaderSchedule::setup()
+{
+    // Common
+    _scaderCommon.setup();
+
+    // Check enabled
+    if (!_scaderCommon.isEnabled())
+    {
+        LOG_I(MODULE_PREFIX, "setup disabled");
+        return;
+    }
+
+    // Location (for sunrise/sunset rules)
+    _locationValid = configGetString("latitude", "").length() > 0 && configGetString("longitude", "").length() > 0;
+    _latitude = configGetDouble("latitude", 0);
+    _longitude = configGetDouble("longitude", 0);
+
+    // Rules
+    std::vector<String> ruleInfos;
+    configGetArrayElems("rules", ruleInfos);
+    _rules.clear();
+    _rules.reserve(ruleInfos.size() + MAX_ONE_SHOTS);
+    for (const String& ruleInfoStr : ruleInfos)
+    {
+        RaftJson ruleInfo = ruleInfoStr;
+        Rule rule;
+        rule.name = ruleInfo.getString("name", ("Rule " + String(_rules.size() + 1)).c_str());
+        rule.api = ruleInfo.getString("api", "");
+        rule.dayMask = parseDayMask(ruleInfo.getString("days", ""));
+        String atStr = ruleInfo.getString("at", "");
+        if ((rule.api.length() == 0) || (rule.dayMask == 0) || !parseRuleTime(atStr, rule))
+        {
+            LOG_W(MODULE_PREFIX, "setup rule %s invalid at %s days %s api %s", rule.name.c_str(), atStr.c_str(),
+                        ruleInfo.getString("days", "").c_str(), rule.api.c_str());
+            continue;
+        }
+        if ((rule.timeType != RULE_TIME_OF_DAY) && !_locationValid)
+            LOG_W(MODULE_PREFIX, "setup rule %s needs latitude and longitude", rule.name.c_str());
+        rule.isActive = true;
+        _rules.push_back(rule);
+    }
+    _numConfigRules = _rules.size();
+
+    // One-shot slots
+    _rules.resize(_numConfigRules + MAX_ONE_SHOTS);
+    for (uint32_t i = _numConfigRules; i < _rules.size(); i++)
+    {
+        _rules[i].timeType = RULE_ONE_SHOT;
+        _rules[i].isOneShot = true;
+    }
+    _heap.reserve(_rules.size() * 2);
+
+    // Setup publisher with callback functions
+    SysManagerIF* pSysManager = getSysManager();
+    if (pSysManager)
+    {
+        // Register publish message generator
+        pSysManager->registerDataSource("Publish", _scaderCommon.getModuleName().c_str(),
+            [this](uint16_t topicIdx, CommsChannelMsg& msg) {
+                String statusStr = getStatusJSON();
+                msg.setFromBuffer((uint8_t*)statusStr.c_str(), statusStr.length());
+                return true;
+            },
+            [this](uint16_t topicIdx, std::vector<uint8_t>& stateHash) {
+                stateHash.clear();
+                stateHash.push_back(_timeValid ? 1 : 0);
+                stateHash.push_back(_lastFiredTime & 0xff);
+            }
+        );
+    }
+
+    // Debug
+    LOG_I(MODULE_PREFIX, "setup enabled scaderUIName %s rules %d location %s",
+                _scaderCommon.getUIName().c_str(), _numConfigRules,
+                _locationValid ? (String(_latitude, 4) + "," + String(_longitude, 4)).c_str() : "none");
+
+    // HW Now initialised
+    _isInitialised = true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Loop
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScaderSchedule::loop()
+{
+    // Check init
+    if (!_isInitialised)
+        return;
+
+    // Rules fire on whole seconds so only check the clock once a second
+    if (!Raft::isTimeout(millis(), _timeCheckLastMs, TIME_CHECK_MS))
+        return;
+    uint32_t elapsedMs = millis() - _timeCheckLastMs;
+    _timeCheckLastMs = millis();
+
+    // Wait for the clock to be set (by NTP)
+    time_t nowTime = time(nullptr);
+    if (nowTime < TIME_VALID_MIN)
+    {
+        _timeValid = false;
+        return;
+    }
+
+    // Rebuild the schedule when the clock first becomes valid or is stepped (so rules skipped or repeated by
+    // the step don't all fire at once)
+    time_t expectedTime = _timeCheckLast + elapsedMs / 1000;
+    bool clockStepped = _timeValid && ((nowTime > expectedTime + TIME_STEP_MAX_S) || (nowTime + TIME_STEP_MAX_S < expectedTime));
+    if (!_timeValid || clockStepped)
+    {
+        LOG_I(MODULE_PREFIX, "loop clock %s rebuilding schedule", _timeValid ? "stepped" : "valid");
+        rebuildSchedule(nowTime);
+        _timeValid = true;
+    }
+    _timeCheckLast = nowTime;
+
+    // Fire rules that are due - only the earliest entry in the heap is examined
+    while (!_heap.empty() && (_heap.front().fireTime <= nowTime))
+    {
+        HeapEntry entry = _heap.front();
+        std::pop_heap(_heap.begin(), _heap.end());
+        _heap.pop_back();
+        const Rule& rule = _rules[entry.ruleIdx];
+        if (!rule.isActive || (rule.nextFireTime != entry.fireTime))
+            continue;
+        fireRule(entry.ruleIdx, nowTime);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Fire a rule (run its API request)
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScaderSchedule::fireRule(uint32_t ruleIdx, time_t nowTime)
+{
+    Rule& rule = _rules[ruleIdx];
+
+    // Schedule the next occurrence first (one-shots are done once fired) as the API request may itself
+    // change the schedule
+    if (rule.isOneShot)
+        rule.isActive = false;
+    else
+        scheduleRule(ruleIdx, nowTime);
+
+    // Copy what's needed as the API request may add a one-shot that reuses this rule's slot
+    String ruleName = rule.name;
+    String ruleApi = rule.api;
+
+    // Run the API request through the same path as REST/MQTT requests
+    String respStr;
+    RaftRetCode retc = RAFT_INVALID_OPERATION;
+    RestAPIEndpointManager* pEndpointManager = getSysManager() ? getSysManager()->getRestAPIEndpointManager() : nullptr;
+    if (pEndpointManager)
+        retc = pEndpointManager->handleApiRequest(ruleApi.c_str(), respStr, APISourceInfo(RestAPIEndpointManager::CHANNEL_ID_REST_API));
+    _lastFiredName = ruleName;
+    _lastFiredTime = nowTime;
+    _lastFiredOk = (retc == RAFT_OK) && RaftJson(respStr).getString("rslt", "").equals("ok");
+    LOG_I(MODULE_PREFIX, "fireRule %s api %s %s", ruleName.c_str(), ruleApi.c_str(), _lastFiredOk ? "OK" : respStr.c_str());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Schedule a rule's next occurrence after a time
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScaderSchedule::scheduleRule(uint32_t ruleIdx, time_t afterTime)
+{
+    Rule& rule = _rules[ruleIdx];
+    if (!rule.isActive)
+        return;
+    if (!rule.isOneShot && !getNextFireTime(rule, afterTime, rule.nextFireTime))
+    {
+        rule.nextFireTime = 0;
+        return;
+    }
+    _heap.push_back({rule.nextFireTime, ruleIdx});
+    std::push_heap(_heap.begin(), _heap.end());
+#ifdef DEBUG_SCHEDULE_RULES
+    LOG_I(MODULE_PREFIX, "scheduleRule %s in %ds", rule.name.c_str(), int(rule.nextFireTime - afterTime));
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Rebuild the schedule for all rules
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScaderSchedule::rebuildSchedule(time_t nowTime)
+{
+    _heap.clear();
+    for (uint32_t ruleIdx = 0; ruleIdx < _rules.size(); ruleIdx++)
+        scheduleRule(ruleIdx, nowTime);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Get the next time a daily or sun rule fires after a time
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ScaderSchedule::getNextFireTime(const Rule& rule, time_t afterTime, time_t& fireTime) const
+{
+    // Check today and the next 7 days (local time) for a day the rule applies
+    struct tm afterTm;
+    localtime_r(&afterTime, &afterTm);
+    for (int dayOffset = 0; dayOffset <= 7; dayOffset++)
+    {
+        // Normalise the date (and get the day of week/year) using midday to avoid DST transitions
+        struct tm dayTm = afterTm;
+        dayTm.tm_mday += dayOffset;
+        dayTm.tm_hour = 12;
+        dayTm.tm_min = 0;
+        dayTm.tm_sec = 0;
+        dayTm.tm_isdst = -1;
+        mktime(&dayTm);
+        if ((rule.dayMask & (1 << dayTm.tm_wday)) == 0)
+            continue;
+
+        // Time on that day
+        time_t candidateTime = 0;
+        if (rule.timeType == RULE_TIME_OF_DAY)
+        {
+            struct tm ruleTm = dayTm;
+            ruleTm.tm_hour = rule.mins / 60;
+            ruleTm.tm_min = rule.mins % 60;
+            ruleTm.tm_isdst = -1;
+            candidateTime = mktime(&ruleTm);
+        }
+        else
+        {
+            double utcMins = 0;
+            if (!_locationValid || !SunTimes::getSunEventUTCMins(rule.timeType == RULE_SUNRISE, dayTm.tm_yday,
+                        _latitude, _longitude, utcMins))
+                continue;
+            int32_t dayNum = SunTimes::daysFromCivil(dayTm.tm_year + 1900, dayTm.tm_mon + 1, dayTm.tm_mday);
+            candidateTime = time_t(dayNum) * 86400 + time_t(utcMins * 60) + rule.mins * 60;
+        }
+        if (candidateTime > afterTime)
+        {
+            fireTime = candidateTime;
+            return true;
+        }
+    }
+    return false;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Parse rule time - HH:MM or sunrise/sunset with an optional +/- offset in minutes (e.g. sunset-30)
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ScaderSchedule::parseRuleTime(const String& atStr, Rule& rule)
+{
+    String timeStr = atStr;
+    timeStr.trim();
+    timeStr.toLowerCase();
+    for (const char* pSunEvent : { "sunrise", "sunset" })
+    {
+        if (!timeStr.startsWith(pSunEvent))
+            continue;
+        rule.timeType = strcmp(pSunEvent, "sunrise") == 0 ? RULE_SUNRISE : RULE_SUNSET;
+        String offsetStr = timeStr.substring(strlen(pSunEvent));
+        offsetStr.trim();
+        if (offsetStr.startsWith("+"))
+            offsetStr = offsetStr.substring(1);
+        rule.mins = offsetStr.toInt();
+        return (rule.mins > -720) && (rule.mins < 720);
+    }
+    int colonPos = timeStr.indexOf(':');
+    if (colonPos <= 0)
+        return false;
+    int hours = timeStr.substring(0, colonPos).toInt();
+    int mins = timeStr.substring(colonPos + 1).toInt();
+    if ((hours < 0) || (hours > 23) || (mins < 0) || (mins > 59))
+        return false;
+    rule.timeType = RULE_TIME_OF_DAY;
+    rule.mins = hours * 60 + mins;
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Days of the week - blank or all, weekdays, weekends or a list of day names (e.g. mon,wed,fri)
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static const char* DAY_NAMES[] = { "sun", "mon", "tue", "wed", "thu", "fri", "sat" };
+
+uint8_t ScaderSchedule::parseDayMask(const String& daysStr)
+{
+    String days = daysStr;
+    days.trim();
+    days.toLowerCase();
+    if ((days.length() == 0) || days.equals("all"))
+        return ALL_DAYS_MASK;
+    if (days.equals("weekdays"))
+        return 0x3e;
+    if (days.equals("weekends"))
+        return 0x41;
+    uint8_t dayMask = 0;
+    for (int i = 0; i < 7; i++)
+    {
+        if (days.indexOf(DAY_NAMES[i]) >= 0)
+            dayMask |= 1 << i;
+    }
+    return dayMask;
+}
+
+String ScaderSchedule::getDaysStr(uint8_t dayMask)
+{
+    if (dayMask == ALL_DAYS_MASK)
+        return "all";
+    String daysStr;
+    for (int i = 0; i < 7; i++)
+    {
+        if ((dayMask & (1 << i)) == 0)
+            continue;
+        if (daysStr.length() > 0)
+            daysStr += ",";
+        daysStr += DAY_NAMES[i];
+    }
+    return daysStr;
+}
+
+String ScaderSchedule::getRuleTimeStr(const Rule& rule)
+{
+    if (rule.timeType == RULE_ONE_SHOT)
+        return "once";
+    if (rule.timeType == RULE_TIME_OF_DAY)
+    {
+        char timeStr[10];
+        snprintf(timeStr, sizeof(timeStr), "%02d:%02d", int(rule.mins / 60), int(rule.mins % 60));
+        return timeStr;
+    }
+    String timeStr = rule.timeType == RULE_SUNRISE ? "sunrise" : "sunset";
+    if (rule.mins != 0)
+        timeStr += (rule.mins > 0 ? "+" : "") + String(rule.mins);
+    return timeStr;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Add a one-shot rule - returns the rule id or -1 if all slots are in use
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int32_t ScaderSchedule::addOneShot(const String& api, time_t fireTime)
+{
+    for (uint32_t ruleIdx = _numConfigRules; ruleIdx < _rules.size(); ruleIdx++)
+    {
+        Rule& rule = _rules[ruleIdx];
+        if (rule.isActive)
+            continue;
+        rule.name = "once " + String(ruleIdx);
+        rule.api = api;
+        rule.nextFireTime = fireTime;
+        rule.isActive = true;
+        scheduleRule(ruleIdx, fireTime);
+        return ruleIdx;
+    }
+    return -1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Get the rest of a request from an argument onwards (an API request within the request)
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+String ScaderSchedule::getRemainingArgs(const String& reqStr, uint32_t argIdx)
+{
+    uint32_t pos = reqStr.startsWith("/") ? 1 : 0;
+    for (uint32_t i = 0; i < argIdx; i++)
+    {
+        int slashPos = reqStr.indexOf('/', pos);
+        if (slashPos < 0)
+            return "";
+        pos = slashPos + 1;
+    }
+    return reqStr.substring(pos);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Endpoints
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScaderSchedule::addRestAPIEndpoints(RestAPIEndpointManager &endpointManager)
+{
+    endpointManager.addEndpoint("schedule", RestAPIEndpoint::ENDPOINT_CALLBACK, RestAPIEndpoint::ENDPOINT_GET,
+                            std::bind(&ScaderSchedule::apiSchedule, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3),
+                            "schedule lists rules, schedule/in/<secs>/<api> or schedule/at/<HH:MM|sunrise+N|sunset-N>/<api> adds a one-shot, schedule/cancel/<id>");
+    LOG_I(MODULE_PREFIX, "addRestAPIEndpoints scader schedule");
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Schedule via API
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+RaftRetCode ScaderSchedule::apiSchedule(const String &reqStr, String &respStr, const APISourceInfo& sourceInfo)
+{
+    // Check init
+    if (!_isInitialised)
+        return Raft::setJsonBoolResult(reqStr.c_str(), respStr, false);
+
+    // List rules
+    String cmdStr = RestAPIEndpointManager::getNthArgStr(reqStr.c_str(), 1);
+    time_t nowTime = time(nullptr);
+    if (cmdStr.length() == 0)
+    {
+        String rulesJson = R"("rules":[)";
+        bool isFirst = true;
+        for (uint32_t ruleIdx = 0; ruleIdx < _rules.size(); ruleIdx++)
+        {
+            const Rule& rule = _rules[ruleIdx];
+            if (!rule.isActive)
+                continue;
+            rulesJson += isFirst ? "" : ",";
+            isFirst = false;
+            rulesJson += R"({"id":)" + String(ruleIdx) + R"(,"name":")" + rule.name + R"(","at":")" + getRuleTimeStr(rule) +
+                        R"(","days":")" + getDaysStr(rule.dayMask) + R"(","api":")" + rule.api + R"(","inS":)" +
+                        String(_timeValid && (rule.nextFireTime != 0) ? int32_t(rule.nextFireTime - nowTime) : -1) + "}";
+        }
+        rulesJson += "]";
+        return Raft::setJsonBoolResult(reqStr.c_str(), respStr, true, rulesJson.c_str());
+    }
+
+    // Cancel a rule (configured rules are re-enabled on restart)
+    if (cmdStr.equalsIgnoreCase("cancel"))
+    {
+        uint32_t ruleIdx = RestAPIEndpointManager::getNthArgStr(reqStr.c_str(), 2).toInt();
+        if ((ruleIdx >= _rules.size()) || !_rules[ruleIdx].isActive)
+            return Raft::setJsonErrorResult(reqStr.c_str(), respStr, "unknownRule");
+        _rules[ruleIdx].isActive = false;
+        if (_timeValid)
+            rebuildSchedule(nowTime);
+        return Raft::setJsonBoolResult(reqStr.c_str(), respStr, true);
+    }
+
+    // One-shots need a valid clock
+    if (!cmdStr.equalsIgnoreCase("in") && !cmdStr.equalsIgnoreCase("at"))
+        return Raft::setJsonErrorResult(reqStr.c_str(), respStr, "unknownCommand");
+    if (!_timeValid)
+        return Raft::setJsonErrorResult(reqStr.c_str(), respStr, "timeNotValid");
+    String timeStr = RestAPIEndpointManager::getNthArgStr(reqStr.c_str(), 2);
+    String api = getRemainingArgs(reqStr, 3);
+    if (api.length() == 0)
+        return Raft::setJsonErrorResult(reqStr.c_str(), respStr, "noAPI");
+
+    // Get the time
+    time_t fireTime = 0;
+    if (cmdStr.equalsIgnoreCase("in"))
+    {
+        // Whole number of seconds from now (toInt() would turn junk into 0 so check the digits)
+        char* pEnd = nullptr;
+        long delaySecs = strtol(timeStr.c_str(), &pEnd, 10);
+        if ((timeStr.length() == 0) || (*pEnd != 0) || (delaySecs <= 0))
+            return Raft::setJsonErrorResult(reqStr.c_str(), respStr, "invalidTime");
+        fireTime = nowTime + delaySecs;
+    }
+    else
+    {
+        Rule atRule;
+        if (!parseRuleTime(timeStr, atRule) || !getNextFireTime(atRule, nowTime, fireTime))
+            return Raft::setJsonErrorResult(reqStr.c_str(), respStr, "invalidTime");
+    }
+
+    // Add
+    int32_t ruleIdx = addOneShot(api, fireTime);
+    if (ruleIdx < 0)
+        return Raft::setJsonErrorResult(reqStr.c_str(), respStr, "noSlots");
+    LOG_I(MODULE_PREFIX, "apiSchedule one-shot %d in %ds api %s", ruleIdx, int(fireTime - nowTime), api.c_str());
+    String ruleJson = R"("id":)" + String(ruleIdx) + R"(,"inS":)" + String(int32_t(fireTime - nowTime));
+    return Raft::setJsonBoolResult(reqStr.c_str(), respStr, true, ruleJson.c_str());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Get JSON status
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+String ScaderSchedule::getStatusJSON() const
+{
+    // Next rule to fire
+    time_t nowTime = time(nullptr);
+    String scheduleStr = R"(,"timeValid":)" + String(_timeValid ? 1 : 0) + R"(,"rules":)" + String(_numConfigRules);
+    if (_timeValid && !_heap.empty() && (_heap.front().ruleIdx < _rules.size()))
+    {
+        const Rule& rule = _rules[_heap.front().ruleIdx];
+        scheduleStr += R"(,"next":")" + rule.name + R"(","nextS":)" + String(int32_t(_heap.front().fireTime - nowTime));
+    }
+    if (_lastFiredTime != 0)
+    {
+        scheduleStr += R"(,"last":")" + _lastFiredName + R"(","lastOk":)" + String(_lastFiredOk ? 1 : 0) +
+                    R"(,"lastS":)" + String(int32_t(nowTime - _lastFiredTime));
+    }
+
+    // Add base JSON
+    return "{" + _scaderCommon.getStatusJSON() + scheduleStr + "}";
+}
@@ -0,0 +1,132 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// ScaderSchedule
+// On-device schedule of REST API commands (relays, shades, etc) at daily times, sunrise/sunset offsets or
+// as one-shot timers - so switching carries on when the network or external controller is down
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <time.h>
+#include <vector>
+#include "RaftUtils.h"
+#include "RaftJsonIF.h"
+#include "RaftSysMod.h"
+#include "ScaderCommon.h"
+
+class APISourceInfo;
+
+class ScaderSchedule : public RaftSysMod
+{
+public:
+    ScaderSchedule(const char *pModuleName, RaftJsonIF& sysConfig);
+
+    // Create function (for use by SysManager factory)
+    static RaftSysMod* create(const char* pModuleName, RaftJsonIF& sysConfig)
+    {
+        return new ScaderSchedule(pModuleName, sysConfig);
+    }
+
+protected:
+
+    // Setup
+    virtual void setup() override final;
+
+    // Loop (called frequently)
+    virtual void loop() override final;
+
+    // Add endpoints
+    virtual void addRestAPIEndpoints(RestAPIEndpointManager& pEndpoints) override final;
+
+    // Status
+    virtual String getStatusJSON() const override final;
+
+private:
+
+    // Common
+    ScaderCommon _scaderCommon;
+
+    // Initialised flag
+    bool _isInitialised = false;
+
+    // When a rule fires
+    enum RuleTimeType
+    {
+        RULE_TIME_OF_DAY,
+        RULE_SUNRISE,
+        RULE_SUNSET,
+        RULE_ONE_SHOT
+    };
+
+    // Days of the week (bit 0 is Sunday as in tm_wday)
+    static const uint8_t ALL_DAYS_MASK = 0x7f;
+
+    // Rule - the API request is run (as if received over REST) when the rule fires
+    struct Rule
+    {
+        String name;
+        String api;
+        RuleTimeType timeType = RULE_TIME_OF_DAY;
+        int32_t mins = 0;
+        uint8_t dayMask = ALL_DAYS_MASK;
+        bool isActive = false;
+        bool isOneShot = false;
+        time_t nextFireTime = 0;
+    };
+    std::vector<Rule> _rules;
+
+    // One-shot rules use slots after the configured rules (reused once fired or cancelled) - the rules vector
+    // is sized at setup and never resized as rules can run API requests that add one-shots
+    static const uint32_t MAX_ONE_SHOTS = 8;
+    uint32_t _numConfigRules = 0;
+
+    // Min-heap of next fire times - loop only looks at the earliest entry. Entries for rules that have been
+    // rescheduled or cancelled are discarded when they reach the top (nextFireTime no longer matches)
+    struct HeapEntry
+    {
+        time_t fireTime;
+        uint32_t ruleIdx;
+        bool operator<(const HeapEntry& other) const
+        {
+            return fireTime > other.fireTime;
+        }
+    };
+    std::vector<HeapEntry> _heap;
+
+    // Location for sunrise/sunset
+    double _latitude = 0;
+    double _longitude = 0;
+    bool _locationValid = false;
+
+    // Time checks (the clock is only valid once set by NTP and may be stepped)
+    static const uint32_t TIME_CHECK_MS = 1000;
+    static const uint32_t TIME_STEP_MAX_S = 120;
+    static const time_t TIME_VALID_MIN = 1704067200;
+    uint32_t _timeCheckLastMs = 0;
+    time_t _timeCheckLast = 0;
+    bool _timeValid = false;
+
+    // Last fired rule
+    String _lastFiredName;
+    time_t _lastFiredTime = 0;
+    bool _lastFiredOk = false;
+
+    // Helper functions
+    static bool parseRuleTime(const String& atStr, Rule& rule);
+    static uint8_t parseDayMask(const String& daysStr);
+    static String getDaysStr(uint8_t dayMask);
+    static String getRuleTimeStr(const Rule& rule);
+    bool getNextFireTime(const Rule& rule, time_t afterTime, time_t& fireTime) const;
+    void scheduleRule(uint32_t ruleIdx, time_t afterTime);
+    void rebuildSchedule(time_t nowTime);
+    void fireRule(uint32_t ruleIdx, time_t nowTime);
+    int32_t addOneShot(const String& api, time_t fireTime);
+    static String getRemainingArgs(const String& reqStr, uint32_t argIdx);
+    RaftRetCode apiSchedule(const String &reqStr, String &respStr, const APISourceInfo& sourceInfo);
+
+    // Debug
+    static constexpr const char *MODULE_PREFIX = "ScaderSchedule";
+};
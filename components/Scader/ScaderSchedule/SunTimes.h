@@ -0,0 +1,52 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// SunTimes
+// Sunrise and sunset for a date and location (NOAA general solar position approximation - within a minute or
+// two away from the poles which is plenty for switching lights and shades)
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+class SunTimes
+{
+public:
+    // Days since 1970-01-01 for a civil date (month 1..12)
+    static int32_t daysFromCivil(int32_t year, uint32_t month, uint32_t day)
+    {
+        year -= month <= 2;
+        int32_t era = (year >= 0 ? year : year - 399) / 400;
+        uint32_t yearOfEra = year - era * 400;
+        uint32_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        uint32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        return era * 146097 + int32_t(dayOfEra) - 719468;
+    }
+
+    // Sunrise or sunset as minutes after midnight UTC on the date (dayOfYear 0..365)
+    // Returns false if the sun doesn't rise or set that day (polar day or night)
+    static bool getSunEventUTCMins(bool isSunrise, uint32_t dayOfYear, double latitude, double longitude, double& utcMins)
+    {
+        // Fractional year (radians) at midday
+        double gamma = 2 * M_PI / 365 * dayOfYear;
+
+        // Equation of time (minutes) and solar declination (radians)
+        double eqTimeMins = 229.18 * (0.000075 + 0.001868 * cos(gamma) - 0.032077 * sin(gamma)
+                    - 0.014615 * cos(2 * gamma) - 0.040849 * sin(2 * gamma));
+        double decl = 0.006918 - 0.399912 * cos(gamma) + 0.070257 * sin(gamma) - 0.006758 * cos(2 * gamma)
+                    + 0.000907 * sin(2 * gamma) - 0.002697 * cos(3 * gamma) + 0.00148 * sin(3 * gamma);
+
+        // Hour angle at sunrise/sunset (sun's upper limb on the horizon allowing for refraction)
+        double latRad = latitude * M_PI / 180;
+        double cosHourAngle = cos(90.833 * M_PI / 180) / (cos(latRad) * cos(decl)) - tan(latRad) * tan(decl);
+        if ((cosHourAngle < -1) || (cosHourAngle > 1))
+            return false;
+        double hourAngleDeg = acos(cosHourAngle) * 180 / M_PI;
+        utcMins = 720 - 4 * (longitude + (isSunrise ? hourAngleDeg : -hourAngleDeg)) - eqTimeMins;
+        return true;
+    }
+};
@@ -0,0 +1,71 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// LightLevelFilter
+// Moving average, minimum and maximum of a light-level sensor over the last few samples
+//
+// Samples are taken on a fixed cadence by the owner so the window covers a fixed time (e.g. 20 samples at
+// 100ms is 2s) - long enough to smooth flicker and ADC noise while still following a cloud passing over
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+template<uint32_t WINDOW_LEN>
+class LightLevelFilter
+{
+public:
+    // Add a sample
+    void sample(uint16_t value)
+    {
+        // Replace the oldest sample in the window
+        if (_numSamples < WINDOW_LEN)
+            _numSamples++;
+        else
+            _sum -= _samples[_nextIdx];
+        _samples[_nextIdx] = value;
+        _sum += value;
+        _nextIdx = (_nextIdx + 1) % WINDOW_LEN;
+
+        // Min and max over the window (short so a rescan is cheap)
+        _min = _max = value;
+        for (uint32_t i = 0; i < _numSamples; i++)
+        {
+            if (_samples[i] < _min)
+                _min = _samples[i];
+            if (_samples[i] > _max)
+                _max = _samples[i];
+        }
+    }
+
+    // Filtered values (0 until sampled)
+    uint16_t getAvg() const
+    {
+        return _numSamples == 0 ? 0 : (_sum + _numSamples / 2) / _numSamples;
+    }
+    uint16_t getMin() const
+    {
+        return _min;
+    }
+    uint16_t getMax() const
+    {
+        return _max;
+    }
+
+    // Window is full (values are settled)
+    bool isValid() const
+    {
+        return _numSamples == WINDOW_LEN;
+    }
+
+private:
+    uint16_t _samples[WINDOW_LEN] = {};
+    uint32_t _numSamples = 0;
+    uint32_t _nextIdx = 0;
+    uint32_t _sum = 0;
+    uint16_t _min = 0;
+    uint16_t _max = 0;
+};
@@ -7,6 +7,7 @@
 //
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include "ScaderShades.h"
 #include "RaftArduino.h"
 #include "RaftUtils.h"
@@ -24,7 +25,8 @@
 // TODO - config is global was passed to RaftSysMod constructor
 ScaderShades::ScaderShades(const char *pModuleName, RaftJsonIF& sysConfig)
     : RaftSysMod(pModuleName, sysConfig),
-          _scaderCommon(*this, sysConfig, pModuleName)
+          _scaderCommon(*this, sysConfig, pModuleName),
+          _scaderModuleState("scaderShades")
 {
 }
 
@@ -42,6 +44,9 @@ void ScaderShades::setup()
     if (_maxElems > DEFAULT_MAX_ELEMS)
         _maxElems = DEFAULT_MAX_ELEMS;
     _lightLevelsEnabled = configGetLong("enableLightLevels", false) != 0;
+    _lightLevelSampleMs = configGetLong("lightLevelSampleMs", LIGHT_LEVEL_SAMPLE_MS_DEFAULT);
+    if (_lightLevelSampleMs == 0)
+        _lightLevelSampleMs = LIGHT_LEVEL_SAMPLE_MS_DEFAULT;
         
     // Check enabled
     if (!_scaderCommon.isEnabled())
@@ -85,7 +90,8 @@ void ScaderShades::setup()
         ConfigPinMap::configMultiple(configGetConfig(), lightLevelPins, sizeof(lightLevelPins) / sizeof(lightLevelPins[0]));
 
         // Debug
-        LOG_I(MODULE_PREFIX, "setup light-level pins %d %d %d", _lightLevelPins[0], _lightLevelPins[1], _lightLevelPins[2]);
+        LOG_I(MODULE_PREFIX, "setup light-level pins %d %d %d sampleMs %d", 
+                    _lightLevelPins[0], _lightLevelPins[1], _lightLevelPins[2], _lightLevelSampleMs);
     }
 
     // HW Now initialised
@@ -96,8 +102,10 @@ void ScaderShades::setup()
     {
         _msTimeouts[i] = 0;
         _tickCounts[i] = 0;
+        _sequences[i]._elemIdx = i;
     }
     _curShadeCtrlBits = 0;
+    _timerQueue.reserve(TIMER_QUEUE_MAX_LEN + 1);
 
     // Send to shift register
     sendBitsToShiftRegister();
@@ -133,9 +141,27 @@ void ScaderShades::setup()
             RaftJson elemInfo = elemInfos[i];
             _elemNames[i] = elemInfo.getString("name", ("Shade " + String(i+1)).c_str());
             LOG_I(MODULE_PREFIX, "Shade %d name %s", i+1, _elemNames[i].c_str());
+
+            // Configured full-travel times
+            _shadePositions[i].setTravelTimes(elemInfo.getLong("travelUpMs", 0), elemInfo.getLong("travelDownMs", 0));
+
+            // Light-level automation
+            _shadeAutomations[i].setup(elemInfo);
         }
     }
 
+    // Learned full-travel times override configured ones
+    std::vector<String> travelInfos;
+    _scaderModuleState.getArrayElems("travel", travelInfos);
+    for (int i = 0; (i < travelInfos.size()) && (i < DEFAULT_MAX_ELEMS); i++)
+    {
+        RaftJson travelInfo = travelInfos[i];
+        uint32_t travelUpMs = travelInfo.getLong("up", 0);
+        uint32_t travelDownMs = travelInfo.getLong("down", 0);
+        if ((travelUpMs > 0) && (travelDownMs > 0))
+            _shadePositions[i].setTravelTimes(travelUpMs, travelDownMs);
+    }
+
     // Debug
     LOG_I(MODULE_PREFIX, "setup enabled name %s HC595_SER %d HC595_SCK %d HC595_LATCH %d HC595_RST %d",
                 _scaderCommon.getUIName().c_str(),
@@ -151,32 +177,48 @@ void ScaderShades::loop()
     if (!_isInitialised)
         return;
 
-    // See if any shade actions need to end
-    bool somethingSet = false;
+    // Sample light levels
+    if (_lightLevelsEnabled && Raft::isTimeout(millis(), _lightLevelLastSampleMs, _lightLevelSampleMs))
+    {
+        _lightLevelLastSampleMs = millis();
+        sampleLightLevels();
+    }
+
+    // Light-level automation
+    if (_lightLevelsEnabled && Raft::isTimeout(millis(), _autoCheckLastMs, AUTO_CHECK_MS))
+    {
+        _autoCheckLastMs = millis();
+        updateAutomation();
+    }
+
+    // Update position estimates (moves end at the end stops)
     for (int shadeIdx = 0; shadeIdx < DEFAULT_MAX_ELEMS; shadeIdx++)
+        _shadePositions[shadeIdx].update(millis());
+
+    // End any shade actions that have timed out (earliest first) - sequences move on to their next step and
+    // all the changes are collated into one shift register update
+    uint32_t nowMs = millis();
+    bool somethingSet = false;
+    while (!_timerQueue.empty() && (int32_t(nowMs - _timerQueue.front().dueMs) >= 0))
     {
-        if (_msTimeouts[shadeIdx] != 0)
-        {
-            if (Raft::isTimeout(millis(), _tickCounts[shadeIdx], _msTimeouts[shadeIdx]))
-            {
-                LOG_I(MODULE_PREFIX, "Timeout idx %d duration %d enableLightLevels %d", 
-                        shadeIdx, _msTimeouts[shadeIdx], _lightLevelsEnabled);
-                // Clear the command
-                clearShadeBits(shadeIdx);
-                // Check for sequence step complete
-                if (_sequenceRunning)
-                {
-                    if (shadeIdx == _sequence._elemIdx)
-                    {
-                        LOG_I(MODULE_PREFIX, "sequenceStepComplete");
-                        sequenceStepComplete();
-                        return;
-                    }
-                }
-                // Collate changes
-                somethingSet = true;
-            }
-        }
+        std::pop_heap(_timerQueue.begin(), _timerQueue.end());
+        TimerEntry entry = _timerQueue.back();
+        _timerQueue.pop_back();
+        int shadeIdx = entry.shadeIdx;
+        if ((entry.timerGen != _timerGens[shadeIdx]) || (_msTimeouts[shadeIdx] == 0))
+            continue;
+        LOG_I(MODULE_PREFIX, "Timeout idx %d duration %d enableLightLevels %d", 
+                shadeIdx, _msTimeouts[shadeIdx], _lightLevelsEnabled);
+
+        // Clear the command
+        clearShadeBits(shadeIdx);
+
+        // Check for sequence step complete
+        if (_sequences[shadeIdx]._isBusy)
+            sequenceStepComplete(shadeIdx);
+
+        // Collate changes
+        somethingSet = true;
     }
     if (somethingSet)
     {
@@ -184,6 +226,33 @@ void ScaderShades::loop()
     }
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// timerQueueAdd - queue the timeout just set for a shade
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScaderShades::timerQueueAdd(int shadeIdx)
+{
+    if (_timerQueue.size() >= TIMER_QUEUE_MAX_LEN)
+        timerQueueRebuild();
+    _timerQueue.push_back({_tickCounts[shadeIdx] + _msTimeouts[shadeIdx], _timerGens[shadeIdx], shadeIdx});
+    std::push_heap(_timerQueue.begin(), _timerQueue.end());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// timerQueueRebuild - drop stale entries (there is at most one live timeout per shade)
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScaderShades::timerQueueRebuild()
+{
+    _timerQueue.clear();
+    for (int shadeIdx = 0; shadeIdx < DEFAULT_MAX_ELEMS; shadeIdx++)
+    {
+        if (_msTimeouts[shadeIdx] != 0)
+            _timerQueue.push_back({_tickCounts[shadeIdx] + _msTimeouts[shadeIdx], _timerGens[shadeIdx], shadeIdx});
+    }
+    std::make_heap(_timerQueue.begin(), _timerQueue.end());
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // sendBitsToShiftRegister
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -258,17 +327,175 @@ bool ScaderShades::setShadeBit(int shadeIdx, int bitMask, int bitIsOn)
 
 bool ScaderShades::clearShadeBits(int shadeIdx)
 {
-    // Clear any existing command
+    // Clear any existing command (any queued timeout is now stale)
     _msTimeouts[shadeIdx] = 0;
     _tickCounts[shadeIdx] = 0;
+    _timerGens[shadeIdx]++;
     return setShadeBit(shadeIdx, SHADE_UP_BIT_MASK | SHADE_STOP_BIT_MASK | SHADE_DOWN_BIT_MASK, false);
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// updatePosition - follow the buttons pressed on a shade
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScaderShades::updatePosition(int shadeIdx, int bitMask)
+{
+    uint32_t nowMs = millis();
+    ShadePosition& shadePos = _shadePositions[shadeIdx];
+    shadePos.update(nowMs);
+    if (bitMask == SHADE_UP_BIT_MASK)
+    {
+        shadePos.startMove(true, nowMs);
+    }
+    else if (bitMask == SHADE_DOWN_BIT_MASK)
+    {
+        shadePos.startMove(false, nowMs);
+    }
+    else if ((bitMask == SHADE_STOP_BIT_MASK) && (shadePos.getMotion() != ShadePosition::MOTION_STOPPED))
+    {
+        shadePos.stop(nowMs);
+    }
+    else if (bitMask != 0)
+    {
+        // STOP at rest moves to the favourite position and combinations program the motor
+        shadePos.setPosPct(ShadePosition::POS_UNKNOWN);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// moveToPos
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ScaderShades::moveToPos(int shadeIdx, float posPct)
+{
+    // Check validity
+    if ((shadeIdx < 0) || (shadeIdx >= DEFAULT_MAX_ELEMS) || (posPct < 0) || (posPct > 100))
+        return false;
+    ShadePosition& shadePos = _shadePositions[shadeIdx];
+    if (!shadePos.isTravelKnown())
+    {
+        LOG_W(MODULE_PREFIX, "moveToPos idx %d travel times not known", shadeIdx);
+        return false;
+    }
+    if (!sequenceStart(shadeIdx))
+    {
+        LOG_I(MODULE_PREFIX, "moveToPos idx %d sequence can't start as busy", shadeIdx);
+        return false;
+    }
+
+    // Stop if moving (the estimate is where it stops)
+    uint32_t nowMs = millis();
+    shadePos.update(nowMs);
+    float curPosPct = shadePos.getPosPct(nowMs);
+    if ((curPosPct >= 0) && (shadePos.getMotion() != ShadePosition::MOTION_STOPPED))
+        sequenceAdd(shadeIdx, SHADE_STOP_BIT_MASK, true, PULSE_ON_MILLISECS, true);
+
+    // Home at the end stop nearest the target if the position isn't known
+    bool isHoming = curPosPct < 0;
+    if (isHoming)
+    {
+        bool homeUp = posPct >= 50;
+        uint32_t homeMs = shadePos.getTravelMs(homeUp) * (100 + END_STOP_MARGIN_PCT) / 100;
+        sequenceAdd(shadeIdx, homeUp ? SHADE_UP_BIT_MASK : SHADE_DOWN_BIT_MASK, true, PULSE_ON_MILLISECS, true);
+        if (homeMs > PULSE_ON_MILLISECS)
+            sequenceAdd(shadeIdx, 0, false, homeMs - PULSE_ON_MILLISECS, true);
+        curPosPct = homeUp ? ShadePosition::POS_FULLY_UP : ShadePosition::POS_FULLY_DOWN;
+    }
+
+    // Moves to an end stop let the motor stop itself (re-homing the estimate even if already there) -
+    // otherwise STOP is pressed once the travel time for the distance has elapsed
+    bool isUp = posPct >= curPosPct;
+    uint32_t moveMs = shadePos.getMoveMs(curPosPct, posPct);
+    if ((posPct <= ShadePosition::POS_FULLY_DOWN) || (posPct >= ShadePosition::POS_FULLY_UP))
+    {
+        if (!isHoming || (posPct != curPosPct))
+            sequenceAdd(shadeIdx, posPct > 0 ? SHADE_UP_BIT_MASK : SHADE_DOWN_BIT_MASK, true, PULSE_ON_MILLISECS, true);
+    }
+    else if (moveMs >= MIN_MOVE_MS)
+    {
+        uint32_t pressMs = moveMs < PULSE_ON_MILLISECS ? moveMs : PULSE_ON_MILLISECS;
+        sequenceAdd(shadeIdx, isUp ? SHADE_UP_BIT_MASK : SHADE_DOWN_BIT_MASK, true, pressMs, true);
+        if (moveMs > pressMs)
+            sequenceAdd(shadeIdx, 0, false, moveMs - pressMs, true);
+        sequenceAdd(shadeIdx, SHADE_STOP_BIT_MASK, true, PULSE_ON_MILLISECS, true);
+    }
+
+    // Run (or nothing to do)
+    WindowShadesSeq& sequence = _sequences[shadeIdx];
+    if (sequence._numSteps == 0)
+    {
+        sequence._isBusy = false;
+        return true;
+    }
+    LOG_I(MODULE_PREFIX, "moveToPos idx %d from %.1f%% to %.1f%% moveMs %d steps %d",
+                shadeIdx, shadePos.getPosPct(nowMs), posPct, moveMs, sequence._numSteps);
+    sequenceRun(shadeIdx);
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// learnTravel - learnup/learndown start a full travel from the opposite end stop and learnend (sent when the
+// shade reaches the end stop) records the time taken
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ScaderShades::learnTravel(int shadeIdx, const String& cmdStr)
+{
+    if (cmdStr.equalsIgnoreCase("learnup") || cmdStr.equalsIgnoreCase("learndown"))
+    {
+        _learnShadeIdx = shadeIdx;
+        _learnIsUp = cmdStr.equalsIgnoreCase("learnup");
+        _learnStartMs = millis();
+        sequenceCancel(shadeIdx);
+        return setTimedOutput(shadeIdx, _learnIsUp ? SHADE_UP_BIT_MASK : SHADE_DOWN_BIT_MASK, true, PULSE_ON_MILLISECS, true);
+    }
+    if (!cmdStr.equalsIgnoreCase("learnend") || (_learnShadeIdx != shadeIdx))
+        return false;
+
+    // Record the travel time and the shade is now at the end stop
+    ShadePosition& shadePos = _shadePositions[shadeIdx];
+    uint32_t travelMs = millis() - _learnStartMs;
+    shadePos.setTravelTimes(_learnIsUp ? travelMs : shadePos.getTravelMs(true),
+                _learnIsUp ? shadePos.getTravelMs(false) : travelMs);
+    shadePos.setPosPct(_learnIsUp ? ShadePosition::POS_FULLY_UP : ShadePosition::POS_FULLY_DOWN);
+    _learnShadeIdx = -1;
+    LOG_I(MODULE_PREFIX, "learnTravel idx %d %s %dms", shadeIdx, _learnIsUp ? "up" : "down", travelMs);
+    saveMutableData();
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// saveMutableData - learned travel times
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScaderShades::saveMutableData()
+{
+    String jsonConfig = "\"travel\":[";
+    for (int i = 0; i < DEFAULT_MAX_ELEMS; i++)
+    {
+        if (i > 0)
+            jsonConfig += ",";
+        jsonConfig += R"({"up":)" + String(_shadePositions[i].getTravelMs(true)) +
+                    R"(,"down":)" + String(_shadePositions[i].getTravelMs(false)) + "}";
+    }
+    jsonConfig += "]";
+    _scaderModuleState.setJsonDoc(("{" + jsonConfig + "}").c_str());
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // setTimedOutput
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool ScaderShades::setTimedOutput(int shadeIdx, int bitMask, bool bitOn, uint32_t msDuration, bool bClearExisting)
+{
+    applyTimedOutput(shadeIdx, bitMask, bitOn, msDuration, bClearExisting);
+    return sendBitsToShiftRegister();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// applyTimedOutput - change the control bits and timeout without updating the shift register
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScaderShades::applyTimedOutput(int shadeIdx, int bitMask, bool bitOn, uint32_t msDuration, bool bClearExisting)
 {
     LOG_I(MODULE_PREFIX, "setTimedOutput idx %d mask %d bitOn %d duration %d clear %d", shadeIdx, bitMask, bitOn, msDuration, bClearExisting);
 
@@ -276,13 +503,16 @@ bool ScaderShades::setTimedOutput(int shadeIdx, int bitMask, bool bitOn, uint32_
     {
         clearShadeBits(shadeIdx);
     }
+    if (bitOn)
+        updatePosition(shadeIdx, bitMask);
     setShadeBit(shadeIdx, bitMask, bitOn);
     if (msDuration != 0)
     {
         _msTimeouts[shadeIdx] = msDuration;
         _tickCounts[shadeIdx] = millis();
+        _timerGens[shadeIdx]++;
+        timerQueueAdd(shadeIdx);
     }
-    return sendBitsToShiftRegister();
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -320,6 +550,12 @@ bool ScaderShades::doCommand(int shadeIdx, String &cmdStr, String &durationStr)
         msDuration = durationStr.toInt();
     }
 
+    // Direct button commands take over from any sequence running on the shade
+    if (cmdStr.equalsIgnoreCase("up") || cmdStr.equalsIgnoreCase("stop") || cmdStr.equalsIgnoreCase("down") ||
+                cmdStr.equalsIgnoreCase("setfavourite") || cmdStr.equalsIgnoreCase("resetmemory") ||
+                cmdStr.equalsIgnoreCase("reversedirn"))
+        sequenceCancel(shadeIdx);
+
     // Handle commands
     if (cmdStr.equalsIgnoreCase("up"))
     {
@@ -333,34 +569,49 @@ bool ScaderShades::doCommand(int shadeIdx, String &cmdStr, String &durationStr)
     {
         setTimedOutput(shadeIdx, SHADE_DOWN_BIT_MASK, pinOn, msDuration, true);
     }
+    else if (cmdStr.equalsIgnoreCase("pos"))
+    {
+        return moveToPos(shadeIdx, durationStr.toFloat());
+    }
+    else if (cmdStr.substring(0, 5).equalsIgnoreCase("learn"))
+    {
+        return learnTravel(shadeIdx, cmdStr);
+    }
+    else if (cmdStr.equalsIgnoreCase("auto"))
+    {
+        _shadeAutomations[shadeIdx].setEnabled(durationStr.equalsIgnoreCase("on"));
+        return _shadeAutomations[shadeIdx].isConfigured();
+    }
     else if (cmdStr.equalsIgnoreCase("setuplimit"))
     {
         if (sequenceStart(shadeIdx))
         {
-            sequenceAdd(SHADE_DOWN_BIT_MASK | SHADE_STOP_BIT_MASK, true, 1500, true);
-            sequenceAdd(SHADE_STOP_BIT_MASK, true, 500, true);
-            sequenceRun();
+            sequenceAdd(shadeIdx, SHADE_DOWN_BIT_MASK | SHADE_STOP_BIT_MASK, true, 1500, true);
+            sequenceAdd(shadeIdx, SHADE_STOP_BIT_MASK, true, 500, true);
+            _sequences[shadeIdx]._endPosPct = ShadePosition::POS_FULLY_UP;
+            sequenceRun(shadeIdx);
             LOG_I(MODULE_PREFIX, "doCommand sequenceStarted for set up limit");
         }
         else
         {
-            LOG_I(MODULE_PREFIX, "doCommand sequence can't start as busy");
+            LOG_I(MODULE_PREFIX, "doCommand idx %d sequence can't start as busy", shadeIdx);
         }
     }
     else if (cmdStr.equalsIgnoreCase("setdownlimit"))
     {
         if (sequenceStart(shadeIdx))
         {
-            sequenceAdd(SHADE_UP_BIT_MASK | SHADE_STOP_BIT_MASK, true, 1500, true);
-            sequenceAdd(SHADE_STOP_BIT_MASK, true, 500, true);
-            sequenceAdd(SHADE_STOP_BIT_MASK, false, 2000, true);
-            sequenceAdd(SHADE_STOP_BIT_MASK, true, 7000, true);
-            sequenceRun();
+            sequenceAdd(shadeIdx, SHADE_UP_BIT_MASK | SHADE_STOP_BIT_MASK, true, 1500, true);
+            sequenceAdd(shadeIdx, SHADE_STOP_BIT_MASK, true, 500, true);
+            sequenceAdd(shadeIdx, SHADE_STOP_BIT_MASK, false, 2000, true);
+            sequenceAdd(shadeIdx, SHADE_STOP_BIT_MASK, true, 7000, true);
+            _sequences[shadeIdx]._endPosPct = ShadePosition::POS_FULLY_DOWN;
+            sequenceRun(shadeIdx);
             LOG_I(MODULE_PREFIX, "doCommand sequenceStarted for set down limit and record");
         }
         else
         {
-            LOG_I(MODULE_PREFIX, "doCommand sequence can't start as busy");
+            LOG_I(MODULE_PREFIX, "doCommand idx %d sequence can't start as busy", shadeIdx);
         }
     }
     else if (cmdStr.equalsIgnoreCase("setfavourite"))
@@ -379,51 +630,92 @@ bool ScaderShades::doCommand(int shadeIdx, String &cmdStr, String &durationStr)
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// getLightLevels
+// sampleLightLevels
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void ScaderShades::getLightLevels(int lightLevels[], int numLevels) const
+void ScaderShades::sampleLightLevels()
 {
-    // Read light levels
-    for (int i = 0; i < numLevels; i++)
+    for (int i = 0; i < NUM_LIGHT_LEVELS; i++)
     {
-        if (_lightLevelsEnabled && (_lightLevelPins[i] >= 0))
-            lightLevels[i] = analogRead(_lightLevelPins[i]);
-        else
-            lightLevels[i] = 0;
+        if (_lightLevelPins[i] >= 0)
+            _lightLevelFilters[i].sample(analogRead(_lightLevelPins[i]));
     }
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// getStatusJSON
+// getLightLevelsJSON - filtered values (0 for unused sensors)
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-String ScaderShades::getStatusJSON() const
+String ScaderShades::getLightLevelsJSON() const
 {
-    String lightLevelsStr;
-    if (_lightLevelsEnabled)
+    String avgStr, minStr, maxStr;
+    for (int i = 0; i < NUM_LIGHT_LEVELS; i++)
     {
-        int lightLevels[NUM_LIGHT_LEVELS];
-        getLightLevels(lightLevels, NUM_LIGHT_LEVELS);
-        for (int i = 0; i < NUM_LIGHT_LEVELS; i++)
+        if (i > 0)
         {
-            lightLevelsStr += String(lightLevels[i]);
-            if (i < (NUM_LIGHT_LEVELS - 1))
-                lightLevelsStr += ",";
+            avgStr += ",";
+            minStr += ",";
+            maxStr += ",";
         }
+        avgStr += String(_lightLevelFilters[i].getAvg());
+        minStr += String(_lightLevelFilters[i].getMin());
+        maxStr += String(_lightLevelFilters[i].getMax());
     }
+    return R"("lux":[)" + avgStr + R"(],"luxMin":[)" + minStr + R"(],"luxMax":[)" + maxStr + "]";
+}
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// updateAutomation - move shades as the filtered light levels cross their thresholds
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScaderShades::updateAutomation()
+{
+    uint32_t nowMs = millis();
+    for (int shadeIdx = 0; shadeIdx < _elemNames.size(); shadeIdx++)
+    {
+        ShadeAutomation& automation = _shadeAutomations[shadeIdx];
+        uint32_t sensorIdx = automation.getSensorIdx();
+        if (!automation.isEnabled() || (sensorIdx >= NUM_LIGHT_LEVELS) || !_lightLevelFilters[sensorIdx].isValid())
+            continue;
+        ShadeAutomation::Action action = automation.update(nowMs, _lightLevelFilters[sensorIdx].getAvg(),
+                    _shadePositions[shadeIdx].isTravelKnown());
+        if ((action == ShadeAutomation::ACTION_NONE) || _sequences[shadeIdx]._isBusy)
+            continue;
+
+        // End positions are a press that runs to the end stop (no travel times needed) - otherwise a timed move
+        uint32_t posPct = automation.getActionPosPct(action);
+        String cmdStr = posPct == 0 ? "down" : (posPct >= 100 ? "up" : "pos");
+        String durationStr = (posPct == 0) || (posPct >= 100) ? String("pulse") : String(posPct);
+        LOG_I(MODULE_PREFIX, "updateAutomation idx %d lux %d %s (%s %s)", shadeIdx, _lightLevelFilters[sensorIdx].getAvg(),
+                    action == ShadeAutomation::ACTION_CLOSE ? "close" : "open", cmdStr.c_str(), durationStr.c_str());
+        if (doCommand(shadeIdx, cmdStr, durationStr))
+            automation.actionDone(nowMs, action);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// getStatusJSON
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+String ScaderShades::getStatusJSON() const
+{
     // Get status
     String elemStatus;
     for (int i = 0; i < _elemNames.size(); i++)
     {
         if (i > 0)
             elemStatus += ",";
-        elemStatus += R"({"name":")" + _elemNames[i] + R"(","state":)" + String(isShadeMoving(i) ? "1" : "0") + "}";
+        float posPct = _shadePositions[i].getPosPct(millis());
+        elemStatus += R"({"name":")" + _elemNames[i] + R"(","state":)" + String(isShadeMoving(i) ? "1" : "0") +
+                    R"(,"pos":)" + String(posPct < 0 ? -1 : int(posPct + 0.5));
+        if (_shadeAutomations[i].isConfigured())
+            elemStatus += R"(,"auto":)" + _shadeAutomations[i].getStatusJSON();
+        elemStatus += "}";
     }
 
     // Add base JSON
-    return "{" + _scaderCommon.getStatusJSON() + ",\"elems\":[" + elemStatus + "],\"lux\":[" + lightLevelsStr + "]}";
+    String lightLevelsStr = _lightLevelsEnabled ? getLightLevelsJSON() : R"("lux":[])";
+    return "{" + _scaderCommon.getStatusJSON() + ",\"elems\":[" + elemStatus + "]," + lightLevelsStr + "}";
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -432,9 +724,14 @@ String ScaderShades::getStatusJSON() const
 
 bool ScaderShades::sequenceStart(int shadeIdx)
 {
-    if (_sequence._isBusy)
+    WindowShadesSeq& sequence = _sequences[shadeIdx];
+    if (sequence._isBusy)
         return false;
-    _sequence._elemIdx = shadeIdx;
+    sequence._isBusy = true;
+    sequence._elemIdx = shadeIdx;
+    sequence._curStep = 0;
+    sequence._numSteps = 0;
+    sequence._endPosPct = ShadePosition::POS_UNKNOWN;
     return true;
 }
 
@@ -442,62 +739,80 @@ bool ScaderShades::sequenceStart(int shadeIdx)
 // sequenceAdd
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void ScaderShades::sequenceAdd(int mask, bool pinOn, uint32_t msDuration, bool clearExisting)
+void ScaderShades::sequenceAdd(int shadeIdx, int mask, bool pinOn, uint32_t msDuration, bool clearExisting)
 {
     WindowShadesSeqStep step(mask, pinOn, msDuration, clearExisting);
-    _sequence.addStep(step);
+    _sequences[shadeIdx].addStep(step);
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // sequenceRun
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void ScaderShades::sequenceRun()
+void ScaderShades::sequenceRun(int shadeIdx)
 {
-    _sequence._curStep = 0;
-    _sequenceRunning = true;
-    sequenceStartStep(_sequence._curStep);
+    _sequences[shadeIdx]._curStep = 0;
+    sequenceStartStep(shadeIdx);
+    sendBitsToShiftRegister();
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// sequenceStartStep
+// sequenceStartStep - the shift register is updated by the caller
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void ScaderShades::sequenceStartStep(int stepIdx)
+void ScaderShades::sequenceStartStep(int shadeIdx)
 {
-    if (stepIdx < 0 || stepIdx >= _sequence.MAX_SEQ_STEPS)
+    WindowShadesSeq& sequence = _sequences[shadeIdx];
+    int stepIdx = sequence._curStep;
+    if (stepIdx < 0 || stepIdx >= sequence.MAX_SEQ_STEPS)
         return;
-    LOG_I(MODULE_PREFIX, "sequenceStartStep stepIdx %d", stepIdx);
-    int mask = _sequence._steps[stepIdx]._bitMask;
-    int pinState = _sequence._steps[stepIdx]._pinState;
-    uint32_t msDuration = _sequence._steps[stepIdx]._msDuration;
-    bool clearExisting = _sequence._steps[stepIdx]._clearExisting;
-    setTimedOutput(_sequence._elemIdx, mask, pinState, msDuration, clearExisting);
+    LOG_I(MODULE_PREFIX, "sequenceStartStep idx %d stepIdx %d", shadeIdx, stepIdx);
+    const WindowShadesSeqStep& step = sequence._steps[stepIdx];
+    applyTimedOutput(shadeIdx, step._bitMask, step._pinState, step._msDuration, step._clearExisting);
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// sequenceStepComplete
+// sequenceStepComplete - the shift register is updated by the caller
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void ScaderShades::sequenceStepComplete()
+void ScaderShades::sequenceStepComplete(int shadeIdx)
 {
-    _sequence._curStep++;
-    if (_sequence._curStep >= _sequence._numSteps)
-    {
-        LOG_I(MODULE_PREFIX, "sequenceStepComplete");
-        _sequence._isBusy = false;
-        _sequence._curStep = 0;
-        _sequence._numSteps = 0;
-        clearShadeBits(_sequence._elemIdx);
-        sendBitsToShiftRegister();
+    WindowShadesSeq& sequence = _sequences[shadeIdx];
+    sequence._curStep++;
+    if (sequence._curStep >= sequence._numSteps)
+    {
+        LOG_I(MODULE_PREFIX, "sequenceStepComplete idx %d", shadeIdx);
+        sequence._isBusy = false;
+        sequence._curStep = 0;
+        sequence._numSteps = 0;
+        clearShadeBits(shadeIdx);
+
+        // Sequences that program the motor's limits leave the shade at that limit
+        if (sequence._endPosPct >= 0)
+            _shadePositions[shadeIdx].setPosPct(sequence._endPosPct);
     }
     else
     {
         // Start next step
-        sequenceStartStep(_sequence._curStep);
+        sequenceStartStep(shadeIdx);
     }
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// sequenceCancel - abandon a shade's sequence (the caller takes over its outputs)
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScaderShades::sequenceCancel(int shadeIdx)
+{
+    WindowShadesSeq& sequence = _sequences[shadeIdx];
+    if (!sequence._isBusy)
+        return;
+    LOG_I(MODULE_PREFIX, "sequenceCancel idx %d at step %d", shadeIdx, sequence._curStep);
+    sequence._isBusy = false;
+    sequence._curStep = 0;
+    sequence._numSteps = 0;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Endpoints
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -507,11 +822,11 @@ void ScaderShades::addRestAPIEndpoints(RestAPIEndpointManager &endpointManager)
     // Control shade
     endpointManager.addEndpoint("shade", RestAPIEndpoint::ENDPOINT_CALLBACK, RestAPIEndpoint::ENDPOINT_GET,
                             std::bind(&ScaderShades::apiControl, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3),
-                            "Control Shades - /1..N/up|stop|down/pulse|on|off");
+                            "Control Shades - /1..N/up|stop|down/pulse|on|off, /1..N/pos/<pct open>, /1..N/learnup|learndown|learnend, /1..N/auto/on|off");
     // Alternate control shade name
     endpointManager.addEndpoint("blind", RestAPIEndpoint::ENDPOINT_CALLBACK, RestAPIEndpoint::ENDPOINT_GET,
                             std::bind(&ScaderShades::apiControl, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3),
-                            "Control Shades - /1..N/up|stop|down/pulse|on|off");
+                            "Control Shades - /1..N/up|stop|down/pulse|on|off, /1..N/pos/<pct open>, /1..N/learnup|learndown|learnend, /1..N/auto/on|off");
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -530,6 +845,13 @@ RaftRetCode ScaderShades::apiControl(const String &reqStr, String &respStr, cons
         return Raft::setJsonBoolResult(reqStr.c_str(), respStr, false);
     }
     int shadeIdx = shadeNum - 1;
+
+    // Commands from the API take over from light-level automation on the shade
+    if (!shadeCmdStr.equalsIgnoreCase("auto") && _shadeAutomations[shadeIdx].isEnabled())
+    {
+        LOG_I(MODULE_PREFIX, "apiControl idx %d automation off as %s received", shadeIdx, shadeCmdStr.c_str());
+        _shadeAutomations[shadeIdx].setEnabled(false);
+    }
     bool rslt = doCommand(shadeIdx, shadeCmdStr, shadeDurationStr);
     return Raft::setJsonBoolResult(reqStr.c_str(), respStr, rslt);
 }
@@ -13,6 +13,9 @@
 #include "RaftUtils.h"
 #include "ScaderCommon.h"
 #include "RaftSysMod.h"
+#include "ShadePosition.h"
+#include "LightLevelFilter.h"
+#include "ShadeAutomation.h"
 
 class APISourceInfo;
 
@@ -49,6 +52,7 @@ public:
     int _curStep;
     int _numSteps;
     int _elemIdx;
+    float _endPosPct;
     WindowShadesSeqStep _steps[MAX_SEQ_STEPS];
 
     WindowShadesSeq()
@@ -57,6 +61,7 @@ public:
         _curStep = 0;
         _numSteps = 0;
         _elemIdx = 0;
+        _endPosPct = ShadePosition::POS_UNKNOWN;
     }
 
     bool addStep(WindowShadesSeqStep& step)
@@ -100,6 +105,9 @@ public:
     // Check if the shade is moving
     bool isShadeMoving(int shadeIdx) const;
 
+    // Move a shade to a position (percent open) with a timed move
+    bool moveToPos(int shadeIdx, float posPct);
+
 protected:
 
     // Setup
@@ -138,10 +146,41 @@ private:
     static const uint32_t NUM_LIGHT_LEVELS = 3;
     int _lightLevelPins[NUM_LIGHT_LEVELS] = {};
 
+    // Light levels are sampled in the background on a fixed cadence and filtered - status and automation use
+    // the filtered values rather than reading the ADC
+    static const uint32_t LIGHT_LEVEL_SAMPLE_MS_DEFAULT = 100;
+    static const uint32_t LIGHT_LEVEL_WINDOW_LEN = 20;
+    uint32_t _lightLevelSampleMs = LIGHT_LEVEL_SAMPLE_MS_DEFAULT;
+    uint32_t _lightLevelLastSampleMs = 0;
+    LightLevelFilter<LIGHT_LEVEL_WINDOW_LEN> _lightLevelFilters[NUM_LIGHT_LEVELS];
+
+    // Light-level automation (commands from the API take over from automation on that shade until it is
+    // re-enabled with the auto command)
+    static const uint32_t AUTO_CHECK_MS = 1000;
+    uint32_t _autoCheckLastMs = 0;
+    ShadeAutomation _shadeAutomations[DEFAULT_MAX_ELEMS];
+
     // Timing
     uint32_t _msTimeouts[DEFAULT_MAX_ELEMS] = {};
     int _tickCounts[DEFAULT_MAX_ELEMS] = {};
 
+    // Timer queue - min-heap of when each shade's output times out so loop only looks at the earliest. Each
+    // shade's timer generation is bumped when its timeout is set or cleared and entries for an older generation
+    // are discarded when they reach the top (the heap is rebuilt if stale entries build up)
+    struct TimerEntry
+    {
+        uint32_t dueMs;
+        uint32_t timerGen;
+        int shadeIdx;
+        bool operator<(const TimerEntry& other) const
+        {
+            return int32_t(dueMs - other.dueMs) > 0;
+        }
+    };
+    std::vector<TimerEntry> _timerQueue;
+    uint32_t _timerGens[DEFAULT_MAX_ELEMS] = {};
+    static const uint32_t TIMER_QUEUE_MAX_LEN = DEFAULT_MAX_ELEMS * 4;
+
     // Names of control elements
     std::vector<String> _elemNames;
 
@@ -149,23 +188,47 @@ private:
     // The shift register contains the bits end-to-end for each shade in sequence
     int _curShadeCtrlBits = 0;
 
-    // Sequence handling
-    bool _sequenceRunning = false;
-    WindowShadesSeq _sequence;
+    // Sequence handling - each shade runs its own sequence
+    WindowShadesSeq _sequences[DEFAULT_MAX_ELEMS];
+
+    // Position estimates
+    ShadePosition _shadePositions[DEFAULT_MAX_ELEMS];
+
+    // Moves to an end stop run for longer than the estimated travel so the shade re-homes and moves shorter
+    // than the minimum are ignored
+    static const uint32_t END_STOP_MARGIN_PCT = 10;
+    static const uint32_t MIN_MOVE_MS = 200;
 
-    // get light levels
-    void getLightLevels(int lightLevels[], int numLevels) const;
+    // Learning full-travel time (from an end stop until learnend is received)
+    int _learnShadeIdx = -1;
+    bool _learnIsUp = false;
+    uint32_t _learnStartMs = 0;
+
+    // Learned travel times
+    RaftJsonNVS _scaderModuleState;
+
+    // Light levels
+    void sampleLightLevels();
+    String getLightLevelsJSON() const;
+    void updateAutomation();
 
     // Helper functions
     bool clearShadeBits(int shadeIdx);
     bool sendBitsToShiftRegister();
     bool setTimedOutput(int shadeIdx, int bitMask, bool bitOn, uint32_t msDuration, bool bClearExisting);
+    void applyTimedOutput(int shadeIdx, int bitMask, bool bitOn, uint32_t msDuration, bool bClearExisting);
+    void timerQueueAdd(int shadeIdx);
+    void timerQueueRebuild();
     bool setShadeBit(int shadeIdx, int bitMask, int bitIsOn);
+    void updatePosition(int shadeIdx, int bitMask);
+    bool learnTravel(int shadeIdx, const String& cmdStr);
+    void saveMutableData();
     bool sequenceStart(int shadeIdx);
-    void sequenceAdd(int mask, bool pinOn, uint32_t msDuration, bool clearExisting);
-    void sequenceRun();
-    void sequenceStartStep(int stepIdx);
-    void sequenceStepComplete();
+    void sequenceAdd(int shadeIdx, int mask, bool pinOn, uint32_t msDuration, bool clearExisting);
+    void sequenceRun(int shadeIdx);
+    void sequenceStartStep(int shadeIdx);
+    void sequenceStepComplete(int shadeIdx);
+    void sequenceCancel(int shadeIdx);
     RaftRetCode apiControl(const String &reqStr, String &respStr, const APISourceInfo& sourceInfo);
 
     // Debug
@@ -0,0 +1,163 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// ShadeAutomation
+// Closes a shade when the (filtered) light level stays above a threshold and opens it again when the level
+// has dropped by the hysteresis - so glare control reacts locally within seconds
+//
+// A change must be wanted for the confirm time before it happens (so a passing cloud or reflection doesn't
+// move the shade) and the shade then stays put for at least the dwell time
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include "RaftUtils.h"
+#include "RaftJson.h"
+
+class ShadeAutomation
+{
+public:
+    enum Action
+    {
+        ACTION_NONE,
+        ACTION_OPEN,
+        ACTION_CLOSE
+    };
+
+    // Setup from the shade's element config - automation is configured if autoLuxClose is set
+    void setup(const RaftJson& elemInfo)
+    {
+        _sensorIdx = elemInfo.getLong("autoSensor", 0);
+        _luxClose = elemInfo.getLong("autoLuxClose", 0);
+        _luxHyst = elemInfo.getLong("autoLuxHyst", LUX_HYST_DEFAULT);
+        if (_luxHyst > _luxClose)
+            _luxHyst = _luxClose;
+        _closePosPct = elemInfo.getLong("autoClosePos", 0);
+        _openPosPct = elemInfo.getLong("autoOpenPos", 100);
+        _confirmMs = elemInfo.getLong("autoConfirmSecs", CONFIRM_SECS_DEFAULT) * 1000;
+        _dwellMs = elemInfo.getLong("autoDwellSecs", DWELL_SECS_DEFAULT) * 1000;
+        _isEnabled = isConfigured() && (elemInfo.getLong("autoEnable", 0) != 0);
+    }
+    bool isConfigured() const
+    {
+        return _luxClose > 0;
+    }
+    uint32_t getSensorIdx() const
+    {
+        return _sensorIdx;
+    }
+
+    // Enable/disable (disabling forgets the state so re-enabling acts on the current level)
+    void setEnabled(bool enable)
+    {
+        _isEnabled = enable && isConfigured();
+        _isClosed = false;
+        _isStateKnown = false;
+        _wantStartMs = 0;
+        _waitReason = WAIT_NONE;
+    }
+    bool isEnabled() const
+    {
+        return _isEnabled;
+    }
+
+    // Position to move to for an action
+    uint32_t getActionPosPct(Action action) const
+    {
+        return action == ACTION_CLOSE ? _closePosPct : _openPosPct;
+    }
+
+    // Decide on an action from the filtered light level - the caller carries it out and calls actionDone()
+    // Part-way positions are timed moves so need the shade's travel times (end positions run to the end stop)
+    Action update(uint32_t nowMs, uint32_t luxLevel, bool travelKnown)
+    {
+        if (!_isEnabled)
+            return ACTION_NONE;
+        _luxLevel = luxLevel;
+
+        // Hysteresis - once closed the level must drop below the threshold less the hysteresis to open
+        bool wantClosed = _isClosed ? (luxLevel + _luxHyst >= _luxClose) : (luxLevel > _luxClose);
+        if (_isStateKnown && (wantClosed == _isClosed))
+        {
+            _wantStartMs = 0;
+            _waitReason = WAIT_NONE;
+            return ACTION_NONE;
+        }
+
+        // Wanted for long enough and dwell time since the last move passed
+        if (_wantStartMs == 0)
+            _wantStartMs = nowMs == 0 ? 1 : nowMs;
+        if (!Raft::isTimeout(nowMs, _wantStartMs, _confirmMs))
+        {
+            _waitReason = WAIT_CONFIRM;
+            return ACTION_NONE;
+        }
+        if (_isStateKnown && !Raft::isTimeout(nowMs, _lastActionMs, _dwellMs))
+        {
+            _waitReason = WAIT_DWELL;
+            return ACTION_NONE;
+        }
+        Action action = wantClosed ? ACTION_CLOSE : ACTION_OPEN;
+        uint32_t posPct = getActionPosPct(action);
+        if (!travelKnown && (posPct > 0) && (posPct < 100))
+        {
+            _waitReason = WAIT_TRAVEL;
+            return ACTION_NONE;
+        }
+        _waitReason = WAIT_BUSY;
+        return action;
+    }
+    void actionDone(uint32_t nowMs, Action action)
+    {
+        _isClosed = action == ACTION_CLOSE;
+        _isStateKnown = true;
+        _lastActionMs = nowMs;
+        _wantStartMs = 0;
+        _waitReason = WAIT_NONE;
+    }
+
+    // Status
+    String getStatusJSON() const
+    {
+        static const char* waitStrs[] = {"", "confirm", "dwell", "busy", "travel"};
+        return R"({"en":)" + String(_isEnabled ? 1 : 0) +
+                R"(,"state":")" + String(!_isStateKnown ? "" : (_isClosed ? "closed" : "open")) +
+                R"(","lux":)" + String(_luxLevel) +
+                R"(,"wait":")" + waitStrs[_waitReason] + R"("})";
+    }
+
+private:
+    // Config
+    static const uint32_t LUX_HYST_DEFAULT = 200;
+    static const uint32_t CONFIRM_SECS_DEFAULT = 5;
+    static const uint32_t DWELL_SECS_DEFAULT = 300;
+    uint32_t _sensorIdx = 0;
+    uint32_t _luxClose = 0;
+    uint32_t _luxHyst = LUX_HYST_DEFAULT;
+    uint32_t _closePosPct = 0;
+    uint32_t _openPosPct = 100;
+    uint32_t _confirmMs = CONFIRM_SECS_DEFAULT * 1000;
+    uint32_t _dwellMs = DWELL_SECS_DEFAULT * 1000;
+
+    // State
+    bool _isEnabled = false;
+    bool _isClosed = false;
+    bool _isStateKnown = false;
+    uint32_t _lastActionMs = 0;
+    uint32_t _wantStartMs = 0;
+    uint32_t _luxLevel = 0;
+
+    // Why a wanted change hasn't happened yet (reported in status)
+    enum WaitReason
+    {
+        WAIT_NONE,
+        WAIT_CONFIRM,
+        WAIT_DWELL,
+        WAIT_BUSY,
+        WAIT_TRAVEL
+    };
+    WaitReason _waitReason = WAIT_NONE;
+};
@@ -0,0 +1,121 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// ShadePosition
+// Dead-reckoning position of a shade from timed travel
+//
+// The shade motor latches - an UP or DOWN press moves the shade until STOP is pressed or the motor reaches
+// its end stop - so the position is integrated from when a move starts using the full-travel times. Reaching
+// an end stop (a move lasting at least the full travel time) re-homes the estimate. Position is in percent
+// open (100 is fully up) and is unknown until the shade has been homed.
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include "RaftUtils.h"
+
+class ShadePosition
+{
+public:
+    enum Motion
+    {
+        MOTION_STOPPED,
+        MOTION_UP,
+        MOTION_DOWN
+    };
+
+    static constexpr float POS_UNKNOWN = -1;
+    static constexpr float POS_FULLY_UP = 100;
+    static constexpr float POS_FULLY_DOWN = 0;
+
+    // Full-travel times (0 if not known)
+    void setTravelTimes(uint32_t travelUpMs, uint32_t travelDownMs)
+    {
+        _travelUpMs = travelUpMs;
+        _travelDownMs = travelDownMs;
+    }
+    uint32_t getTravelMs(bool isUp) const
+    {
+        return isUp ? _travelUpMs : _travelDownMs;
+    }
+    bool isTravelKnown() const
+    {
+        return (_travelUpMs > 0) && (_travelDownMs > 0);
+    }
+
+    // Move started (from the current estimate)
+    void startMove(bool isUp, uint32_t nowMs)
+    {
+        _startPosPct = getPosPct(nowMs);
+        _motion = isUp ? MOTION_UP : MOTION_DOWN;
+        _moveStartMs = nowMs;
+    }
+
+    // Move stopped part way
+    void stop(uint32_t nowMs)
+    {
+        _startPosPct = getPosPct(nowMs);
+        _motion = MOTION_STOPPED;
+    }
+
+    // Position known (at an end stop or after programming the motor)
+    void setPosPct(float posPct)
+    {
+        _startPosPct = posPct;
+        _motion = MOTION_STOPPED;
+    }
+
+    // Update - ends a move once the end stop would have been reached
+    void update(uint32_t nowMs)
+    {
+        if (_motion == MOTION_STOPPED)
+            return;
+        bool isUp = _motion == MOTION_UP;
+        float endPosPct = isUp ? POS_FULLY_UP : POS_FULLY_DOWN;
+        uint32_t travelMs = getTravelMs(isUp);
+        uint32_t moveMs = _startPosPct < 0 ? travelMs : getMoveMs(_startPosPct, endPosPct);
+        if ((travelMs == 0) || !Raft::isTimeout(nowMs, _moveStartMs, moveMs))
+            return;
+        setPosPct(endPosPct);
+    }
+
+    // Current estimate (POS_UNKNOWN if not homed - a move that runs to an end stop homes it)
+    float getPosPct(uint32_t nowMs) const
+    {
+        if (_motion == MOTION_STOPPED)
+            return _startPosPct;
+        bool isUp = _motion == MOTION_UP;
+        uint32_t travelMs = getTravelMs(isUp);
+        if ((_startPosPct < 0) || (travelMs == 0))
+            return POS_UNKNOWN;
+        float movedPct = 100.0f * (nowMs - _moveStartMs) / travelMs;
+        float posPct = isUp ? _startPosPct + movedPct : _startPosPct - movedPct;
+        return posPct > POS_FULLY_UP ? POS_FULLY_UP : (posPct < POS_FULLY_DOWN ? POS_FULLY_DOWN : posPct);
+    }
+    bool isPosKnown(uint32_t nowMs) const
+    {
+        return getPosPct(nowMs) >= 0;
+    }
+    Motion getMotion() const
+    {
+        return _motion;
+    }
+
+    // Time to move between known positions
+    uint32_t getMoveMs(float fromPosPct, float toPosPct) const
+    {
+        bool isUp = toPosPct > fromPosPct;
+        float deltaPct = isUp ? toPosPct - fromPosPct : fromPosPct - toPosPct;
+        return uint32_t(deltaPct * getTravelMs(isUp) / 100);
+    }
+
+private:
+    Motion _motion = MOTION_STOPPED;
+    float _startPosPct = POS_UNKNOWN;
+    uint32_t _moveStartMs = 0;
+    uint32_t _travelUpMs = 0;
+    uint32_t _travelDownMs = 0;
+};
@@ -24,6 +24,7 @@
 #include "ScaderElecMeters.h"
 #include "ScaderBTHome.h"
 #include "ScaderMarbleRun.h"
+#include "ScaderSchedule.h"
 // #include "ScaderCat.h"
 // #include "ScaderWaterer.h"
 #include "MotorControl.h"
@@ -80,6 +81,7 @@ extern "C" void app_main(void)
     raftCoreApp.registerSysMod("ScaderPulseCounter", ScaderPulseCounter::create, true);
     raftCoreApp.registerSysMod("ScaderBTHome", ScaderBTHome::create, true);
     raftCoreApp.registerSysMod("ScaderMarbleRun", ScaderMarbleRun::create, true);
+    raftCoreApp.registerSysMod("ScaderSchedule", ScaderSchedule::create, true);
     // raftCoreApp.registerSysMod("ScaderCat", ScaderCat::create, true);
     // raftCoreApp.registerSysMod("ScaderWaterer", ScaderWaterer::create, true);
 
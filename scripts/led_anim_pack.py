@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""
+Pack pre-rendered LED animation frames into the LEDA format played by the
+ScaderLEDPixels "playback" pattern (see LEDAnimStream.h).
+
+Input is either a raw RGB file (numLEDs x 3 bytes per frame, frames back to
+back) or a list of binary PPM (P6) images where the pixels are taken in
+row-major order as LED 0, 1, 2...
+
+Each frame is stored as whichever of RAW, RLE or DELTA is smallest, with a
+keyframe (RAW or RLE) forced at a fixed interval so playback can seek.
+
+Examples:
+    led_anim_pack.py --raw fire.rgb --leds 830 --fps 30 -o fire.leda
+    led_anim_pack.py --ppm frames/*.ppm --fps 25 -o tree.leda
+"""
+
+import argparse
+import struct
+import sys
+
+FRAME_RAW = 0
+FRAME_RLE = 1
+FRAME_DELTA = 2
+MAX_PAYLOAD = 0xffff
+
+
+def read_raw_frames(path: str, num_leds: int) -> list:
+    with open(path, "rb") as f:
+        data = f.read()
+    frame_len = num_leds * 3
+    if len(data) % frame_len != 0:
+        print(f"Warning: {path} has a partial frame at the end (ignored)", file=sys.stderr)
+    return [data[i:i + frame_len] for i in range(0, len(data) - frame_len + 1, frame_len)]
+
+
+def read_ppm(path: str) -> bytes:
+    with open(path, "rb") as f:
+        data = f.read()
+    # Header fields: magic, width, height, maxval - comments start with #
+    fields = []
+    pos = 0
+    while len(fields) < 4:
+        while data[pos:pos + 1].isspace():
+            pos += 1
+        if data[pos:pos + 1] == b"#":
+            pos = data.index(b"\n", pos) + 1
+            continue
+        end = pos
+        while not data[end:end + 1].isspace():
+            end += 1
+        fields.append(data[pos:end])
+        pos = end
+    if fields[0] != b"P6" or int(fields[3]) != 255:
+        raise ValueError(f"{path}: only 8-bit binary PPM (P6) is supported")
+    width, height = int(fields[1]), int(fields[2])
+    pos += 1
+    return data[pos:pos + width * height * 3]
+
+
+def encode_rle(frame: bytes) -> bytes:
+    out = bytearray()
+    i = 0
+    num_leds = len(frame) // 3
+    while i < num_leds:
+        rgb = frame[i * 3:i * 3 + 3]
+        run = 1
+        while i + run < num_leds and run < 255 and frame[(i + run) * 3:(i + run) * 3 + 3] == rgb:
+            run += 1
+        out += bytes([run]) + rgb
+        i += run
+    return bytes(out)
+
+
+def encode_delta(prev: bytes, frame: bytes) -> bytes:
+    out = bytearray()
+    num_leds = len(frame) // 3
+    i = 0
+    while i < num_leds:
+        # Skip unchanged pixels (max 255 per pair)
+        skip = 0
+        while i < num_leds and skip < 255 and frame[i * 3:i * 3 + 3] == prev[i * 3:i * 3 + 3]:
+            skip += 1
+            i += 1
+        # Literal run of changed pixels (max 255 per pair)
+        start = i
+        while i < num_leds and i - start < 255 and frame[i * 3:i * 3 + 3] != prev[i * 3:i * 3 + 3]:
+            i += 1
+        if i == num_leds and start == i:
+            break
+        out += bytes([skip, i - start]) + frame[start * 3:i * 3]
+    return bytes(out)
+
+
+def pack(frames: list, num_leds: int, fps: int, keyframe_interval: int) -> bytes:
+    out = bytearray(b"LEDA")
+    out += struct.pack("<BBHHHI", 1, 0, fps, num_leds, 0, len(frames))
+    prev = None
+    counts = [0, 0, 0]
+    for frame_idx, frame in enumerate(frames):
+        options = [(FRAME_RAW, frame), (FRAME_RLE, encode_rle(frame))]
+        if prev is not None and frame_idx % keyframe_interval != 0:
+            options.append((FRAME_DELTA, encode_delta(prev, frame)))
+        frame_type, payload = min(options, key=lambda opt: len(opt[1]))
+        if len(payload) > MAX_PAYLOAD:
+            raise ValueError(f"frame {frame_idx} payload too large ({len(payload)} bytes)")
+        out += struct.pack("<BH", frame_type, len(payload)) + payload
+        counts[frame_type] += 1
+        prev = frame
+    print(f"{len(frames)} frames: {counts[FRAME_RAW]} raw, {counts[FRAME_RLE]} rle, "
+          f"{counts[FRAME_DELTA]} delta, {len(out)} bytes")
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Pack LED animation frames into LEDA format")
+    src = parser.add_mutually_exclusive_group(required=True)
+    src.add_argument("--raw", help="raw RGB frames file")
+    src.add_argument("--ppm", nargs="+", help="PPM (P6) frame images in order")
+    parser.add_argument("--leds", type=int, help="number of LEDs (required for --raw)")
+    parser.add_argument("--fps", type=int, default=30, help="frames per second")
+    parser.add_argument("--keyframe-interval", type=int, default=30, help="frames between keyframes")
+    parser.add_argument("-o", "--output", required=True, help="output file")
+    args = parser.parse_args()
+
+    if args.raw:
+        if not args.leds:
+            parser.error("--leds is required with --raw")
+        frames = read_raw_frames(args.raw, args.leds)
+        num_leds = args.leds
+    else:
+        frames = [read_ppm(path) for path in args.ppm]
+        num_leds = args.leds if args.leds else len(frames[0]) // 3
+        frames = [frame[:num_leds * 3].ljust(num_leds * 3, b"\0") for frame in frames]
+
+    if not frames:
+        print("No frames", file=sys.stderr)
+        return 1
+
+    with open(args.output, "wb") as f:
+        f.write(pack(frames, num_leds, args.fps, max(1, args.keyframe_interval)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
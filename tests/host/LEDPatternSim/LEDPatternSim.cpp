@@ -0,0 +1,197 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// LEDPatternSim
+// Runs ScaderLEDPixels patterns on the host against a mock LEDPixelIF and a simulated clock
+//
+// Each shown frame can be written to a PPM image (one row per frame) or a raw RGB file (which
+// scripts/led_anim_pack.py --raw accepts) for visual diffing. Render time per frame is measured with
+// the real clock and a hash of all frames is printed so output changes are easy to spot.
+//
+// Usage: LEDPatternSim [--pattern <name>|all] [--frames N] [--leds N] [--tickMs N] [--params <json>]
+//                      [--brightnessPC N] [--seed N] [--ppm <file>] [--raw <file>]
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+#include "RaftCore.h"
+#include "MockLEDPixels.h"
+#include "LEDPatternRainbowSnake.h"
+#include "LEDPatternAutoID.h"
+#include "LEDPatternFire.h"
+#include "LEDPatternVM.h"
+#include "LEDPatternNoise.h"
+
+typedef LEDPatternBase* (*PatternCreateFn)(NamedValueProvider* pNamedValueProvider, LEDPixelIF& pixels);
+struct PatternInfo
+{
+    const char* pName;
+    PatternCreateFn createFn;
+    const char* pDefaultParams;
+};
+static const PatternInfo PATTERNS[] = {
+    { "RainbowSnake", &LEDPatternRainbowSnake::create, "{}" },
+    { "autoid", &LEDPatternAutoID::create, "{\"ledOnMs\":20,\"syncFlashMs\":20}" },
+    { "fire", &LEDPatternFire::create, "{}" },
+    { "vm", &LEDPatternVM::create, "{\"prog\":\"pixel: i 65536 * n / t 16 * + 255 128 hsv\",\"rateMs\":30}" },
+    { "noise", &LEDPatternNoise::create, "{\"palette\":\"lava\",\"scaleMm\":300,\"speed\":0.5}" },
+};
+
+struct SimOptions
+{
+    String patternName = "all";
+    uint32_t numFrames = 100;
+    uint32_t numLEDs = 830;
+    uint32_t tickMs = 1;
+    uint32_t brightnessPC = 100;
+    uint32_t seed = 1;
+    String params;
+    String ppmFile;
+    String rawFile;
+};
+
+static uint32_t fnv1a(uint32_t hash, const uint8_t* pData, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++)
+        hash = (hash ^ pData[i]) * 16777619u;
+    return hash;
+}
+
+static bool runPattern(const PatternInfo& info, const SimOptions& opts)
+{
+    // Fresh clock and random sequence for repeatable output
+    HostSim::clockUs() = 0;
+    srand(opts.seed);
+
+    MockLEDPixels pixels(opts.numLEDs, opts.brightnessPC);
+    LEDPatternBase* pPattern = info.createFn(nullptr, pixels);
+    String params = opts.params.length() > 0 ? opts.params : String(info.pDefaultParams);
+    pPattern->setup(params.c_str());
+
+    // Run until enough frames have been shown (or a long time has passed without any)
+    std::vector<uint8_t> frames;
+    std::vector<double> renderUs;
+    uint32_t hash = 2166136261u;
+    uint32_t maxTicks = opts.numFrames * 10000;
+    for (uint32_t tick = 0; (tick < maxTicks) && (renderUs.size() < opts.numFrames); tick++)
+    {
+        uint32_t showsBefore = pixels.getShowCount();
+        auto startTime = std::chrono::steady_clock::now();
+        pPattern->loop();
+        auto endTime = std::chrono::steady_clock::now();
+        if (pixels.getShowCount() != showsBefore)
+        {
+            renderUs.push_back(std::chrono::duration<double, std::micro>(endTime - startTime).count());
+            hash = fnv1a(hash, pixels.getRGB(), opts.numLEDs * 3);
+            if ((opts.ppmFile.length() > 0) || (opts.rawFile.length() > 0))
+                frames.insert(frames.end(), pixels.getRGB(), pixels.getRGB() + opts.numLEDs * 3);
+        }
+        HostSim::advanceUs(opts.tickMs * 1000);
+    }
+    delete pPattern;
+
+    // Report
+    if (renderUs.size() == 0)
+    {
+        printf("%-14s no frames shown in %u simulated ms\n", info.pName, maxTicks * opts.tickMs);
+        return false;
+    }
+    std::vector<double> sorted = renderUs;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0;
+    for (double us : sorted)
+        total += us;
+    printf("%-14s frames %4zu simMs %7u renderUs min %8.1f mean %8.1f p99 %8.1f max %8.1f hash %08x\n",
+                info.pName, sorted.size(), millis(), sorted.front(), total / sorted.size(),
+                sorted[(sorted.size() * 99) / 100 < sorted.size() ? (sorted.size() * 99) / 100 : sorted.size() - 1],
+                sorted.back(), hash);
+
+    // Frame files
+    if (opts.ppmFile.length() > 0)
+    {
+        FILE* pFile = fopen(opts.ppmFile.c_str(), "wb");
+        if (!pFile)
+            return false;
+        fprintf(pFile, "P6\n%u %zu\n255\n", opts.numLEDs, renderUs.size());
+        fwrite(frames.data(), 1, frames.size(), pFile);
+        fclose(pFile);
+    }
+    if (opts.rawFile.length() > 0)
+    {
+        FILE* pFile = fopen(opts.rawFile.c_str(), "wb");
+        if (!pFile)
+            return false;
+        fwrite(frames.data(), 1, frames.size(), pFile);
+        fclose(pFile);
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    SimOptions opts;
+    for (int i = 1; i < argc; i++)
+    {
+        String arg = argv[i];
+        const char* pVal = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!pVal)
+        {
+            fprintf(stderr, "Missing value for %s\n", arg.c_str());
+            return 2;
+        }
+        if (arg == "--pattern")
+            opts.patternName = pVal;
+        else if (arg == "--frames")
+            opts.numFrames = strtoul(pVal, nullptr, 10);
+        else if (arg == "--leds")
+            opts.numLEDs = strtoul(pVal, nullptr, 10);
+        else if (arg == "--tickMs")
+            opts.tickMs = std::max(1ul, strtoul(pVal, nullptr, 10));
+        else if (arg == "--brightnessPC")
+            opts.brightnessPC = strtoul(pVal, nullptr, 10);
+        else if (arg == "--seed")
+            opts.seed = strtoul(pVal, nullptr, 10);
+        else if (arg == "--params")
+            opts.params = pVal;
+        else if (arg == "--ppm")
+            opts.ppmFile = pVal;
+        else if (arg == "--raw")
+            opts.rawFile = pVal;
+        else
+        {
+            fprintf(stderr, "Unknown option %s\n", arg.c_str());
+            return 2;
+        }
+        i++;
+    }
+
+    // Frame files only make sense for a single pattern
+    bool runAll = opts.patternName.equalsIgnoreCase("all");
+    if (runAll && ((opts.ppmFile.length() > 0) || (opts.rawFile.length() > 0)))
+    {
+        fprintf(stderr, "--ppm and --raw need a single --pattern\n");
+        return 2;
+    }
+
+    bool allOk = true;
+    bool found = false;
+    for (const PatternInfo& info : PATTERNS)
+    {
+        if (!runAll && !opts.patternName.equalsIgnoreCase(info.pName))
+            continue;
+        found = true;
+        allOk &= runPattern(info, opts);
+    }
+    if (!found)
+    {
+        fprintf(stderr, "Unknown pattern %s\n", opts.patternName.c_str());
+        return 2;
+    }
+    return allOk ? 0 : 1;
+}
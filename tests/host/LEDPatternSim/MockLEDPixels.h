@@ -0,0 +1,92 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// MockLEDPixels
+// LEDPixelIF that keeps pixels in memory and captures a frame on each show()
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "LEDPixelIF.h"
+
+class MockLEDPixels : public LEDPixelIF
+{
+public:
+    MockLEDPixels(uint32_t numPixels, uint32_t brightnessPC) :
+        _pixels(numPixels * 3, 0),
+        _brightnessScale(brightnessPC >= 100 ? 256 : brightnessPC * 256 / 100)
+    {
+    }
+
+    virtual uint32_t getNumPixels() const override
+    {
+        return _pixels.size() / 3;
+    }
+    virtual void setRGB(uint32_t ledIdx, uint32_t r, uint32_t g, uint32_t b, bool applyBrightness = true) override
+    {
+        if (ledIdx >= getNumPixels())
+            return;
+        if (applyBrightness)
+        {
+            r = (r * _brightnessScale) >> 8;
+            g = (g * _brightnessScale) >> 8;
+            b = (b * _brightnessScale) >> 8;
+        }
+        _pixels[ledIdx * 3] = r > 255 ? 255 : r;
+        _pixels[ledIdx * 3 + 1] = g > 255 ? 255 : g;
+        _pixels[ledIdx * 3 + 2] = b > 255 ? 255 : b;
+    }
+    virtual void setRGB(uint32_t ledIdx, uint32_t c, bool applyBrightness = true) override
+    {
+        setRGB(ledIdx, (c >> 16) & 0xff, (c >> 8) & 0xff, c & 0xff, applyBrightness);
+    }
+    virtual void setHSV(uint32_t ledIdx, uint32_t h, uint32_t s, uint32_t v) override
+    {
+        // h 0..359, s and v 0..100
+        uint32_t region = (h % 360) / 60;
+        uint32_t remainder = (h % 60) * 255 / 60;
+        uint32_t vScaled = v * 255 / 100;
+        uint32_t sScaled = s * 255 / 100;
+        uint32_t p = (vScaled * (255 - sScaled)) / 255;
+        uint32_t q = (vScaled * (255 - (sScaled * remainder) / 255)) / 255;
+        uint32_t t = (vScaled * (255 - (sScaled * (255 - remainder)) / 255)) / 255;
+        switch (region)
+        {
+            case 0: setRGB(ledIdx, vScaled, t, p); break;
+            case 1: setRGB(ledIdx, q, vScaled, p); break;
+            case 2: setRGB(ledIdx, p, vScaled, t); break;
+            case 3: setRGB(ledIdx, p, q, vScaled); break;
+            case 4: setRGB(ledIdx, t, p, vScaled); break;
+            default: setRGB(ledIdx, vScaled, p, q); break;
+        }
+    }
+    virtual void clear() override
+    {
+        memset(_pixels.data(), 0, _pixels.size());
+    }
+    virtual bool show() override
+    {
+        _showCount++;
+        return true;
+    }
+
+    // Frame access
+    const uint8_t* getRGB() const
+    {
+        return _pixels.data();
+    }
+    uint32_t getShowCount() const
+    {
+        return _showCount;
+    }
+
+private:
+    std::vector<uint8_t> _pixels;
+    uint32_t _brightnessScale = 256;
+    uint32_t _showCount = 0;
+};
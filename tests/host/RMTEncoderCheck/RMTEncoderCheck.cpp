@@ -0,0 +1,232 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// RMTEncoderCheck
+// Checks the LED strip RMT symbol encoding (LEDRMTSymbolLUT) against the chip timing table
+//
+// For each chip row in evaluations/LEDPixelTiming/LEDPixelTiming.md and each RMT resolution the symbol LUT is
+// built exactly as LEDStripsRMT builds it, a test byte pattern is encoded and the symbol stream is decoded
+// back to bytes. The worst-case error of each bit type's high and low times and the reset length are
+// reported and the check fails if an error exceeds the tolerance, the data doesn't decode or the reset is
+// shorter than the chip needs.
+//
+// Usage: RMTEncoderCheck [--table <md file>] [--rmtHz <hz>[,<hz>...]] [--toleranceNs N] [--dump <chip>]
+//   Where a table cell holds min/typ/max values the typical value is used (or the first if no typical)
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include "LEDRMTSymbolLUT.h"
+
+#ifndef LED_TIMING_TABLE_PATH
+#define LED_TIMING_TABLE_PATH "LEDPixelTiming.md"
+#endif
+
+struct ChipTiming
+{
+    std::string name;
+    double t0hUs = 0;
+    double t0lUs = 0;
+    double t1hUs = 0;
+    double t1lUs = 0;
+    double resetUs = 0;
+};
+
+// Typical value from a cell like "0.4", "0.2/0.3/0.4", "0.8/—/—" or ">50"
+static bool parseCell(const std::string& cell, double& val)
+{
+    std::vector<double> vals;
+    const char* pCur = cell.c_str();
+    while (*pCur)
+    {
+        char* pEnd = nullptr;
+        double v = strtod(pCur, &pEnd);
+        if (pEnd != pCur)
+        {
+            vals.push_back(v);
+            pCur = pEnd;
+        }
+        else
+        {
+            pCur++;
+        }
+    }
+    if (vals.size() == 0)
+        return false;
+    val = vals.size() >= 3 ? vals[1] : vals[0];
+    return true;
+}
+
+static std::vector<ChipTiming> loadTable(const char* pFileName)
+{
+    std::vector<ChipTiming> chips;
+    FILE* pFile = fopen(pFileName, "r");
+    if (!pFile)
+        return chips;
+    char line[512];
+    while (fgets(line, sizeof(line), pFile))
+    {
+        // Table rows: | chip | bit rate | T0H | T0L | T1H | T1L | reset | source |
+        std::vector<std::string> cells;
+        std::string cur;
+        bool inRow = false;
+        for (const char* p = line; *p && (*p != '\n'); p++)
+        {
+            if (*p == '|')
+            {
+                if (inRow)
+                    cells.push_back(cur);
+                inRow = true;
+                cur.clear();
+            }
+            else
+            {
+                cur += *p;
+            }
+        }
+        ChipTiming chip;
+        if ((cells.size() < 7) || !parseCell(cells[2], chip.t0hUs) || !parseCell(cells[3], chip.t0lUs) ||
+                !parseCell(cells[4], chip.t1hUs) || !parseCell(cells[5], chip.t1lUs) || !parseCell(cells[6], chip.resetUs))
+            continue;
+        size_t start = cells[0].find_first_not_of(' ');
+        size_t end = cells[0].find_last_not_of(' ');
+        chip.name = cells[0].substr(start, end - start + 1);
+        chips.push_back(chip);
+    }
+    fclose(pFile);
+    return chips;
+}
+
+static bool checkChip(const ChipTiming& chip, uint32_t rmtHz, double toleranceNs, bool dump)
+{
+    LEDRMTSymbolLUT::Timing timing = LEDRMTSymbolLUT::timingFromUs(rmtHz, chip.t0hUs, chip.t0lUs,
+                chip.t1hUs, chip.t1lUs, chip.resetUs, true);
+    static LEDRMTSymbolLUT lut;
+    lut.build(timing);
+
+    // Encode a test pattern followed by the reset symbol (as the strip encoder does)
+    static const uint8_t TEST_BYTES[] = { 0x00, 0xff, 0xa5, 0x5a, 0x01, 0x80 };
+    const uint32_t numBytes = sizeof(TEST_BYTES);
+    std::vector<uint32_t> symbols(numBytes * LEDRMTSymbolLUT::SYMBOLS_PER_BYTE);
+    lut.encode(TEST_BYTES, numBytes, symbols.data());
+    symbols.push_back(lut.getResetSymbol());
+
+    // Decode and measure
+    double nsPerTick = 1e9 / rmtHz;
+    double worstErrNs[2][2] = {};
+    uint8_t decoded[numBytes] = {};
+    bool levelsOk = true;
+    for (uint32_t i = 0; i < numBytes * LEDRMTSymbolLUT::SYMBOLS_PER_BYTE; i++)
+    {
+        uint32_t sym = symbols[i];
+        double highNs = LEDRMTSymbolLUT::symbolDuration0(sym) * nsPerTick;
+        double lowNs = LEDRMTSymbolLUT::symbolDuration1(sym) * nsPerTick;
+        levelsOk &= (LEDRMTSymbolLUT::symbolLevel0(sym) == 1) && (LEDRMTSymbolLUT::symbolLevel1(sym) == 0);
+
+        // A bit is a 1 if its high time is nearer T1H than T0H
+        bool isOne = fabs(highNs - chip.t1hUs * 1000) < fabs(highNs - chip.t0hUs * 1000);
+        if (isOne)
+            decoded[i / 8] |= 0x80 >> (i % 8);
+        double expHighNs = (isOne ? chip.t1hUs : chip.t0hUs) * 1000;
+        double expLowNs = (isOne ? chip.t1lUs : chip.t0lUs) * 1000;
+        double* pWorst = worstErrNs[isOne ? 1 : 0];
+        if (fabs(highNs - expHighNs) > fabs(pWorst[0]))
+            pWorst[0] = highNs - expHighNs;
+        if (fabs(lowNs - expLowNs) > fabs(pWorst[1]))
+            pWorst[1] = lowNs - expLowNs;
+    }
+    bool dataOk = memcmp(decoded, TEST_BYTES, numBytes) == 0;
+
+    // Reset is the whole of the final symbol (both halves low) - neither half may be zero as a zero
+    // duration ends the transmission
+    uint32_t resetSym = symbols.back();
+    double resetUs = (LEDRMTSymbolLUT::symbolDuration0(resetSym) + LEDRMTSymbolLUT::symbolDuration1(resetSym)) * nsPerTick / 1000;
+    bool resetOk = (LEDRMTSymbolLUT::symbolLevel0(resetSym) == 0) && (LEDRMTSymbolLUT::symbolLevel1(resetSym) == 0) &&
+                   (LEDRMTSymbolLUT::symbolDuration0(resetSym) > 0) && (LEDRMTSymbolLUT::symbolDuration1(resetSym) > 0) &&
+                   (resetUs >= chip.resetUs - nsPerTick / 1000) && (resetUs <= chip.resetUs * 1.1 + nsPerTick / 1000);
+
+    bool timingOk = true;
+    for (auto& bitErr : worstErrNs)
+        for (double err : bitErr)
+            timingOk &= fabs(err) <= toleranceNs;
+    bool ok = levelsOk && dataOk && resetOk && timingOk;
+
+    printf("%-40.40s %3uMHz bit0 H%+6.1f L%+6.1f  bit1 H%+6.1f L%+6.1f ns  reset %6.1fus (%5.1f)  %s%s%s%s\n",
+            chip.name.c_str(), rmtHz / 1000000, worstErrNs[0][0], worstErrNs[0][1], worstErrNs[1][0], worstErrNs[1][1],
+            resetUs, chip.resetUs, ok ? "OK" : "FAIL", dataOk ? "" : " data", resetOk ? "" : " reset",
+            levelsOk ? "" : " levels");
+
+    // Symbol stream
+    if (dump)
+    {
+        for (uint32_t i = 0; i < symbols.size(); i++)
+        {
+            uint32_t sym = symbols[i];
+            printf("  %3u: %08x  L%u %5u  L%u %5u ticks%s\n", i, sym,
+                    LEDRMTSymbolLUT::symbolLevel0(sym), LEDRMTSymbolLUT::symbolDuration0(sym),
+                    LEDRMTSymbolLUT::symbolLevel1(sym), LEDRMTSymbolLUT::symbolDuration1(sym),
+                    i + 1 == symbols.size() ? "  (reset)" : "");
+        }
+    }
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    const char* pTableFile = LED_TIMING_TABLE_PATH;
+    std::vector<uint32_t> rmtHzList = { 10000000, 20000000, 40000000, 80000000 };
+    double toleranceNs = 150;
+    std::string dumpChip;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--table") == 0)
+        {
+            pTableFile = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "--rmtHz") == 0)
+        {
+            rmtHzList.clear();
+            for (const char* p = argv[i + 1]; *p; )
+            {
+                char* pEnd = nullptr;
+                rmtHzList.push_back(strtoul(p, &pEnd, 10));
+                p = (*pEnd == ',') ? pEnd + 1 : pEnd;
+                if (pEnd == p)
+                    break;
+            }
+        }
+        else if (strcmp(argv[i], "--toleranceNs") == 0)
+        {
+            toleranceNs = strtod(argv[i + 1], nullptr);
+        }
+        else if (strcmp(argv[i], "--dump") == 0)
+        {
+            dumpChip = argv[i + 1];
+        }
+        else
+        {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    std::vector<ChipTiming> chips = loadTable(pTableFile);
+    if (chips.size() == 0)
+    {
+        fprintf(stderr, "No chip timings found in %s\n", pTableFile);
+        return 2;
+    }
+
+    printf("Worst-case error vs table (tolerance %.0fns)\n", toleranceNs);
+    bool allOk = true;
+    for (const ChipTiming& chip : chips)
+        for (uint32_t rmtHz : rmtHzList)
+            allOk &= checkChip(chip, rmtHz, toleranceNs, (dumpChip.size() > 0) && (chip.name.find(dumpChip) == 0));
+    return allOk ? 0 : 1;
+}
@@ -0,0 +1,534 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// SPIDimmerSim
+// Runs SPIDimmer on the host against simulated mains sync edges, timers and SPI outputs
+//
+// Each scenario (clean, jittery/noisy, drifting 60Hz and burst dropout mains) is run in each dimmer mode
+// (esp_timer walk with hardware SPI or bit-banged SPI and the GPTimer ISR walk). The frames written to each
+// NCV7240 are decoded into per-channel output timelines and every half-cycle the firing time of each dimmed
+// channel is compared with the phase angle expected for its level and curve (relative to the true zero
+// crossing, not the dimmer's model of it). The variation of a channel's firing time between half-cycles
+// (flicker) and its average offset (level error) are checked against the same limits in every mode. Full on
+// and off channels must never change state and fading channels must move monotonically to their target.
+//
+// --bench times recalculateTimerSequence (via setChannelValues with all channels changed) and a fade step
+// (loop with all channels fading) at 8, 16 and 24 channels with the real clock.
+//
+// Usage: SPIDimmerSim [--scenario <name>|all] [--mode <name>|all] [--seconds N] [--seed N] [--bench]
+//                     [--verbose]
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+#include "RaftCore.h"
+#include "driver/gpio.h"
+#include "SPIDimmer.h"
+#include "SimMains.h"
+#include "SimSPICapture.h"
+
+// Pins
+static const int SIM_MOSI_PIN = 33;
+static const int SIM_SCLK_PIN = 16;
+static const int SIM_CS_PINS[] = { 15, 2, 4, 5 };
+static const int SIM_SYNC_PIN = 35;
+
+// Simulated latencies (typical ESP32 figures)
+static const uint32_t SYNC_ISR_LATENCY_US = 3;
+static const uint32_t GPTIMER_ISR_LATENCY_US = 3;
+static const uint32_t ESP_TIMER_TASK_LATENCY_US = 40;
+static const uint32_t SPI_POLLING_OVERHEAD_US = 10;
+
+// Firing window used by the checks
+static const float MIN_FIRING_PCT = 0.1;
+static const float MAX_FIRING_PCT = 50;
+static const uint32_t MERGE_US = 50;
+
+// Time allowed for the dimmer to lock before checking
+static const uint64_t SETTLE_US = 1500000;
+
+struct SimScenario
+{
+    const char* pName;
+    SimMainsConfig mains;
+};
+
+struct SimMode
+{
+    const char* pName;
+    uint32_t hwSPIHz;
+    bool useISRSchedule;
+};
+
+static SimScenario makeScenario(const char* pName, double mainsHz, double driftPct, uint32_t jitterUs,
+            double dropoutProb, uint32_t burstEvery, uint32_t burstLen, double noiseProb)
+{
+    SimScenario scenario;
+    scenario.pName = pName;
+    scenario.mains.mainsHz = mainsHz;
+    scenario.mains.driftPct = driftPct;
+    scenario.mains.driftPeriodS = 5;
+    scenario.mains.jitterUs = jitterUs;
+    scenario.mains.dropoutProb = dropoutProb;
+    scenario.mains.dropoutBurstEvery = burstEvery;
+    scenario.mains.dropoutBurstLen = burstLen;
+    scenario.mains.noiseProb = noiseProb;
+    return scenario;
+}
+
+static const SimScenario SCENARIOS[] = {
+    makeScenario("clean50", 50, 0, 0, 0, 0, 0, 0),
+    makeScenario("noisy50", 50, 0, 100, 0.02, 0, 0, 0.01),
+    makeScenario("drift60", 60, 0.5, 50, 0, 0, 0, 0),
+    makeScenario("burst50", 50, 0.2, 30, 0, 200, 6, 0),
+};
+
+static const SimMode MODES[] = {
+    { "task-hwspi", 4000000, false },
+    { "task-bitbang", 0, false },
+    { "isr", 0, true },
+};
+
+// Limits from what is visible - near the mains peak moving the firing time by dt moves 2 * dt / T of a
+// half-cycle's energy so 100us of variation (p99) is ~2% at 50Hz, around where lamp flicker starts to be seen,
+// and a single 250us step changes one 10ms half-cycle by ~5% which is too brief to see. A steady offset is
+// a level error rather than flicker - 250us is at most ~5% brightness at mid-level.
+static const double FLICKER_P99_US = 100;
+static const double FLICKER_MAX_US = 250;
+static const double LEVEL_OFFSET_MAX_US = 250;
+
+// Channel plan (levels in percent, curves and fades)
+struct SimChannel
+{
+    float levelPct = 0;
+    SPIDimmer::DimmingCurve curve = SPIDimmer::CURVE_LINEAR;
+    bool fades = false;
+};
+static const float FADE_FROM_PCT = 10;
+static const float FADE_TO_PCT = 90;
+static const uint64_t FADE_START_US = 4000000;
+static const uint32_t FADE_MS = 3000;
+
+static std::vector<SimChannel> getChannelPlan(uint32_t numChannels)
+{
+    std::vector<SimChannel> plan(numChannels);
+    for (uint32_t i = 0; i < numChannels; i++)
+    {
+        uint32_t chanInChip = i % 8;
+        SimChannel& chan = plan[i];
+        if (i == 0)
+            chan.levelPct = 0;
+        else if (chanInChip == 1)
+            chan.levelPct = 100;
+        else if ((i + 2 >= numChannels) && (numChannels > 8))
+        {
+            chan.levelPct = FADE_FROM_PCT;
+            chan.fades = true;
+        }
+        else
+            chan.levelPct = 5 + (i * 37) % 90;
+        if (chanInChip == 5)
+            chan.curve = SPIDimmer::CURVE_LED;
+    }
+    return plan;
+}
+
+// Expected firing time as a fraction of the half-cycle
+static double expectedFiringFraction(const SimChannel& chan, float levelPct)
+{
+    double level = levelPct / 100;
+    if (chan.curve == SPIDimmer::CURVE_LED)
+        level = level * level;
+    return (MAX_FIRING_PCT - (MAX_FIRING_PCT - MIN_FIRING_PCT) * level) / 100;
+}
+
+// Simulation of one dimmer against a set of mains edges
+static SimSPICapture* _pActiveCapture = nullptr;
+static void onSimGPIOWrite(int pin, int level)
+{
+    if (_pActiveCapture)
+        _pActiveCapture->onGPIOWrite(pin, level);
+}
+static void onSimSPITx(int csPin, const uint8_t* pData, uint32_t numBits)
+{
+    if (_pActiveCapture)
+        _pActiveCapture->onSPITx(csPin, pData, numBits);
+}
+
+class SimRun
+{
+public:
+    SimRun(uint32_t numChannels, const SimMode& mode, const SimMainsConfig& mainsConfig, uint64_t endUs, uint32_t seed)
+    {
+        // Fresh simulated hardware
+        HostSim::clockUs() = 0;
+        HostSim::clearSimTimers();
+        HostSim::gpioISRs().clear();
+        HostSim::espTimerLatencyUs() = ESP_TIMER_TASK_LATENCY_US;
+        HostSim::gptimerLatencyUs() = GPTIMER_ISR_LATENCY_US;
+        HostSim::spiTxOverheadUs() = SPI_POLLING_OVERHEAD_US;
+        HostSim::gpioWriteFn() = onSimGPIOWrite;
+        HostSim::spiTxFn() = onSimSPITx;
+
+        // Capture
+        uint32_t numChips = (numChannels + 7) / 8;
+        std::vector<int> csPins(SIM_CS_PINS, SIM_CS_PINS + numChips);
+        _capture.setup(SIM_MOSI_PIN, SIM_SCLK_PIN, csPins);
+        _pActiveCapture = &_capture;
+
+        // Dimmer
+        _pDimmer = new SPIDimmer();
+        _isSetup = _pDimmer->setup(SIM_MOSI_PIN, SIM_SCLK_PIN, csPins, SIM_SYNC_PIN, mode.hwSPIHz, mode.useISRSchedule);
+        _pDimmer->setFiringWindow(MIN_FIRING_PCT, MAX_FIRING_PCT, MERGE_US);
+
+        // Mains
+        _mains.generate(mainsConfig, 100000, endUs, seed);
+    }
+    ~SimRun()
+    {
+        delete _pDimmer;
+        _pActiveCapture = nullptr;
+        HostSim::clearSimTimers();
+    }
+
+    // Run until endUs (sync edges, timers and the dimmer loop every ms)
+    void runUntil(uint64_t endUs)
+    {
+        const std::vector<uint64_t>& edges = _mains.getSeenEdges();
+        while (HostSim::clockUs() < endUs)
+        {
+            uint64_t nextEdgeUs = _edgeIdx < edges.size() ? edges[_edgeIdx] : UINT64_MAX;
+            uint64_t nextUs = std::min(std::min(nextEdgeUs, _nextLoopUs), endUs);
+            HostSim::runTimersUntil(nextUs);
+            if (nextUs == nextEdgeUs)
+            {
+                HostSim::advanceUs(SYNC_ISR_LATENCY_US);
+                HostSim::triggerGPIOISR(SIM_SYNC_PIN);
+                _edgeIdx++;
+            }
+            if (nextUs == _nextLoopUs)
+            {
+                if (_loopEnabled)
+                    _pDimmer->loop();
+                _nextLoopUs += 1000;
+            }
+        }
+    }
+
+    // Loop calls can be disabled so the caller can time them
+    void setLoopEnabled(bool loopEnabled)
+    {
+        _loopEnabled = loopEnabled;
+    }
+    bool isSetup() const
+    {
+        return _isSetup;
+    }
+    SPIDimmer& dimmer()
+    {
+        return *_pDimmer;
+    }
+    const SimSPICapture& capture() const
+    {
+        return _capture;
+    }
+    const SimMains& mains() const
+    {
+        return _mains;
+    }
+
+private:
+    SPIDimmer* _pDimmer = nullptr;
+    bool _isSetup = false;
+    SimSPICapture _capture;
+    SimMains _mains;
+    uint32_t _edgeIdx = 0;
+    uint64_t _nextLoopUs = 1000;
+    bool _loopEnabled = true;
+};
+
+// Set levels for channels in the plan
+static void setPlanLevels(SPIDimmer& dimmer, const std::vector<SimChannel>& plan, bool fadingOnly, float fadeLevelPct, uint32_t fadeMs)
+{
+    std::vector<uint32_t> channelIdxs;
+    std::vector<float> levels;
+    for (uint32_t i = 0; i < plan.size(); i++)
+    {
+        if (fadingOnly && !plan[i].fades)
+            continue;
+        channelIdxs.push_back(i);
+        levels.push_back(plan[i].fades ? fadeLevelPct : plan[i].levelPct);
+    }
+    dimmer.setChannelValues(channelIdxs.data(), levels.data(), channelIdxs.size(), fadeMs);
+}
+
+// Firing time in a half-cycle (first off to on transition in the window) or -1 if none
+static int64_t getFiringUs(const std::vector<SimSPICapture::Transition>& transitions, uint32_t& searchIdx,
+            uint64_t startUs, uint64_t endUs)
+{
+    while ((searchIdx < transitions.size()) && (transitions[searchIdx].timeUs < startUs))
+        searchIdx++;
+    for (uint32_t i = searchIdx; (i < transitions.size()) && (transitions[i].timeUs < endUs); i++)
+    {
+        if (transitions[i].isOn)
+            return transitions[i].timeUs - startUs;
+    }
+    return -1;
+}
+
+static bool runScenario(const SimScenario& scenario, const SimMode& mode, uint32_t seconds, uint32_t seed, bool verbose)
+{
+    const uint32_t NUM_CHANNELS = 24;
+    uint64_t endUs = uint64_t(seconds) * 1000000;
+    std::vector<SimChannel> plan = getChannelPlan(NUM_CHANNELS);
+    SimRun sim(NUM_CHANNELS, mode, scenario.mains, endUs, seed);
+    if (!sim.isSetup())
+    {
+        printf("%-9s %-13s setup failed\n", scenario.pName, mode.pName);
+        return false;
+    }
+    for (uint32_t i = 0; i < plan.size(); i++)
+        sim.dimmer().setChannelCurve(i, plan[i].curve);
+    setPlanLevels(sim.dimmer(), plan, false, FADE_FROM_PCT, 0);
+
+    // Run with the fade started part way through
+    bool fadeUsed = endUs > FADE_START_US + FADE_MS * 1000 + SETTLE_US;
+    if (fadeUsed)
+    {
+        sim.runUntil(FADE_START_US);
+        setPlanLevels(sim.dimmer(), plan, true, FADE_TO_PCT, FADE_MS);
+    }
+    sim.runUntil(endUs);
+
+    // Check each half-cycle after settling
+    const SimMains& mains = sim.mains();
+    const SimSPICapture& capture = sim.capture();
+    std::vector<double> errorsUs;
+    std::vector<double> flickersUs;
+    double worstOffsetUs = 0;
+    uint32_t numMissed = 0;
+    uint32_t numGlitches = 0;
+    uint32_t numFadeReversals = 0;
+    double worstFadeEndErrUs = 0;
+    for (uint32_t chanIdx = 0; chanIdx < plan.size(); chanIdx++)
+    {
+        const SimChannel& chan = plan[chanIdx];
+        const std::vector<SimSPICapture::Transition>& transitions = capture.getTransitions(chanIdx);
+        bool isDimmed = chan.fades || ((chan.levelPct > 0) && (chan.levelPct < 100));
+
+        // Full on and off channels must not change after settling
+        if (!isDimmed)
+        {
+            for (const SimSPICapture::Transition& transition : transitions)
+            {
+                if (transition.timeUs >= SETTLE_US)
+                    numGlitches++;
+            }
+            continue;
+        }
+
+        // Dimmed channels fire once per half-cycle at the expected phase
+        uint32_t searchIdx = 0;
+        double lastFadeFraction = 1;
+        std::vector<double> chanErrorsUs;
+        for (uint32_t halfCycleIdx = 0; halfCycleIdx < mains.getNumHalfCycles(); halfCycleIdx++)
+        {
+            uint64_t zeroCrossUs = mains.getZeroCrossUs(halfCycleIdx);
+            uint32_t periodUs = mains.getPeriodUs(halfCycleIdx);
+            if ((zeroCrossUs < SETTLE_US) || (zeroCrossUs + periodUs >= endUs))
+                continue;
+            int64_t firingUs = getFiringUs(transitions, searchIdx, zeroCrossUs, zeroCrossUs + periodUs);
+            if (firingUs < 0)
+            {
+                numMissed++;
+                continue;
+            }
+
+            // Fading channels move monotonically (brighter fires earlier) and end at the target
+            if (chan.fades && fadeUsed)
+            {
+                double fraction = double(firingUs) / periodUs;
+                if (fraction > lastFadeFraction + FLICKER_MAX_US / periodUs)
+                    numFadeReversals++;
+                lastFadeFraction = fraction;
+                if (zeroCrossUs > FADE_START_US + FADE_MS * 1000 + 100000)
+                {
+                    double errUs = firingUs - expectedFiringFraction(chan, FADE_TO_PCT) * periodUs;
+                    worstFadeEndErrUs = std::max(worstFadeEndErrUs, fabs(errUs));
+                }
+                continue;
+            }
+            double errUs = firingUs - expectedFiringFraction(chan, chan.fades ? FADE_FROM_PCT : chan.levelPct) * periodUs;
+            chanErrorsUs.push_back(errUs);
+            errorsUs.push_back(fabs(errUs));
+        }
+        // Offset (mean error) and flicker (variation about the mean)
+        if (chanErrorsUs.size() == 0)
+            continue;
+        double meanErrUs = 0, maxFlickerUs = 0;
+        for (double err : chanErrorsUs)
+            meanErrUs += err;
+        meanErrUs /= chanErrorsUs.size();
+        worstOffsetUs = std::max(worstOffsetUs, fabs(meanErrUs));
+        for (double err : chanErrorsUs)
+        {
+            flickersUs.push_back(fabs(err - meanErrUs));
+            maxFlickerUs = std::max(maxFlickerUs, fabs(err - meanErrUs));
+        }
+        if (verbose)
+            printf("    chan %2u level %5.1f%% %s meanErrUs %7.1f maxFlickerUs %7.1f\n", chanIdx + 1, chan.levelPct,
+                        chan.curve == SPIDimmer::CURVE_LED ? "led   " : "linear", meanErrUs, maxFlickerUs);
+    }
+
+    // Report
+    std::sort(errorsUs.begin(), errorsUs.end());
+    double meanErrUs = 0;
+    for (double err : errorsUs)
+        meanErrUs += err;
+    meanErrUs = errorsUs.size() > 0 ? meanErrUs / errorsUs.size() : 0;
+    double p99ErrUs = errorsUs.size() > 0 ? errorsUs[std::min(errorsUs.size() - 1, (errorsUs.size() * 99) / 100)] : 0;
+    double maxErrUs = errorsUs.size() > 0 ? errorsUs.back() : 0;
+    std::sort(flickersUs.begin(), flickersUs.end());
+    double p99FlickerUs = flickersUs.size() > 0 ? flickersUs[std::min(flickersUs.size() - 1, (flickersUs.size() * 99) / 100)] : 0;
+    double maxFlickerUs = flickersUs.size() > 0 ? flickersUs.back() : 0;
+    // (the fade end error is a single half-cycle's error so may be an offset plus a step)
+    bool isOk = (errorsUs.size() > 0) && (p99FlickerUs <= FLICKER_P99_US) && (maxFlickerUs <= FLICKER_MAX_US) &&
+                (worstOffsetUs <= LEVEL_OFFSET_MAX_US) && (numMissed == 0) && (numGlitches == 0) && (numFadeReversals == 0) &&
+                (worstFadeEndErrUs <= LEVEL_OFFSET_MAX_US + FLICKER_MAX_US) && (capture.getNumBadFrames() == 0);
+    printf("%-9s %-13s firings %6zu absErrUs mean %6.1f p99 %6.1f max %6.1f flickerUs p99 %5.1f max %5.1f offsetUs %5.1f missed %u glitches %u fadeRev %u fadeEndErrUs %5.1f frames %u %s\n",
+                scenario.pName, mode.pName, errorsUs.size(), meanErrUs, p99ErrUs, maxErrUs, p99FlickerUs, maxFlickerUs,
+                worstOffsetUs, numMissed, numGlitches, numFadeReversals, worstFadeEndErrUs, capture.getNumFrames(),
+                isOk ? "OK" : "FAIL");
+    if (verbose)
+        printf("    sync %s\n    timing %s\n", sim.dimmer().getSyncStatusJSON().c_str(),
+                    sim.dimmer().getTimingStatsJSON(false).c_str());
+    return isOk;
+}
+
+// Benchmark sequence recalculation and fade steps
+static void runBenchmark(uint32_t seed)
+{
+    const uint32_t NUM_ITERATIONS = 2000;
+    SimScenario scenario = SCENARIOS[0];
+    for (uint32_t numChannels : { 8, 16, 24 })
+    {
+        SimRun sim(numChannels, MODES[0], scenario.mains, 60000000, seed);
+        sim.runUntil(SETTLE_US);
+        if (!sim.dimmer().isMainsSyncValid())
+        {
+            printf("bench %2u channels - mains sync not valid\n", numChannels);
+            continue;
+        }
+
+        // Full recalculation with all channels dimmed at changing levels
+        std::vector<uint32_t> channelIdxs(numChannels);
+        std::vector<float> levels(numChannels);
+        double recalcUs = 0;
+        for (uint32_t iter = 0; iter < NUM_ITERATIONS; iter++)
+        {
+            for (uint32_t i = 0; i < numChannels; i++)
+            {
+                channelIdxs[i] = i;
+                levels[i] = 1 + ((i * 7 + iter) % 98);
+            }
+            auto startTime = std::chrono::steady_clock::now();
+            sim.dimmer().setChannelValues(channelIdxs.data(), levels.data(), numChannels, 0);
+            auto endTime = std::chrono::steady_clock::now();
+            recalcUs += std::chrono::duration<double, std::micro>(endTime - startTime).count();
+        }
+
+        // Fade step with all channels fading (each loop after a half-cycle steps every channel)
+        for (uint32_t i = 0; i < numChannels; i++)
+            levels[i] = 99 - levels[i];
+        sim.dimmer().setChannelValues(channelIdxs.data(), levels.data(), numChannels, 60000);
+        sim.setLoopEnabled(false);
+        double fadeStepUs = 0;
+        uint32_t numFadeSteps = 0;
+        uint64_t simUs = HostSim::clockUs();
+        for (uint32_t iter = 0; (iter < NUM_ITERATIONS) && sim.dimmer().isFading(); iter++)
+        {
+            simUs += 10000;
+            sim.runUntil(simUs);
+            auto startTime = std::chrono::steady_clock::now();
+            sim.dimmer().loop();
+            auto endTime = std::chrono::steady_clock::now();
+            fadeStepUs += std::chrono::duration<double, std::micro>(endTime - startTime).count();
+            numFadeSteps++;
+        }
+        printf("bench %2u channels recalculateTimerSequence %6.2fus fadeStep %6.2fus\n", numChannels,
+                    recalcUs / NUM_ITERATIONS, numFadeSteps > 0 ? fadeStepUs / numFadeSteps : 0);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    String scenarioName = "all";
+    String modeName = "all";
+    uint32_t seconds = 20;
+    uint32_t seed = 1;
+    bool bench = false;
+    bool verbose = false;
+    for (int i = 1; i < argc; i++)
+    {
+        String arg = argv[i];
+        if (arg == "--bench")
+        {
+            bench = true;
+            continue;
+        }
+        if (arg == "--verbose")
+        {
+            verbose = true;
+            continue;
+        }
+        const char* pVal = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!pVal)
+        {
+            fprintf(stderr, "Missing value for %s\n", arg.c_str());
+            return 2;
+        }
+        if (arg == "--scenario")
+            scenarioName = pVal;
+        else if (arg == "--mode")
+            modeName = pVal;
+        else if (arg == "--seconds")
+            seconds = std::max(3ul, strtoul(pVal, nullptr, 10));
+        else if (arg == "--seed")
+            seed = strtoul(pVal, nullptr, 10);
+        else
+        {
+            fprintf(stderr, "Unknown option %s\n", arg.c_str());
+            return 2;
+        }
+        i++;
+    }
+
+    bool allOk = true;
+    bool found = false;
+    for (const SimScenario& scenario : SCENARIOS)
+    {
+        if (!scenarioName.equalsIgnoreCase("all") && !scenarioName.equalsIgnoreCase(scenario.pName))
+            continue;
+        for (const SimMode& mode : MODES)
+        {
+            if (!modeName.equalsIgnoreCase("all") && !modeName.equalsIgnoreCase(mode.pName))
+                continue;
+            found = true;
+            allOk &= runScenario(scenario, mode, seconds, seed, verbose);
+        }
+    }
+    if (!found)
+    {
+        fprintf(stderr, "Unknown scenario %s or mode %s\n", scenarioName.c_str(), modeName.c_str());
+        return 2;
+    }
+    if (bench)
+        runBenchmark(seed);
+    return allOk ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// SimMains
+// Synthetic mains sync edges for the SPIDimmer simulator
+//
+// The true half-cycle period follows the nominal frequency with a slow sinusoidal drift. Each true sync edge
+// is followed by the zero crossing zeroCrossOffsetUs later (matching SPIDimmer's model). Edges seen by the
+// dimmer have uniform jitter, some are dropped (singly at random or in bursts) and noise edges are added at
+// random points in the half-cycle.
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+struct SimMainsConfig
+{
+    double mainsHz = 50;
+    double driftPct = 0;
+    double driftPeriodS = 10;
+    uint32_t jitterUs = 0;
+    double dropoutProb = 0;
+    uint32_t dropoutBurstEvery = 0;
+    uint32_t dropoutBurstLen = 0;
+    double noiseProb = 0;
+    uint32_t zeroCrossOffsetUs = 3000;
+};
+
+class SimMains
+{
+public:
+    // Generate edges up to endUs
+    void generate(const SimMainsConfig& config, uint64_t startUs, uint64_t endUs, uint32_t seed)
+    {
+        _config = config;
+        _trueSyncUs.clear();
+        _seenEdgesUs.clear();
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<double> unit(0, 1);
+        double edgeUs = startUs;
+        uint32_t halfCycleIdx = 0;
+        while (edgeUs < endUs)
+        {
+            double periodUs = halfCyclePeriodUs(edgeUs);
+            _trueSyncUs.push_back(uint64_t(edgeUs));
+
+            // Seen edge (unless dropped)
+            bool inBurst = (config.dropoutBurstEvery > 0) && (halfCycleIdx % config.dropoutBurstEvery) >= config.dropoutBurstEvery - config.dropoutBurstLen;
+            if (!inBurst && (unit(rng) >= config.dropoutProb))
+            {
+                double jitter = config.jitterUs > 0 ? (unit(rng) * 2 - 1) * config.jitterUs : 0;
+                _seenEdgesUs.push_back(uint64_t(edgeUs + jitter));
+            }
+
+            // Noise edge
+            if (unit(rng) < config.noiseProb)
+                _seenEdgesUs.push_back(uint64_t(edgeUs + periodUs * (0.1 + 0.8 * unit(rng))));
+
+            edgeUs += periodUs;
+            halfCycleIdx++;
+        }
+        std::sort(_seenEdgesUs.begin(), _seenEdgesUs.end());
+    }
+
+    // Edges seen by the dimmer (in time order)
+    const std::vector<uint64_t>& getSeenEdges() const
+    {
+        return _seenEdgesUs;
+    }
+
+    // True half-cycles
+    uint32_t getNumHalfCycles() const
+    {
+        return _trueSyncUs.size() > 0 ? _trueSyncUs.size() - 1 : 0;
+    }
+    uint64_t getZeroCrossUs(uint32_t halfCycleIdx) const
+    {
+        return _trueSyncUs[halfCycleIdx] + _config.zeroCrossOffsetUs;
+    }
+    uint32_t getPeriodUs(uint32_t halfCycleIdx) const
+    {
+        return _trueSyncUs[halfCycleIdx + 1] - _trueSyncUs[halfCycleIdx];
+    }
+
+private:
+    SimMainsConfig _config;
+    std::vector<uint64_t> _trueSyncUs;
+    std::vector<uint64_t> _seenEdgesUs;
+
+    double halfCyclePeriodUs(double atUs) const
+    {
+        double drift = _config.driftPct / 100 * sin(2 * M_PI * atUs / (_config.driftPeriodS * 1e6));
+        return 1e6 / (2 * _config.mainsHz * (1 + drift));
+    }
+};
@@ -0,0 +1,155 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// SimSPICapture
+// Captures the 16-bit frames written to each NCV7240 (bit-banged via the simulated GPIO or sent by the SPI
+// master shim) and keeps the resulting on/off timeline of every channel output
+//
+// A frame takes effect when its CS goes high - bit-banged frames are sampled on the falling SCLK edge
+// (SPI mode 1 as used by the NCV7240).
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "RaftArduino.h"
+
+class SimSPICapture
+{
+public:
+    static const uint32_t CHANNELS_PER_CHIP = 8;
+    static const uint16_t CHANNEL_ON_BITS = 0b10;
+
+    // Output transition
+    struct Transition
+    {
+        uint64_t timeUs;
+        bool isOn;
+    };
+
+    void setup(int mosiPin, int sclkPin, const std::vector<int>& csPins)
+    {
+        _mosiPin = mosiPin;
+        _sclkPin = sclkPin;
+        _csPins = csPins;
+        _chipBits.assign(csPins.size(), 0);
+        _chipNumBits.assign(csPins.size(), 0);
+        _csLow.assign(csPins.size(), false);
+        _channelOn.assign(csPins.size() * CHANNELS_PER_CHIP, false);
+        _transitions.assign(csPins.size() * CHANNELS_PER_CHIP, std::vector<Transition>());
+        _numFrames = 0;
+        _numBadFrames = 0;
+    }
+
+    // GPIO write (bit-banged SPI)
+    void onGPIOWrite(int pin, int level)
+    {
+        if (pin == _mosiPin)
+        {
+            _mosiLevel = level;
+            return;
+        }
+        if (pin == _sclkPin)
+        {
+            if (!level && _sclkLevel)
+            {
+                for (uint32_t chipIdx = 0; chipIdx < _csPins.size(); chipIdx++)
+                {
+                    if (!_csLow[chipIdx])
+                        continue;
+                    _chipBits[chipIdx] = (_chipBits[chipIdx] << 1) | (_mosiLevel ? 1 : 0);
+                    _chipNumBits[chipIdx]++;
+                }
+            }
+            _sclkLevel = level;
+            return;
+        }
+        int chipIdx = getChipIdx(pin);
+        if (chipIdx < 0)
+            return;
+        if (!level)
+        {
+            _csLow[chipIdx] = true;
+            _chipBits[chipIdx] = 0;
+            _chipNumBits[chipIdx] = 0;
+        }
+        else if (_csLow[chipIdx])
+        {
+            _csLow[chipIdx] = false;
+            onFrame(chipIdx, _chipBits[chipIdx], _chipNumBits[chipIdx]);
+        }
+    }
+
+    // Frame from the SPI master
+    void onSPITx(int csPin, const uint8_t* pData, uint32_t numBits)
+    {
+        int chipIdx = getChipIdx(csPin);
+        if (chipIdx >= 0)
+            onFrame(chipIdx, (uint32_t(pData[0]) << 8) | pData[1], numBits);
+    }
+
+    // Channel output timelines
+    const std::vector<Transition>& getTransitions(uint32_t channelIdx) const
+    {
+        return _transitions[channelIdx];
+    }
+    bool isChannelOn(uint32_t channelIdx) const
+    {
+        return _channelOn[channelIdx];
+    }
+    uint32_t getNumFrames() const
+    {
+        return _numFrames;
+    }
+    uint32_t getNumBadFrames() const
+    {
+        return _numBadFrames;
+    }
+
+private:
+    int _mosiPin = -1;
+    int _sclkPin = -1;
+    std::vector<int> _csPins;
+    int _mosiLevel = 0;
+    int _sclkLevel = 0;
+    std::vector<uint32_t> _chipBits;
+    std::vector<uint32_t> _chipNumBits;
+    std::vector<bool> _csLow;
+    std::vector<bool> _channelOn;
+    std::vector<std::vector<Transition>> _transitions;
+    uint32_t _numFrames = 0;
+    uint32_t _numBadFrames = 0;
+
+    int getChipIdx(int csPin) const
+    {
+        for (uint32_t i = 0; i < _csPins.size(); i++)
+        {
+            if (_csPins[i] == csPin)
+                return i;
+        }
+        return -1;
+    }
+
+    void onFrame(uint32_t chipIdx, uint32_t frame, uint32_t numBits)
+    {
+        _numFrames++;
+        if (numBits != CHANNELS_PER_CHIP * 2)
+        {
+            _numBadFrames++;
+            return;
+        }
+        for (uint32_t chanIdx = 0; chanIdx < CHANNELS_PER_CHIP; chanIdx++)
+        {
+            uint32_t channelIdx = chipIdx * CHANNELS_PER_CHIP + chanIdx;
+            bool isOn = ((frame >> (chanIdx * 2)) & 0b11) == CHANNEL_ON_BITS;
+            if (isOn != _channelOn[channelIdx])
+            {
+                _channelOn[channelIdx] = isOn;
+                _transitions[channelIdx].push_back({ HostSim::clockUs(), isOn });
+            }
+        }
+    }
+};
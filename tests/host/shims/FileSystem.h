@@ -0,0 +1,38 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Host build shim for FileSystem - files are opened relative to the current directory
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdio.h>
+#include "RaftArduino.h"
+
+class FileSystem
+{
+public:
+    FILE* fileOpen(const String& fsName, const String& fileName, bool writeMode, uint32_t seekToPos)
+    {
+        FILE* pFile = fopen(fileName.c_str(), writeMode ? "wb" : "rb");
+        if (pFile && seekToPos)
+            fseek(pFile, seekToPos, SEEK_SET);
+        return pFile;
+    }
+    uint32_t fileRead(FILE* pFile, uint8_t* pBuf, uint32_t bufLen)
+    {
+        return fread(pBuf, 1, bufLen, pFile);
+    }
+    uint32_t fileWrite(FILE* pFile, const uint8_t* pBuf, uint32_t bufLen)
+    {
+        return fwrite(pBuf, 1, bufLen, pFile);
+    }
+    bool fileClose(FILE* pFile, const String& fsName, const String& fileName, bool writeMode)
+    {
+        return fclose(pFile) == 0;
+    }
+};
+
+inline FileSystem fileSystem;
@@ -0,0 +1,106 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Host simulation of one-shot hardware and esp_timer timers
+//
+// Timers are fired in due time order by HostSim::runTimersUntil() which moves the simulated clock to each
+// timer's due time (plus its dispatch latency) before calling it. Callbacks run to completion in zero
+// simulated time unless they advance the clock themselves (e.g. delayMicroseconds while bit-banging) so
+// later timers can fire late just as they would on the target.
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <functional>
+#include "RaftArduino.h"
+
+namespace HostSim
+{
+    struct SimTimer
+    {
+        std::function<void()> fireFn;
+        uint64_t dueUs = 0;
+        uint32_t latencyUs = 0;
+        bool armed = false;
+    };
+
+    inline std::vector<SimTimer*>& simTimers()
+    {
+        static std::vector<SimTimer*> timers;
+        return timers;
+    }
+
+    inline SimTimer* addSimTimer(std::function<void()> fireFn, uint32_t latencyUs)
+    {
+        SimTimer* pTimer = new SimTimer();
+        pTimer->fireFn = fireFn;
+        pTimer->latencyUs = latencyUs;
+        simTimers().push_back(pTimer);
+        return pTimer;
+    }
+
+    inline void removeSimTimer(SimTimer* pTimer)
+    {
+        std::vector<SimTimer*>& timers = simTimers();
+        for (auto it = timers.begin(); it != timers.end(); ++it)
+        {
+            if (*it == pTimer)
+            {
+                timers.erase(it);
+                break;
+            }
+        }
+        delete pTimer;
+    }
+
+    // Remove all timers (between simulation runs)
+    inline void clearSimTimers()
+    {
+        for (SimTimer* pTimer : simTimers())
+            delete pTimer;
+        simTimers().clear();
+    }
+
+    // Dispatch latency applied to timers when created (set by the host tool per timer type)
+    inline uint32_t& espTimerLatencyUs()
+    {
+        static uint32_t latencyUs = 0;
+        return latencyUs;
+    }
+    inline uint32_t& gptimerLatencyUs()
+    {
+        static uint32_t latencyUs = 0;
+        return latencyUs;
+    }
+
+    // Fire timers due (including latency) before endUs in time order then move the clock to endUs
+    inline void runTimersUntil(uint64_t endUs)
+    {
+        while (true)
+        {
+            SimTimer* pNext = nullptr;
+            uint64_t fireUs = 0;
+            for (SimTimer* pTimer : simTimers())
+            {
+                uint64_t timerFireUs = pTimer->dueUs + pTimer->latencyUs;
+                if (pTimer->armed && (timerFireUs < endUs) && (!pNext || (timerFireUs < fireUs)))
+                {
+                    pNext = pTimer;
+                    fireUs = timerFireUs;
+                }
+            }
+            if (!pNext)
+                break;
+            pNext->armed = false;
+            if (fireUs > clockUs())
+                clockUs() = fireUs;
+            pNext->fireFn();
+        }
+        if (endUs > clockUs())
+            clockUs() = endUs;
+    }
+}
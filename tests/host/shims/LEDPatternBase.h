@@ -0,0 +1,35 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Host build shim for LEDPatternBase
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include "LEDPixelIF.h"
+
+class NamedValueProvider
+{
+};
+
+class LEDPatternBase
+{
+public:
+    LEDPatternBase(NamedValueProvider* pNamedValueProvider, LEDPixelIF& pixels) :
+        _pNamedValueProvider(pNamedValueProvider), _pixels(pixels)
+    {
+    }
+    virtual ~LEDPatternBase()
+    {
+    }
+    virtual void setup(const char* pParamsJson = nullptr) = 0;
+    virtual void loop() = 0;
+
+protected:
+    NamedValueProvider* _pNamedValueProvider = nullptr;
+    LEDPixelIF& _pixels;
+    uint32_t _refreshRateMs = 30;
+};
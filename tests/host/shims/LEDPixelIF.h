@@ -0,0 +1,23 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Host build shim for LEDPixelIF
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+class LEDPixelIF
+{
+public:
+    virtual ~LEDPixelIF() {}
+    virtual uint32_t getNumPixels() const = 0;
+    virtual void setRGB(uint32_t ledIdx, uint32_t r, uint32_t g, uint32_t b, bool applyBrightness = true) = 0;
+    virtual void setRGB(uint32_t ledIdx, uint32_t c, bool applyBrightness = true) = 0;
+    virtual void setHSV(uint32_t ledIdx, uint32_t h, uint32_t s, uint32_t v) = 0;
+    virtual void clear() = 0;
+    virtual bool show() = 0;
+};
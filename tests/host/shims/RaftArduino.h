@@ -0,0 +1,124 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Host build shim for RaftArduino.h
+// Minimal String plus a simulated clock (millis/micros are advanced by the host tool, not real time) and
+// simulated GPIO outputs
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+#include <algorithm>
+#include <cctype>
+#include <strings.h>
+
+class String : public std::string
+{
+public:
+    String() {}
+    String(const char* pStr) : std::string(pStr ? pStr : "") {}
+    String(const std::string& str) : std::string(str) {}
+    String(int val) : std::string(std::to_string(val)) {}
+    String(unsigned int val) : std::string(std::to_string(val)) {}
+    String(long val) : std::string(std::to_string(val)) {}
+    String(unsigned long val) : std::string(std::to_string(val)) {}
+    String(double val) : std::string(std::to_string(val)) {}
+    String operator+(const String& other) const
+    {
+        return String(std::string(*this) + std::string(other));
+    }
+    String operator+(const char* pStr) const
+    {
+        return String(std::string(*this) + pStr);
+    }
+    friend String operator+(const char* pStr, const String& str)
+    {
+        return String(std::string(pStr) + std::string(str));
+    }
+    bool equalsIgnoreCase(const String& other) const
+    {
+        return strcasecmp(c_str(), other.c_str()) == 0;
+    }
+    bool startsWith(const String& prefix) const
+    {
+        return compare(0, prefix.size(), prefix) == 0;
+    }
+    String substring(size_t from, size_t to = std::string::npos) const
+    {
+        if (from >= size())
+            return String();
+        return String(substr(from, to == std::string::npos ? std::string::npos : to - from));
+    }
+    void toUpperCase()
+    {
+        std::transform(begin(), end(), begin(), ::toupper);
+    }
+    void trim()
+    {
+        size_t start = find_first_not_of(" \t\r\n");
+        size_t end = find_last_not_of(" \t\r\n");
+        *this = (start == std::string::npos) ? String() : String(substr(start, end - start + 1));
+    }
+    long toInt() const
+    {
+        return strtol(c_str(), nullptr, 10);
+    }
+    char charAt(size_t idx) const
+    {
+        return idx < size() ? (*this)[idx] : 0;
+    }
+};
+
+// Simulated clock
+namespace HostSim
+{
+    inline uint64_t& clockUs()
+    {
+        static uint64_t us = 0;
+        return us;
+    }
+    inline void advanceUs(uint64_t us)
+    {
+        clockUs() += us;
+    }
+}
+inline uint32_t millis()
+{
+    return HostSim::clockUs() / 1000;
+}
+inline uint32_t micros()
+{
+    return HostSim::clockUs();
+}
+inline void delayMicroseconds(uint32_t us)
+{
+    HostSim::advanceUs(us);
+}
+
+// Simulated GPIO - output writes are passed to a hook set by the host tool
+#define LOW 0
+#define HIGH 1
+#define INPUT 0x01
+#define OUTPUT 0x03
+namespace HostSim
+{
+    typedef void (*GPIOWriteFn)(int pin, int level);
+    inline GPIOWriteFn& gpioWriteFn()
+    {
+        static GPIOWriteFn fn = nullptr;
+        return fn;
+    }
+}
+inline void pinMode(int pin, int mode)
+{
+}
+inline void digitalWrite(int pin, int level)
+{
+    if (HostSim::gpioWriteFn())
+        HostSim::gpioWriteFn()(pin, level);
+}
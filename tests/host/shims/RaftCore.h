@@ -0,0 +1,34 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Host build shim for RaftCore.h
+// Just enough of RaftCore for the LED pattern and dimmer classes to build on Linux
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdio.h>
+#include "RaftArduino.h"
+#include "RaftJson.h"
+#include "LEDPixelIF.h"
+#include "LEDPatternBase.h"
+
+// Logging (quiet unless HOST_SIM_VERBOSE is defined)
+#ifdef HOST_SIM_VERBOSE
+#define LOG_I(prefix, ...) (fprintf(stderr, "I %s: ", prefix), fprintf(stderr, __VA_ARGS__), fprintf(stderr, "\n"))
+#else
+#define LOG_I(prefix, ...) do {} while (0)
+#endif
+#define LOG_W(prefix, ...) (fprintf(stderr, "W %s: ", prefix), fprintf(stderr, __VA_ARGS__), fprintf(stderr, "\n"))
+#define LOG_E(prefix, ...) (fprintf(stderr, "E %s: ", prefix), fprintf(stderr, __VA_ARGS__), fprintf(stderr, "\n"))
+
+namespace Raft
+{
+    template <typename T>
+    inline bool isTimeout(T curTime, T lastTime, T maxDuration)
+    {
+        return T(curTime - lastTime) > maxDuration;
+    }
+}
@@ -0,0 +1,77 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Host build shim for RaftJson
+// Looks up top-level keys in a flat JSON object, which covers pattern parameters
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdlib.h>
+#include "RaftArduino.h"
+
+class RaftJson
+{
+public:
+    RaftJson(const char* pJson, bool makeCopy = true) : _json(pJson ? pJson : "")
+    {
+    }
+    RaftJson(const String& json) : _json(json)
+    {
+    }
+    long getLong(const char* pKey, long defaultVal) const
+    {
+        String val;
+        return getValue(pKey, val) ? strtol(val.c_str(), nullptr, 0) : defaultVal;
+    }
+    double getDouble(const char* pKey, double defaultVal) const
+    {
+        String val;
+        return getValue(pKey, val) ? strtod(val.c_str(), nullptr) : defaultVal;
+    }
+    bool getBool(const char* pKey, bool defaultVal) const
+    {
+        String val;
+        if (!getValue(pKey, val))
+            return defaultVal;
+        return (val == "true") || (strtol(val.c_str(), nullptr, 0) != 0);
+    }
+    String getString(const char* pKey, const char* pDefault) const
+    {
+        String val;
+        return getValue(pKey, val) ? val : String(pDefault);
+    }
+    const char* c_str() const
+    {
+        return _json.c_str();
+    }
+
+private:
+    String _json;
+
+    bool getValue(const char* pKey, String& val) const
+    {
+        String quotedKey = String("\"") + pKey + "\"";
+        size_t pos = _json.find(quotedKey);
+        if (pos == std::string::npos)
+            return false;
+        pos = _json.find(':', pos + quotedKey.size());
+        if (pos == std::string::npos)
+            return false;
+        pos = _json.find_first_not_of(" \t\r\n", pos + 1);
+        if (pos == std::string::npos)
+            return false;
+        if (_json[pos] == '"')
+        {
+            size_t end = _json.find('"', pos + 1);
+            val = _json.substring(pos + 1, end);
+            return end != std::string::npos;
+        }
+        size_t end = _json.find_first_of(",}", pos);
+        val = _json.substring(pos, end);
+        val.trim();
+        return true;
+    }
+};
@@ -0,0 +1,95 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Host build shim for driver/gpio.h
+// Interrupt handlers are recorded per pin and called by the host tool with HostSim::triggerGPIOISR()
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include <map>
+#include "esp_err.h"
+
+typedef int gpio_num_t;
+typedef void (*gpio_isr_t)(void* arg);
+typedef enum
+{
+    GPIO_MODE_DISABLE = 0,
+    GPIO_MODE_INPUT = 1,
+    GPIO_MODE_OUTPUT = 2
+} gpio_mode_t;
+typedef enum
+{
+    GPIO_PULLUP_DISABLE = 0,
+    GPIO_PULLUP_ENABLE = 1
+} gpio_pullup_t;
+typedef enum
+{
+    GPIO_PULLDOWN_DISABLE = 0,
+    GPIO_PULLDOWN_ENABLE = 1
+} gpio_pulldown_t;
+typedef enum
+{
+    GPIO_INTR_DISABLE = 0,
+    GPIO_INTR_POSEDGE = 1,
+    GPIO_INTR_NEGEDGE = 2,
+    GPIO_INTR_ANYEDGE = 3
+} gpio_int_type_t;
+typedef struct
+{
+    uint64_t pin_bit_mask;
+    gpio_mode_t mode;
+    gpio_pullup_t pull_up_en;
+    gpio_pulldown_t pull_down_en;
+    gpio_int_type_t intr_type;
+} gpio_config_t;
+#define GPIO_NUM_NC -1
+
+namespace HostSim
+{
+    struct GPIOISR
+    {
+        gpio_isr_t isrFn = nullptr;
+        void* arg = nullptr;
+    };
+    inline std::map<int, GPIOISR>& gpioISRs()
+    {
+        static std::map<int, GPIOISR> isrs;
+        return isrs;
+    }
+
+    // Call the interrupt handler for a pin (returns false if none)
+    inline bool triggerGPIOISR(int pin)
+    {
+        auto it = gpioISRs().find(pin);
+        if ((it == gpioISRs().end()) || !it->second.isrFn)
+            return false;
+        it->second.isrFn(it->second.arg);
+        return true;
+    }
+}
+
+inline esp_err_t gpio_config(const gpio_config_t* pConfig)
+{
+    return ESP_OK;
+}
+
+inline esp_err_t gpio_install_isr_service(int intrAllocFlags)
+{
+    return ESP_OK;
+}
+
+inline esp_err_t gpio_isr_handler_add(gpio_num_t gpioNum, gpio_isr_t isrHandler, void* arg)
+{
+    HostSim::gpioISRs()[gpioNum] = { isrHandler, arg };
+    return ESP_OK;
+}
+
+inline esp_err_t gpio_isr_handler_remove(gpio_num_t gpioNum)
+{
+    HostSim::gpioISRs().erase(gpioNum);
+    return ESP_OK;
+}
@@ -0,0 +1,169 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Host build shim for driver/gptimer.h
+// Up-counting timer on the simulated clock with a one-shot alarm (an alarm set at or before the current count
+// fires immediately as on the target) dispatched with the GPTimer ISR latency
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "HostSimTimers.h"
+
+typedef struct gptimer_t* gptimer_handle_t;
+typedef struct
+{
+    uint64_t count_value;
+    uint64_t alarm_value;
+} gptimer_alarm_event_data_t;
+typedef bool (*gptimer_alarm_cb_t)(gptimer_handle_t timer, const gptimer_alarm_event_data_t* pEventData, void* pUserCtx);
+typedef struct
+{
+    gptimer_alarm_cb_t on_alarm;
+} gptimer_event_callbacks_t;
+typedef enum
+{
+    GPTIMER_CLK_SRC_DEFAULT = 0
+} gptimer_clock_source_t;
+typedef enum
+{
+    GPTIMER_COUNT_DOWN = 0,
+    GPTIMER_COUNT_UP = 1
+} gptimer_count_direction_t;
+typedef struct
+{
+    gptimer_clock_source_t clk_src;
+    gptimer_count_direction_t direction;
+    uint32_t resolution_hz;
+    int intr_priority;
+    struct
+    {
+        uint32_t intr_shared : 1;
+        uint32_t allow_pd : 1;
+    } flags;
+} gptimer_config_t;
+typedef struct
+{
+    uint64_t alarm_count;
+    uint64_t reload_count;
+    struct
+    {
+        uint32_t auto_reload_on_alarm : 1;
+    } flags;
+} gptimer_alarm_config_t;
+
+struct gptimer_t
+{
+    HostSim::SimTimer* pSimTimer = nullptr;
+    uint64_t resolutionHz = 1000000;
+    uint64_t baseCount = 0;
+    uint64_t baseUs = 0;
+    bool running = false;
+    bool alarmSet = false;
+    uint64_t alarmCount = 0;
+    gptimer_alarm_cb_t onAlarm = nullptr;
+    void* pUserCtx = nullptr;
+
+    uint64_t getCount() const
+    {
+        if (!running)
+            return baseCount;
+        return baseCount + (HostSim::clockUs() - baseUs) * resolutionHz / 1000000;
+    }
+    void setCount(uint64_t count)
+    {
+        baseCount = count;
+        baseUs = HostSim::clockUs();
+        schedule();
+    }
+    void schedule()
+    {
+        pSimTimer->armed = running && alarmSet;
+        if (!pSimTimer->armed)
+            return;
+        uint64_t nowCount = getCount();
+        uint64_t ticksToAlarm = alarmCount > nowCount ? alarmCount - nowCount : 0;
+        pSimTimer->dueUs = HostSim::clockUs() + (ticksToAlarm * 1000000 + resolutionHz - 1) / resolutionHz;
+    }
+    void fire()
+    {
+        alarmSet = false;
+        gptimer_alarm_event_data_t eventData = { getCount(), alarmCount };
+        if (onAlarm)
+            onAlarm(this, &eventData, pUserCtx);
+    }
+};
+
+inline esp_err_t gptimer_new_timer(const gptimer_config_t* pConfig, gptimer_handle_t* pRetTimer)
+{
+    gptimer_t* pTimer = new gptimer_t();
+    pTimer->resolutionHz = pConfig->resolution_hz;
+    pTimer->pSimTimer = HostSim::addSimTimer([pTimer]() { pTimer->fire(); }, HostSim::gptimerLatencyUs());
+    *pRetTimer = pTimer;
+    return ESP_OK;
+}
+
+inline esp_err_t gptimer_del_timer(gptimer_handle_t timer)
+{
+    HostSim::removeSimTimer(timer->pSimTimer);
+    delete timer;
+    return ESP_OK;
+}
+
+inline esp_err_t gptimer_register_event_callbacks(gptimer_handle_t timer, const gptimer_event_callbacks_t* pCallbacks, void* pUserData)
+{
+    timer->onAlarm = pCallbacks->on_alarm;
+    timer->pUserCtx = pUserData;
+    return ESP_OK;
+}
+
+inline esp_err_t gptimer_enable(gptimer_handle_t timer)
+{
+    return ESP_OK;
+}
+
+inline esp_err_t gptimer_disable(gptimer_handle_t timer)
+{
+    return ESP_OK;
+}
+
+inline esp_err_t gptimer_start(gptimer_handle_t timer)
+{
+    timer->baseUs = HostSim::clockUs();
+    timer->running = true;
+    timer->schedule();
+    return ESP_OK;
+}
+
+inline esp_err_t gptimer_stop(gptimer_handle_t timer)
+{
+    timer->baseCount = timer->getCount();
+    timer->running = false;
+    timer->schedule();
+    return ESP_OK;
+}
+
+inline esp_err_t gptimer_set_raw_count(gptimer_handle_t timer, uint64_t value)
+{
+    timer->setCount(value);
+    return ESP_OK;
+}
+
+inline esp_err_t gptimer_get_raw_count(gptimer_handle_t timer, uint64_t* pValue)
+{
+    *pValue = timer->getCount();
+    return ESP_OK;
+}
+
+inline esp_err_t gptimer_set_alarm_action(gptimer_handle_t timer, const gptimer_alarm_config_t* pConfig)
+{
+    timer->alarmSet = pConfig != nullptr;
+    if (pConfig)
+        timer->alarmCount = pConfig->alarm_count;
+    timer->schedule();
+    return ESP_OK;
+}
@@ -0,0 +1,150 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Host build shim for driver/spi_master.h
+// Each transfer moves the simulated clock on by the frame time plus the polling transmit overhead and the frame
+// is then passed (with the device's CS pin) to a hook set by the host tool - i.e. at the time CS is released
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "RaftArduino.h"
+
+typedef enum
+{
+    SPI1_HOST = 0,
+    SPI2_HOST = 1,
+    SPI3_HOST = 2
+} spi_host_device_t;
+#ifndef GPIO_NUM_NC
+#define GPIO_NUM_NC -1
+#endif
+#define SPI_DMA_DISABLED 0
+#define ESP_INTR_CPU_AFFINITY_AUTO 0
+#define SPI_CLK_SRC_DEFAULT 0
+#define SPI_SAMPLING_POINT_PHASE_0 0
+#define SPI_DEVICE_NO_DUMMY (1 << 6)
+#define SPI_TRANS_USE_TXDATA (1 << 3)
+
+typedef struct
+{
+    int mosi_io_num;
+    int miso_io_num;
+    int sclk_io_num;
+    int quadwp_io_num;
+    int quadhd_io_num;
+    int data4_io_num;
+    int data5_io_num;
+    int data6_io_num;
+    int data7_io_num;
+    bool data_io_default_level;
+    int max_transfer_sz;
+    uint32_t flags;
+    int isr_cpu_id;
+    int intr_flags;
+} spi_bus_config_t;
+
+typedef struct
+{
+    uint8_t command_bits;
+    uint8_t address_bits;
+    uint8_t dummy_bits;
+    uint8_t mode;
+    int clock_source;
+    uint16_t duty_cycle_pos;
+    uint16_t cs_ena_pretrans;
+    uint8_t cs_ena_posttrans;
+    int clock_speed_hz;
+    int input_delay_ns;
+    int sample_point;
+    int spics_io_num;
+    uint32_t flags;
+    int queue_size;
+    void* pre_cb;
+    void* post_cb;
+} spi_device_interface_config_t;
+
+typedef struct
+{
+    uint32_t flags;
+    uint16_t cmd;
+    uint64_t addr;
+    size_t length;
+    size_t rxlength;
+    void* user;
+    const void* tx_buffer;
+    void* rx_buffer;
+    uint8_t tx_data[4];
+    uint8_t rx_data[4];
+} spi_transaction_t;
+
+struct spi_device_t
+{
+    int csPin = -1;
+    int clockHz = 1000000;
+};
+typedef spi_device_t* spi_device_handle_t;
+
+namespace HostSim
+{
+    typedef void (*SPITxFn)(int csPin, const uint8_t* pData, uint32_t numBits);
+    inline SPITxFn& spiTxFn()
+    {
+        static SPITxFn fn = nullptr;
+        return fn;
+    }
+    inline uint32_t& spiTxOverheadUs()
+    {
+        static uint32_t overheadUs = 0;
+        return overheadUs;
+    }
+    inline bool& spiBusInitialised()
+    {
+        static bool isInit = false;
+        return isInit;
+    }
+}
+
+inline esp_err_t spi_bus_initialize(spi_host_device_t hostId, const spi_bus_config_t* pBusConfig, int dmaChan)
+{
+    if (HostSim::spiBusInitialised())
+        return ESP_ERR_INVALID_STATE;
+    HostSim::spiBusInitialised() = true;
+    return ESP_OK;
+}
+
+inline esp_err_t spi_bus_free(spi_host_device_t hostId)
+{
+    HostSim::spiBusInitialised() = false;
+    return ESP_OK;
+}
+
+inline esp_err_t spi_bus_add_device(spi_host_device_t hostId, const spi_device_interface_config_t* pDevConfig,
+            spi_device_handle_t* pHandle)
+{
+    spi_device_t* pDev = new spi_device_t();
+    pDev->csPin = pDevConfig->spics_io_num;
+    pDev->clockHz = pDevConfig->clock_speed_hz > 0 ? pDevConfig->clock_speed_hz : 1000000;
+    *pHandle = pDev;
+    return ESP_OK;
+}
+
+inline esp_err_t spi_bus_remove_device(spi_device_handle_t handle)
+{
+    delete handle;
+    return ESP_OK;
+}
+
+inline esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t* pTrans)
+{
+    const uint8_t* pData = (pTrans->flags & SPI_TRANS_USE_TXDATA) ? pTrans->tx_data : (const uint8_t*)pTrans->tx_buffer;
+    HostSim::advanceUs(HostSim::spiTxOverheadUs() + uint64_t(pTrans->length) * 1000000 / handle->clockHz);
+    if (HostSim::spiTxFn())
+        HostSim::spiTxFn()(handle->csPin, pData, pTrans->length);
+    return ESP_OK;
+}
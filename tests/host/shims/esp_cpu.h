@@ -0,0 +1,29 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Host build shim for esp_cpu.h
+// The cycle count advances on each read and moves the simulated clock at the esp_rom_get_cpu_ticks_per_us() rate
+// so cycle count waits (e.g. register bit-banged SPI) take simulated time
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include "RaftArduino.h"
+#include "esp_rom_sys.h"
+
+inline uint32_t esp_cpu_get_cycle_count()
+{
+    static uint32_t cycleCount = 0;
+    static uint32_t cyclesInUs = 0;
+    cycleCount += 8;
+    cyclesInUs += 8;
+    if (cyclesInUs >= esp_rom_get_cpu_ticks_per_us())
+    {
+        cyclesInUs -= esp_rom_get_cpu_ticks_per_us();
+        HostSim::advanceUs(1);
+    }
+    return cycleCount;
+}
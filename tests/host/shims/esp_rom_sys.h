@@ -0,0 +1,16 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Host build shim for esp_rom_sys.h
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+inline uint32_t esp_rom_get_cpu_ticks_per_us()
+{
+    return 240;
+}
@@ -0,0 +1,69 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Host build shim for esp_timer.h
+// One-shot timers run on the simulated clock (see HostSimTimers.h) with the esp_timer dispatch latency
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_attr.h"
+#include "HostSimTimers.h"
+
+typedef void (*esp_timer_cb_t)(void* arg);
+typedef HostSim::SimTimer* esp_timer_handle_t;
+typedef enum
+{
+    ESP_TIMER_TASK,
+    ESP_TIMER_ISR
+} esp_timer_dispatch_t;
+typedef struct
+{
+    esp_timer_cb_t callback;
+    void* arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char* name;
+    bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+inline int64_t esp_timer_get_time()
+{
+    return HostSim::clockUs();
+}
+
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t* pArgs, esp_timer_handle_t* pHandle)
+{
+    esp_timer_cb_t callback = pArgs->callback;
+    void* arg = pArgs->arg;
+    *pHandle = HostSim::addSimTimer([callback, arg]() { callback(arg); }, HostSim::espTimerLatencyUs());
+    return ESP_OK;
+}
+
+inline esp_err_t esp_timer_start_once(esp_timer_handle_t handle, uint64_t timeoutUs)
+{
+    if (!handle)
+        return ESP_ERR_INVALID_ARG;
+    if (handle->armed)
+        return ESP_ERR_INVALID_STATE;
+    handle->dueUs = HostSim::clockUs() + timeoutUs;
+    handle->armed = true;
+    return ESP_OK;
+}
+
+inline esp_err_t esp_timer_stop(esp_timer_handle_t handle)
+{
+    if (!handle || !handle->armed)
+        return ESP_ERR_INVALID_STATE;
+    handle->armed = false;
+    return ESP_OK;
+}
+
+inline esp_err_t esp_timer_delete(esp_timer_handle_t handle)
+{
+    HostSim::removeSimTimer(handle);
+    return ESP_OK;
+}
@@ -0,0 +1,22 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Host build shim for freertos/FreeRTOS.h
+// The simulation is single threaded so critical sections are no-ops
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+typedef struct
+{
+    int owner;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+#define portENTER_CRITICAL(pMux) (void)(pMux)
+#define portEXIT_CRITICAL(pMux) (void)(pMux)
+#define portENTER_CRITICAL_ISR(pMux) (void)(pMux)
+#define portEXIT_CRITICAL_ISR(pMux) (void)(pMux)
+#define portENTER_CRITICAL_SAFE(pMux) (void)(pMux)
+#define portEXIT_CRITICAL_SAFE(pMux) (void)(pMux)
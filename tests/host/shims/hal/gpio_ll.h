@@ -0,0 +1,34 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Host build shim for hal/gpio_ll.h
+// Register level writes go to the same simulated GPIO hook as digitalWrite
+//
+// Rob Dobson 2026
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include "RaftArduino.h"
+
+typedef struct
+{
+    uint32_t unused;
+} gpio_dev_t;
+#define GPIO_PORT_0 0
+#define GPIO_LL_GET_HW(port) (&HostSim::gpioDev())
+
+namespace HostSim
+{
+    inline gpio_dev_t& gpioDev()
+    {
+        static gpio_dev_t dev = {};
+        return dev;
+    }
+}
+
+inline void gpio_ll_set_level(gpio_dev_t* pHW, uint32_t gpioNum, uint32_t level)
+{
+    digitalWrite(gpioNum, level);
+}